@@ -48,7 +48,7 @@ AccelerometerChain::AccelerometerChain(const QString& id) :
     Q_ASSERT( accelerometerAdaptor_ );
     setValid(accelerometerAdaptor_->isValid());
 
-    accelerometerReader_ = new BufferReader<AccelerationData>(1);
+    accelerometerReader_ = new BufferReader<AccelerationData>(16);
 
     // Get the transformation matrix from config file
     QString aconvString = Config::configuration()->value<QString>("accelerometer/transformation_matrix", "");
@@ -64,7 +64,7 @@ AccelerometerChain::AccelerometerChain(const QString& id) :
     Q_ASSERT(accCoordinateAlignFilter_);
     ((CoordinateAlignFilter*)accCoordinateAlignFilter_)->setMatrix(TMatrix(aconv_));
 
-    outputBuffer_ = new RingBuffer<AccelerationData>(1);
+    outputBuffer_ = new RingBuffer<AccelerationData>(16);
     nameOutputBuffer("accelerometer", outputBuffer_);
 
     // Create buffers for filter chain
@@ -106,6 +106,7 @@ AccelerometerChain::~AccelerometerChain()
 
 bool AccelerometerChain::start()
 {
+    ChainExecutor::Pause pause(processingExecutors());
     if (AbstractSensorChannel::start()) {
         sensordLogD() << "Starting AccelerometerChain";
         filterBin_->start();
@@ -116,6 +117,7 @@ bool AccelerometerChain::start()
 
 bool AccelerometerChain::stop()
 {
+    ChainExecutor::Pause pause(processingExecutors());
     if (AbstractSensorChannel::stop()) {
         sensordLogD() << "Stopping AccelerometerChain";
         accelerometerAdaptor_->stopSensor();
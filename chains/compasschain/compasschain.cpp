@@ -53,7 +53,7 @@ CompassChain::CompassChain(const QString& id) :
     if (hasOrientationAdaptor) {
         setValid(orientAdaptor->isValid());
         if (orientAdaptor->isValid())
-            orientationdataReader = new BufferReader<CompassData>(1);
+            orientationdataReader = new BufferReader<CompassData>(16);
 
         orientationFilter = sm.instantiateFilter("orientationfilter");
         Q_ASSERT(orientationFilter);
@@ -69,9 +69,9 @@ CompassChain::CompassChain(const QString& id) :
         Q_ASSERT(accelerometerChain);
         setValid(accelerometerChain->isValid());
 
-        accelerometerReader = new BufferReader<AccelerationData>(1);
+        accelerometerReader = new BufferReader<AccelerationData>(16);
 
-        magReader = new BufferReader<CalibratedMagneticFieldData>(1);
+        magReader = new BufferReader<CalibratedMagneticFieldData>(16);
 
         compassFilter = sm.instantiateFilter("compassfilter");
         Q_ASSERT(compassFilter);
@@ -86,10 +86,10 @@ CompassChain::CompassChain(const QString& id) :
         Q_ASSERT(avgaccFilter);
     }
 
-    trueNorthBuffer = new RingBuffer<CompassData>(1);
+    trueNorthBuffer = new RingBuffer<CompassData>(16);
     nameOutputBuffer("truenorth", trueNorthBuffer); //
 
-    magneticNorthBuffer = new RingBuffer<CompassData>(1);
+    magneticNorthBuffer = new RingBuffer<CompassData>(16);
     nameOutputBuffer("magneticnorth", magneticNorthBuffer); //
 
     // Create buffers for filter chain
@@ -205,6 +205,7 @@ CompassChain::~CompassChain()
 
 bool CompassChain::start()
 {
+    ChainExecutor::Pause pause(processingExecutors());
     if (AbstractSensorChannel::start()) {
         sensordLogD() << "Starting compassChain" << hasOrientationAdaptor;
         filterBin->start();
@@ -222,6 +223,7 @@ bool CompassChain::start()
 
 bool CompassChain::stop()
 {
+    ChainExecutor::Pause pause(processingExecutors());
     bool isStopped = AbstractSensorChannel::stop();
     if (isStopped) {
         if (hasOrientationAdaptor) {
@@ -25,6 +25,7 @@
 #include "ringbuffer.h"
 #include "orientationdata.h"
 #include "filter.h"
+#include "orientationmath.h"
 
 class CompassFilter : public QObject, public FilterBase
 {
@@ -48,6 +49,7 @@ private:
 
     void magDataAvailable(unsigned, const CalibratedMagneticFieldData*);
     void accelDataAvailable(unsigned, const AccelerationData*);
+    void computeHeading(const AccelerationData *data, CompassData& compassData);
 
     CalibratedMagneticFieldData magData;
 
@@ -60,6 +62,7 @@ private:
 
     int level;
     int oldHeading;
+    OrientationMath::Precision precision_;
     QList <int> averagingBuffer;
     QList <const CalibratedMagneticFieldData *> magAvgBuffer;
     QList <const AccelerationData *> accelAvgBuffer;
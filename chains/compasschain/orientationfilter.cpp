@@ -18,6 +18,7 @@
    License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include <QDebug>
+#include <QVarLengthArray>
 #include "orientationfilter.h"
 #include "config.h"
 
@@ -28,11 +29,16 @@ OrientationFilter::OrientationFilter()
     addSource(&magSource, "magnorthangle");
 }
 
-void OrientationFilter::orientDataAvailable(unsigned, const CompassData *data)
+void OrientationFilter::orientDataAvailable(unsigned n, const CompassData *data)
 {
-    compassData.timestamp_ = data->timestamp_;
-    compassData.degrees_ =  data->degrees_;
-    compassData.rawDegrees_ = data->rawDegrees_;
-    compassData.level_ = data->level_;
-    magSource.propagate(1, &compassData);
+    QVarLengthArray<CompassData, BATCH_SIZE> output(n);
+
+    for (unsigned i = 0; i < n; ++i) {
+        compassData.timestamp_ = data[i].timestamp_;
+        compassData.degrees_ =  data[i].degrees_;
+        compassData.rawDegrees_ = data[i].rawDegrees_;
+        compassData.level_ = data[i].level_;
+        output[i] = compassData;
+    }
+    magSource.propagate(n, output.constData());
 }
@@ -25,6 +25,7 @@
 #include "sensormanager.h"
 #include <QFile>
 #include <QTextStream>
+#include <QVarLengthArray>
 /*
  * I've left in routines to grab calibrated and uncalibrated data
  * in order to use data plotting to visualize calibrations.
@@ -69,7 +70,20 @@ CalibrationFilter::CalibrationFilter() :
 #endif
 }
 
-void CalibrationFilter::magDataAvailable(unsigned, const CalibratedMagneticFieldData *data)
+void CalibrationFilter::magDataAvailable(unsigned n, const CalibratedMagneticFieldData *data)
+{
+    QVarLengthArray<CalibratedMagneticFieldData, BATCH_SIZE> output(n);
+
+    for (unsigned i = 0; i < n; ++i) {
+        calibrate(&data[i]);
+        output[i] = transformed;
+    }
+
+    magSource.propagate(n, output.constData());
+    source_.propagate(n, output.constData());
+}
+
+void CalibrationFilter::calibrate(const CalibratedMagneticFieldData *data)
 {
     transformed.timestamp_ = data->timestamp_;
     transformed.x_ = data->rx_;
@@ -160,9 +174,6 @@ void CalibrationFilter::magDataAvailable(unsigned, const CalibratedMagneticField
     transformed.rx_ = data->rx_;
     transformed.ry_ = data->ry_;
     transformed.rz_ = data->rz_;
-
-    magSource.propagate(1, &transformed);
-    source_.propagate(1, &transformed);
 }
 
 void CalibrationFilter::dropCalibration()
@@ -49,6 +49,7 @@ private:
 
     Source<CalibratedMagneticFieldData> magSource;
     void magDataAvailable(unsigned, const CalibratedMagneticFieldData * );
+    void calibrate(const CalibratedMagneticFieldData *data);
 
     CalibratedMagneticFieldData magData;
     CalibratedMagneticFieldData transformed;
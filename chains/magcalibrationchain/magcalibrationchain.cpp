@@ -56,13 +56,13 @@ MagCalibrationChain::MagCalibrationChain(const QString& id) :
 
     needsCalibration = Config::configuration()->value<bool>("magnetometer/needs_calibration", true);
 
-    calibratedMagnetometerData = new RingBuffer<CalibratedMagneticFieldData>(1);
+    calibratedMagnetometerData = new RingBuffer<CalibratedMagneticFieldData>(16);
     nameOutputBuffer("calibratedmagnetometerdata", calibratedMagnetometerData);
 
     // Create buffers for filter chain
     filterBin = new Bin;
     //formationsink
-    magReader = new BufferReader<CalibratedMagneticFieldData>(1);
+    magReader = new BufferReader<CalibratedMagneticFieldData>(16);
 
     // Join filterchain buffers
     filterBin->add(magReader, "calibratedmagneticfield");
@@ -128,6 +128,7 @@ MagCalibrationChain::~MagCalibrationChain()
 
 bool MagCalibrationChain::start()
 {
+    ChainExecutor::Pause pause(processingExecutors());
     if (AbstractSensorChannel::start()) {
         sensordLogD() << "Starting MagCalibrationChain";
         filterBin->start();
@@ -138,6 +139,7 @@ bool MagCalibrationChain::start()
 
 bool MagCalibrationChain::stop()
 {
+    ChainExecutor::Pause pause(processingExecutors());
     if (AbstractSensorChannel::stop()) {
         sensordLogD() << "Stopping MagCalibrationChain";
         magAdaptor->stopSensor();
@@ -148,6 +150,7 @@ bool MagCalibrationChain::stop()
 
 void MagCalibrationChain::resetCalibration()
 {
+    ChainExecutor::Pause pause(processingExecutors());
    if (needsCalibration) {
        CalibrationFilter *filter = static_cast<CalibrationFilter *>(magCalFilter);
     filter->dropCalibration();
@@ -37,17 +37,17 @@ OrientationChain::OrientationChain(const QString& id) :
     Q_ASSERT( accelerometerChain_ );
     setValid(accelerometerChain_->isValid());
 
-    accelerometerReader_ = new BufferReader<AccelerationData>(1);
+    accelerometerReader_ = new BufferReader<AccelerationData>(16);
 
     orientationInterpreterFilter_ = sm.instantiateFilter("orientationinterpreter");
 
-    topEdgeOutput_ = new RingBuffer<PoseData>(1);
+    topEdgeOutput_ = new RingBuffer<PoseData>(16);
     nameOutputBuffer("topedge", topEdgeOutput_);
 
-    faceOutput_ = new RingBuffer<PoseData>(1);
+    faceOutput_ = new RingBuffer<PoseData>(16);
     nameOutputBuffer("face", faceOutput_);
 
-    orientationOutput_ = new RingBuffer<PoseData>(1);
+    orientationOutput_ = new RingBuffer<PoseData>(16);
     nameOutputBuffer("orientation", orientationOutput_);
 
     // Create buffers for filter chain
@@ -92,6 +92,7 @@ OrientationChain::~OrientationChain()
 
 bool OrientationChain::start()
 {
+    ChainExecutor::Pause pause(processingExecutors());
     if (AbstractSensorChannel::start()) {
         sensordLogD() << "Starting AccelerometerChain";
         filterBin_->start();
@@ -102,6 +103,7 @@ bool OrientationChain::start()
 
 bool OrientationChain::stop()
 {
+    ChainExecutor::Pause pause(processingExecutors());
     if (AbstractSensorChannel::stop()) {
         sensordLogD() << "Stopping AccelerometerChain";
         accelerometerChain_->stop();
@@ -29,6 +29,11 @@ profile-libc {
   QMAKE_LFLAGS += -lc_p
 }
 
+# Per-stage sample latency tracing, see core/latencytrace.h
+latencytrace {
+  DEFINES += SENSORFW_LATENCY_TRACE
+}
+
 equals(QT_MAJOR_VERSION, 5):{
     TARGET = $$TARGET-qt5
 }
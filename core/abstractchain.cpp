@@ -24,15 +24,20 @@
  */
 
 #include "abstractchain.h"
+#include "chainexecutor.h"
 
 AbstractChain::AbstractChain(const QString& id, bool deleteBuffers) :
     AbstractSensorChannel(id),
-    deleteBuffers_(deleteBuffers)
+    deleteBuffers_(deleteBuffers),
+    executor_(NULL)
 {
+    if (ChainExecutor::policy(this->id()) == ChainExecutor::Worker)
+        executor_ = new ChainExecutor(this->id());
 }
 
 AbstractChain::~AbstractChain()
 {
+    delete executor_;
     if(deleteBuffers_)
     {
         foreach(RingBufferBase* buffer, outputBufferMap_.values())
@@ -59,3 +64,8 @@ const QMap<QString, RingBufferBase*>& AbstractChain::buffers() const
 {
     return outputBufferMap_;
 }
+
+ChainExecutor* AbstractChain::executor() const
+{
+    return executor_;
+}
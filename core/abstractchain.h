@@ -69,6 +69,13 @@ public:
      */
     const QMap<QString, RingBufferBase*>& buffers() const;
 
+    /**
+     * Executor running this chain on the worker pool.
+     *
+     * @return executor, NULL if the chain runs inline.
+     */
+    virtual ChainExecutor* executor() const;
+
 protected:
     /**
      * Constructor.
@@ -90,6 +97,7 @@ protected:
 private:
     QMap<QString, RingBufferBase*> outputBufferMap_; /**< buffers */
     const bool deleteBuffers_; /**< are buffers deleted automatically */
+    ChainExecutor* executor_; /**< worker executor, NULL if chain runs inline */
 };
 
 /**
@@ -31,16 +31,30 @@
 #include "abstractsensor.h"
 #include "sensormanager.h"
 #include "sockethandler.h"
+#include "sharedsamplebuffer.h"
+#include "chainexecutor.h"
+#include "latestvaluepublisher.h"
+#include "latestvaluepage.h"
 #include "idutils.h"
+#include "latencytrace.h"
 #include "logging.h"
 
 AbstractSensorChannel::AbstractSensorChannel(const QString& id) :
     NodeBase(getCleanId(id)),
     errorCode_(SNoError),
-    cnt_(0)
+    cnt_(0),
+    sharedBuffer_(NULL),
+    latestEnabled_(false),
+    latestSlot_(-1),
+    latestWriter_(NULL)
 {
 }
 
+AbstractSensorChannel::~AbstractSensorChannel()
+{
+    delete sharedBuffer_.loadAcquire();
+}
+
 void AbstractSensorChannel::setError(SensorError errorCode, const QString& errorString)
 {
     sensordLogC() << "SensorError: " <<  errorString;
@@ -53,10 +67,19 @@ void AbstractSensorChannel::setError(SensorError errorCode, const QString& error
 
 bool AbstractSensorChannel::start(int sessionId)
 {
+    ChainExecutor::Pause pause(processingExecutors());
     if(!activeSessions_.contains(sessionId))
     {
-        activeSessions_.insert(sessionId);
-        requestDefaultInterval(sessionId);
+        int route = SensorManager::instance().socketHandler().addSession(sessionId);
+        SharedSampleBuffer* buffer = sharedBuffer_.loadAcquire();
+        if(buffer && buffer->hasSession(sessionId))
+            route = SHARED_ROUTE;
+        else if(route < 0)
+            sensordLogW() << "No route for session " << sessionId << ", samples will not be delivered";
+        activeSessions_.insert(sessionId, route);
+        // Keep an interval the session requested before starting.
+        if(!getInterval(sessionId))
+            requestDefaultInterval(sessionId);
         return start();
     }
     return false;
@@ -69,6 +92,7 @@ bool AbstractSensorChannel::start()
 
 bool AbstractSensorChannel::stop(int sessionId)
 {
+    ChainExecutor::Pause pause(processingExecutors());
     if(activeSessions_.remove(sessionId))
     {
         removeSession(sessionId); //Note: when client restarts the session it is responsible to reconfiguring the sensor.
@@ -86,159 +110,94 @@ bool AbstractSensorChannel::stop()
     return false;
 }
 
-bool AbstractSensorChannel::writeToSession(int sessionId, const void* source, int size)
+bool AbstractSensorChannel::startSharedTransport(int sessionId, int& ringFd, int& notifyFd)
 {
-    if (!(SensorManager::instance().write(sessionId, source, size))) {
-        sensordLogD() << "AbstractSensor failed to write to session " << sessionId;
-        return false;
+    SharedSampleBuffer* buffer = sharedBuffer_.loadAcquire();
+    if (!buffer) {
+        buffer = new SharedSampleBuffer();
+        if (!buffer->isValid()) {
+            delete buffer;
+            return false;
+        }
+        sharedBuffer_.storeRelease(buffer);
     }
+    if (!buffer->addSession(sessionId, notifyFd))
+        return false;
+
+    ChainExecutor::Pause pause(processingExecutors());
+    QHash<int, int>::iterator it = activeSessions_.find(sessionId);
+    if (it != activeSessions_.end())
+        *it = SHARED_ROUTE;
+    ringFd = buffer->readFd();
     return true;
 }
 
-bool AbstractSensorChannel::writeToClients(const void* source, int size)
+void AbstractSensorChannel::enableLatestValue()
 {
-    bool ret = true;
-    foreach(int sessionId, activeSessions_) {
-        ret &= writeToSession(sessionId, source, size);
-    }
-    return ret;
+    latestEnabled_ = true;
 }
 
-bool AbstractSensorChannel::downsampleAndPropagate(const TimedXyzData& data, TimedXyzDownsampleBuffer& buffer)
+bool AbstractSensorChannel::writeToSharedSessions(const void* source, int size)
 {
-    bool ret = true;
-    unsigned int currentInterval = getInterval();
-    foreach(int sessionId, activeSessions_)
-    {
-        if(!downsamplingEnabled(sessionId))
-        {
-            ret &= writeToSession(sessionId, (const void *)& data, sizeof(TimedXyzData));
-            continue;
-        }
-        unsigned int sessionInterval = getInterval(sessionId);
-        int bufferSize = (sessionInterval < currentInterval || !currentInterval) ? 1 : sessionInterval / currentInterval;
-
-        QList<TimedXyzData>& samples(buffer[sessionId]);
-        samples.push_back(data);
-
-        for(QList<TimedXyzData>::iterator it = samples.begin(); it != samples.end(); ++it)
-        {
-            if(samples.size() > bufferSize ||
-               data.timestamp_ - it->timestamp_ > 2000000)
-            {
-                it = samples.erase(it);
-                if(it == samples.end())
-                    break;
-            }
-            else
-                break;
-        }
-
-        if(samples.size() < bufferSize)
-            continue;
-
-        long x = 0;
-        long y = 0;
-        long z = 0;
-        foreach(const TimedXyzData& data, samples)
-        {
-            x += data.x_;
-            y += data.y_;
-            z += data.z_;
-        }
-        TimedXyzData downsampled(data.timestamp_,
-                                 x / samples.count(),
-                                 y / samples.count(),
-                                 z / samples.count());
-
-        if (writeToSession(sessionId, (const void*)& downsampled, sizeof(TimedXyzData)))
-        {
-            samples.clear();
-        }
-        else
-        {
-            ret = false;
+    if (latestEnabled_) {
+        if (!latestWriter_) {
+            latestWriter_ = LatestValuePublisher::addChannel(id(), latestSlot_);
+            latestEnabled_ = latestWriter_ != NULL;
         }
+        if (latestWriter_)
+            latestWriter_->write(latestSlot_, source, size);
     }
-
-    return ret;
+    SharedSampleBuffer* buffer = sharedBuffer_.loadAcquire();
+    return buffer ? buffer->write(source, size) : true;
 }
 
-bool AbstractSensorChannel::downsampleAndPropagate(const CalibratedMagneticFieldData& data, MagneticFieldDownsampleBuffer& buffer)
+bool AbstractSensorChannel::writeToSession(int sessionId, int route, const void* source, int size)
 {
-    bool ret = true;
-    unsigned int currentInterval = getInterval();
-    foreach(int sessionId, activeSessions_)
-    {
-        if(!downsamplingEnabled(sessionId))
-        {
-            ret &= writeToSession(sessionId, (const void *)& data, sizeof(CalibratedMagneticFieldData));
-            continue;
-        }
-        unsigned int sessionInterval = getInterval(sessionId);
-        int bufferSize = (sessionInterval < currentInterval || !currentInterval) ? 1 : sessionInterval / currentInterval;
-
-        QList<CalibratedMagneticFieldData>& samples(buffer[sessionId]);
-        samples.push_back(data);
-
-        for(QList<CalibratedMagneticFieldData>::iterator it = samples.begin(); it != samples.end(); ++it)
-        {
-            if(samples.size() > bufferSize ||
-               data.timestamp_ - it->timestamp_ > 2000000)
-            {
-                it = samples.erase(it);
-                if(it == samples.end())
-                    break;
-            }
-            else
-                break;
-        }
+    SENSORFW_TRACE_PAYLOAD(WriteToSession, sessionId, source, size, 1);
+    if (route == SHARED_ROUTE)
+        return true;
+    if (!(SensorManager::instance().write(route, source, size))) {
+        sensordLogD() << "AbstractSensor failed to write to session " << sessionId;
+        return false;
+    }
+    return true;
+}
 
-        if(samples.size() < bufferSize)
-            continue;
-
-        long x = 0;
-        long y = 0;
-        long z = 0;
-        long rx = 0;
-        long ry = 0;
-        long rz = 0;
-        foreach(const CalibratedMagneticFieldData& data, samples)
-        {
-            x += data.x_;
-            y += data.y_;
-            z += data.z_;
-            rx += data.rx_;
-            ry += data.ry_;
-            rz += data.rz_;
-        }
-        CalibratedMagneticFieldData downsampled(data.timestamp_,
-                                                x / samples.count(),
-                                                y / samples.count(),
-                                                z / samples.count(),
-                                                rx / samples.count(),
-                                                ry / samples.count(),
-                                                rz / samples.count(),
-                                                data.level_);
-
-        if (writeToSession(sessionId, (const void*)& downsampled, sizeof(CalibratedMagneticFieldData)))
-        {
-            samples.clear();
-        }
-        else
-        {
-            ret = false;
-        }
+void AbstractSensorChannel::addToFanOut(SessionList& sessions, int sessionId, int route, const void* source, int size)
+{
+    SENSORFW_TRACE_PAYLOAD(WriteToSession, sessionId, source, size, 1);
+    Q_UNUSED(source);
+    Q_UNUSED(size);
+    sessions.append(route);
+}
 
+bool AbstractSensorChannel::writeFanOut(const SessionList& sessions, const void* source, int size)
+{
+    if (sessions.isEmpty())
+        return true;
+    if (!(SensorManager::instance().write(sessions.constData(), sessions.size(), source, size))) {
+        sensordLogD() << "AbstractSensor failed to write to " << sessions.size() << " session(s)";
+        return false;
     }
-    return ret;
+    return true;
 }
 
+bool AbstractSensorChannel::writeToClients(const void* source, int size)
+{
+    bool ret = writeToSharedSessions(source, size);
+    SessionList sessions;
+    for(QHash<int, int>::const_iterator it = activeSessions_.constBegin(); it != activeSessions_.constEnd(); ++it) {
+        if(it.value() != SHARED_ROUTE)
+            addToFanOut(sessions, it.key(), it.value(), source, size);
+    }
+    return writeFanOut(sessions, source, size) && ret;
+}
 
 void AbstractSensorChannel::setDownsamplingEnabled(int sessionId, bool value)
 {
     if(downsamplingSupported())
     {
+        ChainExecutor::Pause pause(processingExecutors());
         sensordLogT() << "Downsampling state for session " << sessionId << ": " << value;
         downsampling_[sessionId] = value;
     }
@@ -248,7 +207,7 @@ bool AbstractSensorChannel::downsamplingEnabled(int sessionId) const
 {
     QMap<int, bool>::const_iterator it(downsampling_.find(sessionId));
     if(it == downsampling_.end())
-        return downsamplingSupported();
+        return downsamplingSupported() && downsamplingDefault();
     return it.value() && getInterval(sessionId);
 }
 
@@ -257,9 +216,18 @@ bool AbstractSensorChannel::downsamplingSupported() const
     return false;
 }
 
+bool AbstractSensorChannel::downsamplingDefault() const
+{
+    return downsamplingSupported();
+}
+
 void AbstractSensorChannel::removeSession(int sessionId)
 {
+    ChainExecutor::Pause pause(processingExecutors());
     downsampling_.take(sessionId);
+    SharedSampleBuffer* buffer = sharedBuffer_.loadAcquire();
+    if (buffer)
+        buffer->removeSession(sessionId);
     NodeBase::removeSession(sessionId);
 }
 
@@ -35,6 +35,9 @@
 #include <QMap>
 #include <QList>
 #include <QSet>
+#include <QHash>
+#include <QAtomicPointer>
+#include <QVarLengthArray>
 
 #include "nodebase.h"
 #include "logging.h"
@@ -42,6 +45,10 @@
 #include "datarange.h"
 #include "genericdata.h"
 #include "orientationdata.h"
+#include "sessiondecimator.h"
+
+class SharedSampleBuffer;
+class LatestValuePageWriter;
 
 /**
  * Base class for sensor type specific nodes. This is used as base class
@@ -61,7 +68,7 @@ public:
     /**
      * Destructor.
      */
-    virtual ~AbstractSensorChannel() {}
+    virtual ~AbstractSensorChannel();
 
     /**
      * Last occured error.
@@ -115,8 +122,39 @@ public:
      */
     virtual bool downsamplingSupported() const;
 
+    /**
+     * Is downsampling enabled for sessions which have not set it
+     * explicitly. Defaults to #downsamplingSupported().
+     *
+     * @return default downsampling state.
+     */
+    virtual bool downsamplingDefault() const;
+
     virtual void removeSession(int sessionId);
 
+    /**
+     * Deliver data of given session through shared memory instead of
+     * the session socket. Channel output is published once into a
+     * shared ring and each client is woken up through its own eventfd.
+     * Per-session interval, buffering and downsampling are not applied
+     * to shared sessions.
+     *
+     * @param sessionId session ID.
+     * @param ringFd set to sealed, read-only mappable descriptor of the
+     *               shared ring.
+     * @param notifyFd set to eventfd of the session, signalled for new
+     *                 samples.
+     * @return was shared transport set up.
+     */
+    bool startSharedTransport(int sessionId, int& ringFd, int& notifyFd);
+
+    /**
+     * Publish output of this channel in the latest value page. Only
+     * enabled for channels visible to clients, the slot is allocated
+     * when the first sample is published.
+     */
+    void enableLatestValue();
+
     /**
      * Start data flow. Base class implementation is responsible for
      * reference counting. Which each subclass is responsible of calling.
@@ -168,10 +206,13 @@ Q_SIGNALS:
 
 protected:
     /** Sample buffer type for TimedXyzData downsampling. */
-    typedef QMap<int, QList<TimedXyzData> > TimedXyzDownsampleBuffer;
+    typedef SessionDecimator<TimedXyzData> TimedXyzDownsampleBuffer;
 
     /** Sample buffer type for CalibratedMagneticFieldData downsampling. */
-    typedef QMap<int, QList<CalibratedMagneticFieldData> > MagneticFieldDownsampleBuffer;
+    typedef SessionDecimator<CalibratedMagneticFieldData> MagneticFieldDownsampleBuffer;
+
+    /** Sample buffer type for CompassData downsampling. */
+    typedef SessionDecimator<CompassData> CompassDownsampleBuffer;
 
     /**
      * Constructor.
@@ -203,22 +244,16 @@ protected:
     bool writeToClients(const void* source, int size);
 
     /**
-     * Downsample and propagate data to all connected sessions.
-     *
-     * @param data Object to handle.
-     * @param buffer Data buffer.
-     * @return was data succesfully handled.
-     */
-    bool downsampleAndPropagate(const TimedXyzData& data, TimedXyzDownsampleBuffer& buffer);
-
-    /**
-     * Downsample and propagate data to all connected sessions.
+     * Downsample and propagate data to all connected sessions. Sessions
+     * with downsampling enabled get the average of the samples received
+     * during their interval, other sessions get every sample.
      *
      * @param data Object to handle.
-     * @param buffer Data buffer.
+     * @param buffer Per-session decimator.
      * @return was data succesfully handled.
      */
-    bool downsampleAndPropagate(const CalibratedMagneticFieldData& data, MagneticFieldDownsampleBuffer& buffer);
+    template <class TYPE>
+    bool downsampleAndPropagate(const TYPE& data, SessionDecimator<TYPE>& buffer);
 
     /**
      * Signal property change.
@@ -230,23 +265,101 @@ protected:
     virtual RingBufferBase* findBuffer(const QString& name) const;
 
 private:
+    /**
+     * Routes of sessions receiving the same sample.
+     */
+    typedef QVarLengthArray<int, 16> SessionList;
+
+    /**
+     * Route recorded for sessions using shared memory transport, which
+     * are skipped when writing to sockets.
+     */
+    static const int SHARED_ROUTE = -2;
+
+    /**
+     * Add session to fan-out list.
+     *
+     * @param sessions fan-out list.
+     * @param sessionId session ID.
+     * @param route session route.
+     * @param source source object.
+     * @param size size of object.
+     */
+    void addToFanOut(SessionList& sessions, int sessionId, int route, const void* source, int size);
+
+    /**
+     * Write one sample record for all sessions of the fan-out list.
+     *
+     * @param sessions fan-out list.
+     * @param source source object.
+     * @param size size of object to write.
+     * @return was data succesfully written.
+     */
+    bool writeFanOut(const SessionList& sessions, const void* source, int size);
+
     /**
      * Write to given session.
      *
      * @param sessionId session ID.
+     * @param route session route.
      * @param source source object.
      * @param size size of object to write.
      * @return was data succesfully written.
      */
-    bool writeToSession(int sessionId, const void* source, int size);
+    bool writeToSession(int sessionId, int route, const void* source, int size);
+
+    /**
+     * Publish data to sessions using shared memory transport and to
+     * the latest value page.
+     *
+     * @param source source object.
+     * @param size size of object to write.
+     * @return was data succesfully published.
+     */
+    bool writeToSharedSessions(const void* source, int size);
 
     SensorError         errorCode_;       /**< previous occured error code */
     QString             errorString_;     /**< previous occured error description */
     int                 cnt_;             /**< usage reference count */
-    QSet<int>           activeSessions_;  /**< active sessions */
+    QHash<int, int>     activeSessions_;  /**< routes of active sessions */
     QMap<int, bool>     downsampling_;    /**< downsample state for sessions */
+    QAtomicPointer<SharedSampleBuffer> sharedBuffer_; /**< shared memory transport, created on demand */
+    bool                latestEnabled_;   /**< is output published in the latest value page */
+    int                 latestSlot_;      /**< slot in the latest value page, -1 if none */
+    LatestValuePageWriter* latestWriter_; /**< latest value page, NULL until a slot is allocated */
 };
 
+template <class TYPE>
+bool AbstractSensorChannel::downsampleAndPropagate(const TYPE& data, SessionDecimator<TYPE>& buffer)
+{
+    bool ret = writeToSharedSessions(&data, sizeof(TYPE));
+    unsigned int currentInterval = getInterval();
+    SessionList sessions;
+    for(QHash<int, int>::const_iterator it = activeSessions_.constBegin(); it != activeSessions_.constEnd(); ++it)
+    {
+        int sessionId = it.key();
+        if(it.value() == SHARED_ROUTE)
+            continue;
+        if(!downsamplingEnabled(sessionId))
+        {
+            addToFanOut(sessions, sessionId, it.value(), &data, sizeof(TYPE));
+            continue;
+        }
+        unsigned int sessionInterval = getInterval(sessionId);
+        int bufferSize = (sessionInterval < currentInterval || !currentInterval) ? 1 : sessionInterval / currentInterval;
+
+        TYPE downsampled;
+        if(!buffer.add(sessionId, data, bufferSize, downsampled))
+            continue;
+
+        if(writeToSession(sessionId, it.value(), (const void*)& downsampled, sizeof(TYPE)))
+            buffer.clear(sessionId);
+        else
+            ret = false;
+    }
+    return writeFanOut(sessions, &data, sizeof(TYPE)) && ret;
+}
+
 /**
  * Factory type for constructing sensor channel.
  */
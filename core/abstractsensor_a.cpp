@@ -101,8 +101,14 @@ void AbstractSensorChannelAdaptor::stop(int sessionId)
 
 void AbstractSensorChannelAdaptor::setInterval(int sessionId, int value)
 {
-    node()->setIntervalRequest(sessionId, value);
+    applyInterval(sessionId, value);
+}
+
+bool AbstractSensorChannelAdaptor::applyInterval(int sessionId, int value)
+{
+    bool ok = node()->setIntervalRequest(sessionId, value);
     SensorManager::instance().socketHandler().setInterval(sessionId, value);
+    return ok;
 }
 
 bool AbstractSensorChannelAdaptor::standbyOverride() const
@@ -149,6 +155,12 @@ bool AbstractSensorChannelAdaptor::setDefaultInterval(int sessionId)
 
 void AbstractSensorChannelAdaptor::setBufferInterval(int sessionId, unsigned int value)
 {
+    applyBufferInterval(sessionId, value);
+}
+
+bool AbstractSensorChannelAdaptor::applyBufferInterval(int sessionId, unsigned int value)
+{
+    bool ok = true;
     bool hwBuffering = false;
     node()->getAvailableBufferIntervals(hwBuffering);
     if(hwBuffering)
@@ -156,17 +168,24 @@ void AbstractSensorChannelAdaptor::setBufferInterval(int sessionId, unsigned int
         if(value == 0)
             node()->clearBufferInterval(sessionId);
         else
-            node()->setBufferInterval(sessionId, value);
+            ok = node()->setBufferInterval(sessionId, value);
         value = 0;
     }
     if(value == 0)
         SensorManager::instance().socketHandler().clearBufferInterval(sessionId);
     else
         SensorManager::instance().socketHandler().setBufferInterval(sessionId, value);
+    return ok;
 }
 
 void AbstractSensorChannelAdaptor::setBufferSize(int sessionId, unsigned int value)
 {
+    applyBufferSize(sessionId, value);
+}
+
+bool AbstractSensorChannelAdaptor::applyBufferSize(int sessionId, unsigned int value)
+{
+    bool ok = true;
     bool hwBuffering = false;
     node()->getAvailableBufferSizes(hwBuffering);
     if(hwBuffering)
@@ -174,12 +193,13 @@ void AbstractSensorChannelAdaptor::setBufferSize(int sessionId, unsigned int val
         if(value == 0)
             node()->clearBufferSize(sessionId);
         else
-            node()->setBufferSize(sessionId, value);
+            ok = node()->setBufferSize(sessionId, value);
     }
     if(value == 0)
         SensorManager::instance().socketHandler().clearBufferSize(sessionId);
     else
         SensorManager::instance().socketHandler().setBufferSize(sessionId, value);
+    return ok;
 }
 
 IntegerRangeList AbstractSensorChannelAdaptor::getAvailableBufferIntervals() const
@@ -208,3 +228,18 @@ void AbstractSensorChannelAdaptor::setDownsampling(int sessionId, bool value)
 {
     node()->setDownsamplingEnabled(sessionId, value);
 }
+
+QDBusUnixFileDescriptor AbstractSensorChannelAdaptor::requestSharedTransport(int sessionId, QDBusUnixFileDescriptor& notifier)
+{
+    int ringFd;
+    int notifyFd;
+    if (!QDBusUnixFileDescriptor::isSupported() || !node()->startSharedTransport(sessionId, ringFd, notifyFd))
+        return QDBusUnixFileDescriptor();
+    notifier.setFileDescriptor(notifyFd);
+    return QDBusUnixFileDescriptor(ringFd);
+}
+
+quint64 AbstractSensorChannelAdaptor::droppedSamples(int sessionId) const
+{
+    return SensorManager::instance().socketHandler().droppedSamples(sessionId);
+}
@@ -62,6 +62,35 @@ public:
      */
     virtual ~AbstractSensorChannelAdaptor() {}
 
+    /**
+     * Set interval of a session for the sensor and the data connection.
+     *
+     * @param sessionId Session ID.
+     * @param value Interval in milliseconds.
+     * @return was the interval accepted by the sensor.
+     */
+    bool applyInterval(int sessionId, int value);
+
+    /**
+     * Set buffer interval of a session, in hardware if supported and
+     * otherwise for the data connection.
+     *
+     * @param sessionId Session ID.
+     * @param value Buffer interval, 0 to clear.
+     * @return was the buffer interval accepted.
+     */
+    bool applyBufferInterval(int sessionId, unsigned int value);
+
+    /**
+     * Set buffer size of a session, in hardware if supported and for
+     * the data connection.
+     *
+     * @param sessionId Session ID.
+     * @param value Buffer size, 0 to clear.
+     * @return was the buffer size accepted.
+     */
+    bool applyBufferSize(int sessionId, unsigned int value);
+
 protected:
     /**
      * Constructor.
@@ -174,6 +203,16 @@ public Q_SLOTS: // METHODS
     /** AbstractSensorChannel::hwBuffering() */
     bool hwBuffering() const;
 
+    /** AbstractSensorChannel::startSharedTransport(int, int&, int&)
+     *
+     *  Returns the ring descriptor and sets the eventfd, both invalid
+     *  if shared transport is not available.
+     */
+    QDBusUnixFileDescriptor requestSharedTransport(int sessionId, QDBusUnixFileDescriptor& notifier);
+
+    /** SocketHandler::droppedSamples(int) */
+    quint64 droppedSamples(int sessionId) const;
+
 Q_SIGNALS:
     /** AbstractSensorChannel::propertyChanged(name) */
     void propertyChanged(const QString& name);
@@ -0,0 +1,451 @@
+/**
+   @file adaptorreactor.cpp
+   @brief AdaptorReactor
+
+   <p>
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include "adaptorreactor.h"
+#include "logging.h"
+#include "config.h"
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+
+/** How long a descriptor reporting error or hangup is left unwatched. */
+static const qint64 ERROR_BACKOFF_MS = 50;
+
+/** Maximum number of events handled per epoll_wait(). */
+static const int MAX_EVENTS = 16;
+
+static qint64 monotonicNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (qint64)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static qint64 monotonicMs()
+{
+    return monotonicNs() / 1000000;
+}
+
+void ReactorHandler::readyRead(int, bool)
+{
+}
+
+void ReactorHandler::timeout()
+{
+}
+
+struct AdaptorReactor::TimerGroup
+{
+    unsigned int            interval; /**< timer interval in milliseconds */
+    qint64                  deadline; /**< next absolute expiry in nanoseconds */
+    quint64                 ticks;    /**< number of periods served */
+    quint64                 missed;   /**< number of periods skipped */
+    QList<ReactorHandler*>  handlers; /**< handlers sharing the timer */
+};
+
+struct AdaptorReactor::TimerScheduler : public ReactorHandler
+{
+    TimerScheduler(AdaptorReactor* owner, AdaptorReactorThread* serving) :
+        reactor(owner), thread(serving), timerFd(-1) {}
+
+    ~TimerScheduler()
+    {
+        qDeleteAll(timers);
+        if (timerFd != -1)
+            close(timerFd);
+    }
+
+    void readyRead(int, bool)
+    {
+        reactor->expireTimers(this);
+    }
+
+    AdaptorReactor*                 reactor; /**< owning reactor */
+    AdaptorReactorThread*           thread;  /**< thread serving the timers */
+    int                             timerFd; /**< timerfd shared by the timers */
+    QMap<unsigned int, TimerGroup*> timers;  /**< timers by interval, guarded by thread dispatch mutex */
+};
+
+AdaptorReactor& AdaptorReactor::instance()
+{
+    // Construction is serialized by the compiler, and the destructor
+    // joins the threads at process exit.
+    static AdaptorReactor instance(Config::configuration()->value<int>("global/reactor_threads", 2),
+                                   Config::configuration()->value<int>("global/timer_slack_us", 500));
+    return instance;
+}
+
+AdaptorReactor::AdaptorReactor(int threads, int timerSlack) :
+    nextId_(0),
+    epoch_(monotonicNs()),
+    timerSlack_((qint64)qMax(timerSlack, 0) * 1000)
+{
+    if (threads < 1)
+        threads = 1;
+    for (int i = 0; i < threads; ++i) {
+        AdaptorReactorThread* thread = new AdaptorReactorThread();
+        thread->start();
+        threads_.append(thread);
+    }
+    schedulers_.fill(NULL, threads);
+}
+
+AdaptorReactor::~AdaptorReactor()
+{
+    foreach (AdaptorReactorThread* thread, threads_)
+        delete thread;
+    qDeleteAll(schedulers_);
+}
+
+int AdaptorReactor::pickThread() const
+{
+    int best = 0;
+    for (int i = 1; i < threads_.size(); ++i) {
+        if (threads_.at(i)->load() < threads_.at(best)->load())
+            best = i;
+    }
+    return best;
+}
+
+AdaptorReactor::TimerScheduler* AdaptorReactor::scheduler(int index)
+{
+    if (schedulers_.at(index))
+        return schedulers_.at(index);
+
+    TimerScheduler* scheduler = new TimerScheduler(this, threads_.at(index));
+    scheduler->timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (scheduler->timerFd == -1) {
+        sensordLogW() << "timerfd_create(): " << strerror(errno);
+        delete scheduler;
+        return NULL;
+    }
+    if (!scheduler->thread->add(scheduler->timerFd, scheduler)) {
+        delete scheduler;
+        return NULL;
+    }
+    schedulers_[index] = scheduler;
+    return scheduler;
+}
+
+int AdaptorReactor::addDescriptor(int fd, ReactorHandler* handler)
+{
+    QMutexLocker locker(&mutex_);
+
+    AdaptorReactorThread* thread = threads_.at(pickThread());
+    quint64 key = thread->add(fd, handler);
+    if (!key)
+        return -1;
+    thread->addLoad(1);
+
+    Registration registration = { thread, key, NULL, NULL, handler, 0, 0, 0 };
+    registrations_.insert(nextId_, registration);
+    return nextId_++;
+}
+
+int AdaptorReactor::addTimer(unsigned int interval, ReactorHandler* handler)
+{
+    QMutexLocker locker(&mutex_);
+
+    if (!interval)
+        interval = 1;
+
+    TimerScheduler* timerScheduler = scheduler(pickThread());
+    if (!timerScheduler)
+        return -1;
+    AdaptorReactorThread* thread = timerScheduler->thread;
+
+    QMutexLocker dispatchLocker(&thread->dispatchMutex());
+
+    TimerGroup* group = timerScheduler->timers.value(interval, NULL);
+    qint64 now = monotonicNs();
+    if (!group) {
+        // Deadlines of all timers are multiples of their interval from
+        // a common epoch, so harmonic intervals expire together.
+        qint64 period = (qint64)interval * 1000000;
+        group = new TimerGroup;
+        group->interval = interval;
+        group->deadline = epoch_ + ((now - epoch_) / period + 1) * period;
+        group->ticks = 0;
+        group->missed = 0;
+        timerScheduler->timers.insert(interval, group);
+    }
+    group->handlers.append(handler);
+    armTimer(timerScheduler);
+    thread->addLoad(1);
+
+    Registration registration = { thread, 0, timerScheduler, group, handler, now, group->ticks, group->missed };
+    registrations_.insert(nextId_, registration);
+    return nextId_++;
+}
+
+void AdaptorReactor::remove(int id)
+{
+    QMutexLocker locker(&mutex_);
+
+    QHash<int, Registration>::iterator it = registrations_.find(id);
+    if (it == registrations_.end())
+        return;
+    Registration registration = it.value();
+    registrations_.erase(it);
+
+    registration.thread->addLoad(-1);
+    TimerGroup* group = registration.group;
+    if (!group) {
+        registration.thread->remove(registration.key);
+        return;
+    }
+
+    QMutexLocker dispatchLocker(&registration.thread->dispatchMutex());
+    group->handlers.removeOne(registration.handler);
+    if (group->handlers.isEmpty()) {
+        registration.scheduler->timers.remove(group->interval);
+        delete group;
+        armTimer(registration.scheduler);
+    }
+}
+
+bool AdaptorReactor::timerRate(int id, double& requested, double& achieved, quint64& missed)
+{
+    QMutexLocker locker(&mutex_);
+
+    QHash<int, Registration>::const_iterator it = registrations_.find(id);
+    if (it == registrations_.end() || !it.value().group)
+        return false;
+    const Registration& registration = it.value();
+
+    QMutexLocker dispatchLocker(&registration.thread->dispatchMutex());
+    qint64 elapsed = monotonicNs() - registration.started;
+    requested = 1000.0 / registration.group->interval;
+    achieved = elapsed > 0 ? (registration.group->ticks - registration.ticks) * 1e9 / elapsed : 0;
+    missed = registration.group->missed - registration.missed;
+    return true;
+}
+
+void AdaptorReactor::armTimer(TimerScheduler* scheduler)
+{
+    struct itimerspec spec;
+    memset(&spec, 0, sizeof(spec));
+
+    qint64 next = -1;
+    foreach (const TimerGroup* group, scheduler->timers) {
+        if (next == -1 || group->deadline < next)
+            next = group->deadline;
+    }
+    if (next != -1) {
+        spec.it_value.tv_sec = next / 1000000000;
+        spec.it_value.tv_nsec = next % 1000000000;
+    }
+    if (timerfd_settime(scheduler->timerFd, TFD_TIMER_ABSTIME, &spec, NULL) == -1)
+        sensordLogW() << "timerfd_settime(): " << strerror(errno);
+}
+
+void AdaptorReactor::expireTimers(TimerScheduler* scheduler)
+{
+    quint64 expirations;
+    if (read(scheduler->timerFd, &expirations, sizeof(expirations)) == -1 && errno != EAGAIN)
+        sensordLogW() << "Failed to read timer: " << strerror(errno);
+
+    // Serve every timer due within the slack on this wakeup.
+    qint64 now = monotonicNs();
+    foreach (TimerGroup* group, scheduler->timers) {
+        if (group->deadline - timerSlack_ > now)
+            continue;
+
+        qint64 period = (qint64)group->interval * 1000000;
+        if (now >= group->deadline + period) {
+            qint64 late = (now - group->deadline) / period;
+            group->missed += late;
+            group->deadline += late * period;
+        }
+        group->deadline += period;
+        ++group->ticks;
+
+        foreach (ReactorHandler* handler, group->handlers)
+            handler->timeout();
+    }
+    armTimer(scheduler);
+}
+
+AdaptorReactorThread::AdaptorReactorThread() :
+    epollFd_(-1),
+    wakeFd_(-1),
+    running_(true),
+    nextKey_(1),
+    load_(0)
+{
+    if ((epollFd_ = epoll_create1(EPOLL_CLOEXEC)) == -1)
+        sensordLogW() << "epoll_create1(): " << strerror(errno);
+
+    if ((wakeFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) == -1)
+        sensordLogW() << "eventfd(): " << strerror(errno);
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(epoll_event));
+    ev.events = EPOLLIN;
+    ev.data.u64 = 0;
+    if (epoll_ctl(epollFd_, EPOLL_CTL_ADD, wakeFd_, &ev) == -1)
+        sensordLogW() << "epoll_ctl(): " << strerror(errno);
+}
+
+AdaptorReactorThread::~AdaptorReactorThread()
+{
+    running_ = false;
+    quint64 value = 1;
+    if (write(wakeFd_, &value, sizeof(value)) == -1)
+        sensordLogW() << "Failed to wake up reactor thread: " << strerror(errno);
+    wait();
+
+    if (wakeFd_ != -1)
+        close(wakeFd_);
+    if (epollFd_ != -1)
+        close(epollFd_);
+}
+
+quint64 AdaptorReactorThread::add(int fd, ReactorHandler* handler)
+{
+    QMutexLocker locker(&mutex_);
+
+    quint64 key = nextKey_++;
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(epoll_event));
+    ev.events = EPOLLIN;
+    ev.data.u64 = key;
+    if (epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &ev) == -1) {
+        sensordLogW() << "epoll_ctl(): " << strerror(errno);
+        return 0;
+    }
+
+    Entry entry = { fd, handler };
+    entries_.insert(key, entry);
+    return key;
+}
+
+void AdaptorReactorThread::remove(quint64 key)
+{
+    QMutexLocker locker(&mutex_);
+
+    QHash<quint64, Entry>::iterator it = entries_.find(key);
+    if (it == entries_.end())
+        return;
+    if (epoll_ctl(epollFd_, EPOLL_CTL_DEL, it.value().fd, NULL) == -1)
+        sensordLogW() << "epoll_ctl(): " << strerror(errno);
+    entries_.erase(it);
+    suspended_.remove(key);
+}
+
+QMutex& AdaptorReactorThread::dispatchMutex()
+{
+    return mutex_;
+}
+
+void AdaptorReactorThread::addLoad(int delta)
+{
+    __atomic_add_fetch(&load_, delta, __ATOMIC_RELAXED);
+}
+
+int AdaptorReactorThread::load() const
+{
+    return __atomic_load_n(&load_, __ATOMIC_RELAXED);
+}
+
+int AdaptorReactorThread::resumeSuspended()
+{
+    QMutexLocker locker(&mutex_);
+
+    qint64 now = monotonicMs();
+    qint64 next = -1;
+    QMap<quint64, qint64>::iterator it = suspended_.begin();
+    while (it != suspended_.end()) {
+        if (it.value() > now) {
+            if (next == -1 || it.value() - now < next)
+                next = it.value() - now;
+            ++it;
+            continue;
+        }
+        QHash<quint64, Entry>::const_iterator entry = entries_.find(it.key());
+        if (entry != entries_.end()) {
+            struct epoll_event ev;
+            memset(&ev, 0, sizeof(epoll_event));
+            ev.events = EPOLLIN;
+            ev.data.u64 = it.key();
+            if (epoll_ctl(epollFd_, EPOLL_CTL_MOD, entry.value().fd, &ev) == -1)
+                sensordLogW() << "epoll_ctl(): " << strerror(errno);
+        }
+        it = suspended_.erase(it);
+    }
+    return (int)next;
+}
+
+void AdaptorReactorThread::run()
+{
+    struct epoll_event events[MAX_EVENTS];
+
+    while (running_) {
+        int timeout = resumeSuspended();
+        int descriptors = epoll_wait(epollFd_, events, MAX_EVENTS, timeout);
+
+        if (descriptors == -1) {
+            if (errno != EINTR) {
+                sensordLogD() << "epoll_wait(): " << strerror(errno);
+                QThread::msleep(1000);
+            }
+            continue;
+        }
+
+        QMutexLocker locker(&mutex_);
+        for (int i = 0; i < descriptors; ++i) {
+            quint64 key = events[i].data.u64;
+            if (!key) {
+                quint64 value;
+                if (read(wakeFd_, &value, sizeof(value)) == -1 && errno != EAGAIN)
+                    sensordLogW() << "Failed to read reactor wakeup: " << strerror(errno);
+                continue;
+            }
+
+            // Registration may have been removed after epoll_wait() returned.
+            QHash<quint64, Entry>::const_iterator it = entries_.find(key);
+            if (it == entries_.end())
+                continue;
+            Entry entry = it.value();
+
+            bool error = events[i].events & (EPOLLHUP | EPOLLERR);
+            entry.handler->readyRead(entry.fd, error);
+
+            if (error) {
+                // Descriptor stays readable while in error state, so
+                // park it for a while instead of spinning on it.
+                struct epoll_event ev;
+                memset(&ev, 0, sizeof(epoll_event));
+                ev.data.u64 = key;
+                if (epoll_ctl(epollFd_, EPOLL_CTL_MOD, entry.fd, &ev) == -1)
+                    sensordLogW() << "epoll_ctl(): " << strerror(errno);
+                else
+                    suspended_.insert(key, monotonicMs() + ERROR_BACKOFF_MS);
+            }
+        }
+    }
+}
@@ -0,0 +1,298 @@
+/**
+   @file adaptorreactor.h
+   @brief AdaptorReactor
+
+   <p>
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef ADAPTORREACTOR_H
+#define ADAPTORREACTOR_H
+
+#include <QThread>
+#include <QMutex>
+#include <QHash>
+#include <QMap>
+#include <QList>
+#include <QVector>
+
+/**
+ * Callback interface for objects driven by #AdaptorReactor.
+ * Callbacks are invoked from a reactor thread.
+ */
+class ReactorHandler
+{
+public:
+    /**
+     * Destructor.
+     */
+    virtual ~ReactorHandler() {}
+
+    /**
+     * Registered descriptor became readable.
+     *
+     * @param fd Descriptor.
+     * @param error Was error or hangup reported for the descriptor.
+     */
+    virtual void readyRead(int fd, bool error);
+
+    /**
+     * Registered timer expired.
+     */
+    virtual void timeout();
+};
+
+class AdaptorReactorThread;
+
+/**
+ * Shared reactor serving all sysfs and input device adaptors from a
+ * small fixed pool of epoll threads instead of one thread per adaptor.
+ *
+ * Descriptors and timer handlers are spread over the threads by load,
+ * so a slow handler only delays the others on the same thread. Periodic
+ * timers are scheduled on absolute deadlines so the period does not
+ * drift with processing time, and periods that could not be served in
+ * time are counted as missed instead of being delivered late. The
+ * timers of each thread are multiplexed onto one timerfd: handlers on
+ * the thread asking for the same interval share one timer, harmonic
+ * intervals share a common phase on all threads, and timers due within
+ * the configured slack of a wakeup are served on that wakeup.
+ *
+ * Pool size is read from <tt>global/reactor_threads</tt> configuration
+ * key, default is 2. Timer slack is read from
+ * <tt>global/timer_slack_us</tt>, default is 500.
+ */
+class AdaptorReactor
+{
+public:
+    /**
+     * Get reactor instance. Threads are started on first use and
+     * joined at process exit.
+     *
+     * @return reactor instance.
+     */
+    static AdaptorReactor& instance();
+
+    /**
+     * Destructor. Stops all threads.
+     */
+    ~AdaptorReactor();
+
+    /**
+     * Watch descriptor for readability.
+     *
+     * @param fd Descriptor.
+     * @param handler Handler to invoke.
+     * @return registration ID, or -1 on failure.
+     */
+    int addDescriptor(int fd, ReactorHandler* handler);
+
+    /**
+     * Invoke handler periodically.
+     *
+     * @param interval Interval in milliseconds. Zero is treated as one.
+     * @param handler Handler to invoke.
+     * @return registration ID, or -1 on failure.
+     */
+    int addTimer(unsigned int interval, ReactorHandler* handler);
+
+    /**
+     * Remove registration. When this returns the handler is not running
+     * and will not be invoked for the registration anymore. Must not be
+     * called from within a handler callback.
+     *
+     * @param id Registration ID.
+     */
+    void remove(int id);
+
+    /**
+     * Requested and achieved rate of a timer registration, measured
+     * since the registration was made.
+     *
+     * @param id Registration ID.
+     * @param requested Requested rate in Hz.
+     * @param achieved Achieved rate in Hz.
+     * @param missed Number of periods missed.
+     * @return false if ID does not refer to a timer.
+     */
+    bool timerRate(int id, double& requested, double& achieved, quint64& missed);
+
+private:
+    Q_DISABLE_COPY(AdaptorReactor)
+
+    /**
+     * Constructor.
+     *
+     * @param threads Number of reactor threads.
+     * @param timerSlack Timer slack in microseconds.
+     */
+    AdaptorReactor(int threads, int timerSlack);
+
+    /**
+     * Timer shared by all handlers using the same interval.
+     */
+    struct TimerGroup;
+
+    /**
+     * Timers of one thread and reactor callback for their timerfd.
+     */
+    struct TimerScheduler;
+
+    /**
+     * Registration bookkeeping.
+     */
+    struct Registration
+    {
+        AdaptorReactorThread* thread;    /**< thread serving the registration */
+        quint64               key;       /**< key within the thread for descriptors */
+        TimerScheduler*       scheduler; /**< timer scheduler or NULL for descriptors */
+        TimerGroup*           group;     /**< timer group or NULL for descriptors */
+        ReactorHandler*       handler;   /**< registered handler */
+        qint64                started;   /**< registration time for timers */
+        quint64               ticks;     /**< group ticks at registration */
+        quint64               missed;    /**< group missed ticks at registration */
+    };
+
+    /**
+     * Pick the least loaded thread. Does not wait for running dispatch.
+     *
+     * @return index of the thread.
+     */
+    int pickThread() const;
+
+    /**
+     * Timer scheduler of a thread, created on first use.
+     *
+     * @param index Index of the thread.
+     * @return scheduler, NULL on failure.
+     */
+    TimerScheduler* scheduler(int index);
+
+    /**
+     * Program timerfd of a scheduler to its earliest timer deadline.
+     * Called with the dispatch mutex of its thread held.
+     *
+     * @param scheduler Timer scheduler.
+     */
+    void armTimer(TimerScheduler* scheduler);
+
+    /**
+     * Serve due timers of a scheduler. Called from its thread.
+     *
+     * @param scheduler Timer scheduler.
+     */
+    void expireTimers(TimerScheduler* scheduler);
+
+    QMutex                            mutex_;         /**< guards registration state */
+    QVector<AdaptorReactorThread*>    threads_;       /**< reactor threads */
+    QVector<TimerScheduler*>          schedulers_;    /**< timer scheduler of each thread, NULL until first timer */
+    QHash<int, Registration>          registrations_; /**< registrations by ID */
+    int                               nextId_;        /**< next registration ID */
+    qint64                            epoch_;         /**< common phase of timer deadlines in nanoseconds */
+    qint64                            timerSlack_;    /**< timer slack in nanoseconds */
+};
+
+/**
+ * Single epoll loop of #AdaptorReactor. Should not be used directly.
+ */
+class AdaptorReactorThread : public QThread
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(AdaptorReactorThread)
+
+public:
+    /**
+     * Constructor.
+     */
+    AdaptorReactorThread();
+
+    /**
+     * Destructor. Stops the loop.
+     */
+    ~AdaptorReactorThread();
+
+    /**
+     * Start watching descriptor.
+     *
+     * @param fd Descriptor.
+     * @param handler Handler to invoke.
+     * @return key for #remove(), 0 on failure.
+     */
+    quint64 add(int fd, ReactorHandler* handler);
+
+    /**
+     * Stop watching descriptor. Waits for running dispatch to finish.
+     *
+     * @param key Key returned by #add().
+     */
+    void remove(quint64 key);
+
+    /**
+     * Mutex held while handlers are dispatched on this thread. Holding
+     * it blocks dispatching.
+     *
+     * @return dispatch mutex.
+     */
+    QMutex& dispatchMutex();
+
+    /**
+     * Account registrations served by this thread.
+     *
+     * @param delta Change in the number of registrations.
+     */
+    void addLoad(int delta);
+
+    /**
+     * Number of registrations served by this thread. Lock-free, does
+     * not wait for running dispatch.
+     *
+     * @return registration count.
+     */
+    int load() const;
+
+    /**
+     * Loop entry-function.
+     */
+    void run();
+
+private:
+    /**
+     * Watched descriptor.
+     */
+    struct Entry
+    {
+        int             fd;      /**< descriptor */
+        ReactorHandler* handler; /**< handler */
+    };
+
+    /**
+     * Re-enable descriptors whose error backoff has expired.
+     *
+     * @return milliseconds until next backoff expires, -1 if none.
+     */
+    int resumeSuspended();
+
+    int                      epollFd_;   /**< epoll descriptor */
+    int                      wakeFd_;    /**< eventfd used for stopping */
+    bool                     running_;   /**< should loop keep running */
+    mutable QMutex           mutex_;     /**< serializes dispatch and registration */
+    QHash<quint64, Entry>    entries_;   /**< watched descriptors by key */
+    QMap<quint64, qint64>    suspended_; /**< descriptors in error backoff, key to resume time */
+    quint64                  nextKey_;   /**< next key */
+    int                      load_;      /**< registrations served, see #load() */
+};
+
+#endif // ADAPTORREACTOR_H
@@ -0,0 +1,142 @@
+/**
+   @file batchqueue.h
+   @brief BatchQueue
+
+   <p>
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef BATCHQUEUE_H
+#define BATCHQUEUE_H
+
+#include "ringbuffer.h"
+
+/**
+ * Bounded lock-free queue handing sample batches from one producer
+ * thread to one consumer thread. Capacity is rounded up to a power of
+ * two. Samples which do not fit are rejected, the producer decides
+ * what to do with them.
+ *
+ * @tparam TYPE sample type.
+ */
+template <class TYPE>
+class BatchQueue
+{
+public:
+    /**
+     * Constructor.
+     *
+     * @param size capacity in samples.
+     */
+    BatchQueue(unsigned size) :
+        capacity_(roundUp(size)),
+        mask_(capacity_ - 1),
+        buffer_(new TYPE[capacity_]),
+        head_(0),
+        tail_(0)
+    {
+    }
+
+    /**
+     * Destructor.
+     */
+    ~BatchQueue()
+    {
+        delete[] buffer_;
+    }
+
+    /**
+     * Append samples. Called from the producer thread only.
+     *
+     * @param n number of samples.
+     * @param values samples.
+     * @return number of samples queued, less than n if the queue is full.
+     */
+    unsigned push(unsigned n, const TYPE* values)
+    {
+        unsigned tail = __atomic_load_n(&tail_, __ATOMIC_RELAXED);
+        unsigned head = __atomic_load_n(&head_, __ATOMIC_ACQUIRE);
+        unsigned free = capacity_ - (tail - head);
+        if (n > free)
+            n = free;
+
+        unsigned offset = tail & mask_;
+        unsigned first = qMin(n, capacity_ - offset);
+        RingBufferCopy<TYPE>::copy(buffer_ + offset, values, first);
+        RingBufferCopy<TYPE>::copy(buffer_, values + first, n - first);
+        __atomic_store_n(&tail_, tail + n, __ATOMIC_RELEASE);
+        return n;
+    }
+
+    /**
+     * Remove samples. Called from the consumer thread only.
+     *
+     * @param n maximum number of samples.
+     * @param values location to copy samples to.
+     * @return number of samples removed.
+     */
+    unsigned pop(unsigned n, TYPE* values)
+    {
+        unsigned head = __atomic_load_n(&head_, __ATOMIC_RELAXED);
+        unsigned tail = __atomic_load_n(&tail_, __ATOMIC_ACQUIRE);
+        unsigned available = tail - head;
+        if (n > available)
+            n = available;
+
+        unsigned offset = head & mask_;
+        unsigned first = qMin(n, capacity_ - offset);
+        RingBufferCopy<TYPE>::copy(values, buffer_ + offset, first);
+        RingBufferCopy<TYPE>::copy(values + first, buffer_, n - first);
+        __atomic_store_n(&head_, head + n, __ATOMIC_RELEASE);
+        return n;
+    }
+
+    /**
+     * Number of queued samples. Safe to call from any thread.
+     *
+     * @return queue depth.
+     */
+    unsigned size() const
+    {
+        unsigned head = __atomic_load_n(&head_, __ATOMIC_ACQUIRE);
+        return __atomic_load_n(&tail_, __ATOMIC_ACQUIRE) - head;
+    }
+
+private:
+    Q_DISABLE_COPY(BatchQueue)
+
+    /**
+     * Round size up to the next power of two.
+     *
+     * @param size requested size.
+     * @return rounded size, at least one.
+     */
+    static unsigned roundUp(unsigned size)
+    {
+        unsigned rounded = 1;
+        while (rounded < size)
+            rounded <<= 1;
+        return rounded;
+    }
+
+    const unsigned capacity_; /**< capacity, power of two */
+    const unsigned mask_;     /**< capacity_ - 1 */
+    TYPE*          buffer_;   /**< storage */
+    unsigned       head_;     /**< samples removed by the consumer */
+    unsigned       tail_;     /**< samples added by the producer */
+};
+
+#endif // BATCHQUEUE_H
@@ -34,6 +34,7 @@
 #include "sink.h"
 #include "ringbuffer.h"
 #include "logging.h"
+#include "latencytrace.h"
 
 Bin::Bin()
 {
@@ -90,6 +91,7 @@ bool Bin::join(const QString& producerName,
         if (src->join(snk)) {
 
             joined = true;
+            SENSORFW_TRACE_OBJECT_NAME(src, producerName + "/" + sourceName);
 
         } else {
             sensordLogT() << " source "
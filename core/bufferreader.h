@@ -31,15 +31,20 @@
 #include "pusher.h"
 #include "source.h"
 #include "ringbuffer.h"
+#include "batchqueue.h"
+#include "chainexecutor.h"
 
 /**
  * Data producer subclass which reads data from RingBuffer and propagates
  * it into sinks attached into source "source".
  *
+ * With an executor set, data is moved into a queue when the reader is
+ * woken up and propagated later from the executor's worker thread.
+ *
  * @tparam TYPE Data type of entries in RingBuffer.
  */
 template <class TYPE>
-class BufferReader : public RingBufferReader<TYPE>
+class BufferReader : public RingBufferReader<TYPE>, public DeferredReader
 {
 
 public:
@@ -50,7 +55,10 @@ public:
      */
     BufferReader(unsigned chunkSize) :
         chunkSize_(chunkSize),
-        chunk_(new TYPE[chunkSize])
+        chunk_(new TYPE[chunkSize]),
+        executor_(NULL),
+        queue_(NULL),
+        workerChunk_(NULL)
     {
         this->addSource(&source_, "source");
     }
@@ -60,24 +68,74 @@ public:
      */
     virtual ~BufferReader()
     {
+        setExecutor(NULL);
         delete[] chunk_;
     }
 
     /**
-     * Propagate data into sinks attached to source "source".
+     * Propagate data into sinks attached to source "source", or queue
+     * it for the executor.
      */
     void pushNewData()
     {
         unsigned n;
+        if (!executor_) {
+            while ((n = RingBufferReader<TYPE>::read(chunkSize_, chunk_))) {
+                source_.propagate(n, chunk_);
+            }
+            return;
+        }
+
         while ((n = RingBufferReader<TYPE>::read(chunkSize_, chunk_))) {
-            source_.propagate(n, chunk_);
+            unsigned queued = queue_->push(n, chunk_);
+            if (queued < n)
+                executor_->addDropped(n - queued);
+        }
+        executor_->noteDepth(queue_->size());
+        executor_->schedule();
+    }
+
+    bool setExecutor(ChainExecutor* executor)
+    {
+        if (executor_) {
+            executor_->removeReader(this);
+            delete queue_;
+            delete[] workerChunk_;
+            queue_ = NULL;
+            workerChunk_ = NULL;
+        }
+        executor_ = executor;
+        if (executor_) {
+            queue_ = new BatchQueue<TYPE>(ChainExecutor::queueSize());
+            workerChunk_ = new TYPE[chunkSize_];
+            executor_->addReader(this);
         }
+        return true;
+    }
+
+    unsigned drain()
+    {
+        unsigned n;
+        unsigned total = 0;
+        while ((n = queue_->pop(chunkSize_, workerChunk_))) {
+            source_.propagate(n, workerChunk_);
+            total += n;
+        }
+        return total;
+    }
+
+    unsigned queued() const
+    {
+        return queue_->size();
     }
 
 private:
-    Source<TYPE> source_;    /**< Source */
-    unsigned     chunkSize_; /**< How many objects can be buffered */
-    TYPE*        chunk_;     /**< Data storage */
+    Source<TYPE>      source_;      /**< Source */
+    unsigned          chunkSize_;   /**< How many objects can be buffered */
+    TYPE*             chunk_;       /**< Data storage */
+    ChainExecutor*    executor_;    /**< executor processing queued data, NULL if inline */
+    BatchQueue<TYPE>* queue_;       /**< data waiting for the executor */
+    TYPE*             workerChunk_; /**< Data storage of the executor */
 };
 
 #endif
@@ -0,0 +1,224 @@
+/**
+   @file chainexecutor.cpp
+   @brief ChainExecutor
+
+   <p>
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include "chainexecutor.h"
+#include "config.h"
+#include "logging.h"
+
+#include <QThreadPool>
+#include <QElapsedTimer>
+
+static QThreadPool& workerPool()
+{
+    static QThreadPool* pool = NULL;
+    if (!pool) {
+        pool = new QThreadPool();
+        pool->setMaxThreadCount(qMax(Config::configuration()->value<int>("global/chain_workers", 2), 1));
+        pool->setExpiryTimeout(-1);
+    }
+    return *pool;
+}
+
+__thread ChainExecutor* ChainExecutor::running_ = NULL;
+
+ChainExecutor::Pause::Pause(const QList<ChainExecutor*>& executors) :
+    executors_(executors)
+{
+    foreach (ChainExecutor* executor, executors_)
+        executor->pause();
+}
+
+ChainExecutor::Pause::~Pause()
+{
+    foreach (ChainExecutor* executor, executors_)
+        executor->resume();
+}
+
+ChainExecutor::Policy ChainExecutor::policy(const QString& chainId)
+{
+    QString policy = Config::configuration()->value<QString>(chainId + "/execution", "inline");
+    if (policy == "worker")
+        return Worker;
+    if (policy != "inline")
+        sensordLogW() << "Unknown execution policy '" << policy << "' for " << chainId << ", running inline";
+    return Inline;
+}
+
+unsigned ChainExecutor::queueSize()
+{
+    return qMax(Config::configuration()->value<int>("global/chain_queue_size", 256), 1);
+}
+
+ChainExecutor::ChainExecutor(const QString& id) :
+    id_(id),
+    scheduled_(0),
+    inFlight_(0),
+    paused_(0),
+    deferred_(false),
+    batches_(0),
+    samples_(0),
+    dropped_(0),
+    totalNs_(0),
+    maxNs_(0),
+    maxDepth_(0)
+{
+    setAutoDelete(false);
+    // Start the pool from the main thread, it is not created thread safely.
+    workerPool();
+    sensordLogD() << "Running " << id_ << " on worker pool";
+}
+
+ChainExecutor::~ChainExecutor()
+{
+    QMutexLocker locker(&mutex_);
+    while (inFlight_)
+        idle_.wait(&mutex_);
+}
+
+void ChainExecutor::addReader(DeferredReader* reader)
+{
+    readers_.insert(reader);
+}
+
+void ChainExecutor::removeReader(DeferredReader* reader)
+{
+    readers_.remove(reader);
+}
+
+void ChainExecutor::schedule()
+{
+    if (__atomic_exchange_n(&scheduled_, 1, __ATOMIC_SEQ_CST))
+        return;
+    {
+        QMutexLocker locker(&mutex_);
+        // Runs requested while paused are started by resume().
+        if (paused_) {
+            deferred_ = true;
+            return;
+        }
+        ++inFlight_;
+    }
+    workerPool().start(this);
+}
+
+void ChainExecutor::pause()
+{
+    QMutexLocker locker(&mutex_);
+    ++paused_;
+    if (running_ == this)
+        return;
+    while (inFlight_)
+        idle_.wait(&mutex_);
+}
+
+void ChainExecutor::resume()
+{
+    {
+        QMutexLocker locker(&mutex_);
+        if (--paused_ || !deferred_)
+            return;
+        deferred_ = false;
+        ++inFlight_;
+    }
+    workerPool().start(this);
+}
+
+void ChainExecutor::addDropped(unsigned count)
+{
+    // Warn once per chain, the counter tells the rest.
+    if (__atomic_fetch_add(&dropped_, count, __ATOMIC_RELAXED) == 0)
+        sensordLogW() << "Worker queue of " << id_ << " full, dropping samples";
+}
+
+void ChainExecutor::noteDepth(unsigned depth)
+{
+    unsigned current = __atomic_load_n(&maxDepth_, __ATOMIC_RELAXED);
+    while (depth > current &&
+           !__atomic_compare_exchange_n(&maxDepth_, &current, depth, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        ;
+}
+
+ChainExecutor::Metrics ChainExecutor::metrics() const
+{
+    Metrics metrics;
+    metrics.batches = __atomic_load_n(&batches_, __ATOMIC_RELAXED);
+    metrics.samples = __atomic_load_n(&samples_, __ATOMIC_RELAXED);
+    metrics.dropped = __atomic_load_n(&dropped_, __ATOMIC_RELAXED);
+    metrics.totalNs = __atomic_load_n(&totalNs_, __ATOMIC_RELAXED);
+    metrics.maxNs = __atomic_load_n(&maxNs_, __ATOMIC_RELAXED);
+    metrics.maxDepth = __atomic_load_n(&maxDepth_, __ATOMIC_RELAXED);
+    metrics.depth = 0;
+    SubscriberList<DeferredReader*>::Snapshot readers(readers_);
+    for (int i = 0; i < readers.size(); ++i)
+        metrics.depth += readers.at(i)->queued();
+    return metrics;
+}
+
+bool ChainExecutor::hasPending() const
+{
+    SubscriberList<DeferredReader*>::Snapshot readers(readers_);
+    for (int i = 0; i < readers.size(); ++i) {
+        if (readers.at(i)->queued())
+            return true;
+    }
+    return false;
+}
+
+void ChainExecutor::run()
+{
+    QElapsedTimer timer;
+    running_ = this;
+    forever {
+        timer.start();
+        unsigned samples = 0;
+        {
+            SubscriberList<DeferredReader*>::Snapshot readers(readers_);
+            for (int i = 0; i < readers.size(); ++i)
+                samples += readers.at(i)->drain();
+        }
+        if (samples) {
+            // Only one run drains at a time, plain read-modify-write is enough.
+            quint64 elapsed = timer.nsecsElapsed();
+            __atomic_store_n(&batches_, batches_ + 1, __ATOMIC_RELAXED);
+            __atomic_store_n(&samples_, samples_ + samples, __ATOMIC_RELAXED);
+            __atomic_store_n(&totalNs_, totalNs_ + elapsed, __ATOMIC_RELAXED);
+            if (elapsed > maxNs_)
+                __atomic_store_n(&maxNs_, elapsed, __ATOMIC_RELAXED);
+        }
+
+        // Input queued after draining either sees the flag cleared and
+        // schedules a new run, or is picked up by another round here.
+        __atomic_store_n(&scheduled_, 0, __ATOMIC_SEQ_CST);
+        if (!hasPending() || __atomic_exchange_n(&scheduled_, 1, __ATOMIC_SEQ_CST))
+            break;
+
+        QMutexLocker locker(&mutex_);
+        if (paused_) {
+            deferred_ = true;
+            break;
+        }
+    }
+    running_ = NULL;
+
+    QMutexLocker locker(&mutex_);
+    if (!--inFlight_)
+        idle_.wakeAll();
+}
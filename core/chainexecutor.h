@@ -0,0 +1,246 @@
+/**
+   @file chainexecutor.h
+   @brief ChainExecutor
+
+   <p>
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef CHAINEXECUTOR_H
+#define CHAINEXECUTOR_H
+
+#include <QString>
+#include <QList>
+#include <QRunnable>
+#include <QMutex>
+#include <QWaitCondition>
+#include "subscriberlist.h"
+
+/**
+ * Reader whose input is queued by the adaptor thread and processed by
+ * a #ChainExecutor.
+ */
+class DeferredReader
+{
+public:
+    /**
+     * Destructor.
+     */
+    virtual ~DeferredReader() {}
+
+    /**
+     * Process queued input. Called from a worker thread, never
+     * concurrently for the same executor.
+     *
+     * @return number of samples processed.
+     */
+    virtual unsigned drain() = 0;
+
+    /**
+     * Number of samples waiting to be processed.
+     *
+     * @return queue depth.
+     */
+    virtual unsigned queued() const = 0;
+};
+
+/**
+ * Runs the processing of a chain on a small thread pool shared by all
+ * worker chains, so that slow filters do not stall the adaptor thread
+ * and the other consumers of the same adaptor.
+ *
+ * Readers of the chain hand samples over through bounded lock-free
+ * queues and call #schedule(). The executor then drains all its
+ * readers on a pool thread. Processing of one chain is serialized, so
+ * filters need not be thread safe.
+ *
+ * Execution policy of a chain is read from <tt>\<chain id\>/execution</tt>
+ * configuration key, <tt>inline</tt> (default) or <tt>worker</tt>. Pool
+ * size is read from <tt>global/chain_workers</tt>, default is 2, and
+ * reader queue capacity in samples from <tt>global/chain_queue_size</tt>,
+ * default is 256.
+ *
+ * Filters, readers and properties of worker chains are changed from the
+ * main thread only while the executors processing them are paused with
+ * #ChainExecutor::Pause.
+ */
+class ChainExecutor : public QRunnable
+{
+public:
+    /**
+     * Pauses executors for the lifetime of the object. Input queued
+     * meanwhile is processed after the last pause is released.
+     */
+    class Pause
+    {
+    public:
+        /**
+         * Constructor. Returns when the executors are not processing.
+         *
+         * @param executors Executors to pause, may contain duplicates.
+         */
+        explicit Pause(const QList<ChainExecutor*>& executors);
+
+        /**
+         * Destructor. Resumes the executors.
+         */
+        ~Pause();
+
+    private:
+        Q_DISABLE_COPY(Pause)
+
+        QList<ChainExecutor*> executors_; /**< paused executors */
+    };
+
+    /**
+     * Execution policies.
+     */
+    enum Policy
+    {
+        Inline = 0, /**< run on the thread delivering the input */
+        Worker      /**< run on the shared worker pool */
+    };
+
+    /**
+     * Processing statistics.
+     */
+    struct Metrics
+    {
+        quint64  batches;  /**< processing rounds */
+        quint64  samples;  /**< processed input samples */
+        quint64  dropped;  /**< input samples dropped on full queue */
+        quint64  totalNs;  /**< time spent processing */
+        quint64  maxNs;    /**< longest processing round */
+        unsigned depth;    /**< samples queued now */
+        unsigned maxDepth; /**< most samples queued at once */
+    };
+
+    /**
+     * Configured execution policy of a chain.
+     *
+     * @param chainId Chain ID.
+     * @return policy.
+     */
+    static Policy policy(const QString& chainId);
+
+    /**
+     * Configured capacity of reader queues.
+     *
+     * @return capacity in samples.
+     */
+    static unsigned queueSize();
+
+    /**
+     * Constructor.
+     *
+     * @param id Chain ID, used in log messages.
+     */
+    ChainExecutor(const QString& id);
+
+    /**
+     * Destructor. Waits for scheduled processing to finish.
+     */
+    ~ChainExecutor();
+
+    /**
+     * Add reader to be drained by this executor.
+     *
+     * @param reader Reader.
+     */
+    void addReader(DeferredReader* reader);
+
+    /**
+     * Remove reader. When this returns the reader is not drained
+     * anymore and can be destroyed.
+     *
+     * @param reader Reader.
+     */
+    void removeReader(DeferredReader* reader);
+
+    /**
+     * Request processing of queued input. Called by readers after
+     * queueing samples, from any thread.
+     */
+    void schedule();
+
+    /**
+     * Stop starting new processing rounds and wait for the running one
+     * to finish. Calls nest, each must be matched by #resume(). Called
+     * from the processing itself it does not wait.
+     */
+    void pause();
+
+    /**
+     * Release a pause. Input queued while paused is scheduled when the
+     * last pause is released.
+     */
+    void resume();
+
+    /**
+     * Account samples which did not fit into a reader queue.
+     *
+     * @param count Number of dropped samples.
+     */
+    void addDropped(unsigned count);
+
+    /**
+     * Account reader queue depth after queueing.
+     *
+     * @param depth Queue depth.
+     */
+    void noteDepth(unsigned depth);
+
+    /**
+     * Current processing statistics.
+     *
+     * @return metrics.
+     */
+    Metrics metrics() const;
+
+    /**
+     * Drain readers. Called from a pool thread.
+     */
+    void run();
+
+private:
+    Q_DISABLE_COPY(ChainExecutor)
+
+    /**
+     * Do readers have queued samples.
+     *
+     * @return is there pending input.
+     */
+    bool hasPending() const;
+
+    QString                         id_;        /**< chain ID */
+    SubscriberList<DeferredReader*> readers_;   /**< drained readers */
+    int                             scheduled_; /**< is a run pending or active */
+    int                             inFlight_;  /**< runs handed to the pool and not finished */
+    int                             paused_;    /**< nesting count of pauses */
+    bool                            deferred_;  /**< was a run requested while paused */
+    QMutex                          mutex_;     /**< guards inFlight_, paused_ and deferred_ */
+    QWaitCondition                  idle_;      /**< signalled when inFlight_ drops to zero */
+    quint64                         batches_;   /**< processing rounds */
+    quint64                         samples_;   /**< processed samples */
+    quint64                         dropped_;   /**< dropped samples */
+    quint64                         totalNs_;   /**< time spent processing */
+    quint64                         maxNs_;     /**< longest processing round */
+    unsigned                        maxDepth_;  /**< most samples queued at once */
+
+    static __thread ChainExecutor*  running_;   /**< executor processing on this thread */
+};
+
+#endif // CHAINEXECUTOR_H
@@ -41,10 +41,19 @@ SOURCES += sensormanager.cpp \
     parameterparser.cpp \
     abstractchain.cpp \
     sysfsadaptor.cpp \
+    iioadaptor.cpp \
     sockethandler.cpp \
     inputdevadaptor.cpp \
     config.cpp \
-    nodebase.cpp
+    nodebase.cpp \
+    samplering.cpp \
+    sharedsamplebuffer.cpp \
+    adaptorreactor.cpp \
+    orientationmath.cpp \
+    samplerecorder.cpp \
+    xyzkernels.cpp \
+    latestvaluepublisher.cpp \
+    chainexecutor.cpp
 
 HEADERS += sensormanager.h \
     sensormanager_a.h \
@@ -69,10 +78,28 @@ HEADERS += sensormanager.h \
     parameterparser.h \
     abstractchain.h \
     sysfsadaptor.h \
+    iioadaptor.h \
     sockethandler.h \
     inputdevadaptor.h \
     config.h \
-    nodebase.h
+    nodebase.h \
+    samplering.h \
+    sharedsamplebuffer.h \
+    adaptorreactor.h \
+    samplewindow.h \
+    sessiondecimator.h \
+    subscriberlist.h \
+    batchqueue.h \
+    chainexecutor.h \
+    xyzkernels.h \
+    orientationmath.h \
+    samplerecorder.h \
+    latestvaluepublisher.h \
+    latencytrace.h
+
+latencytrace {
+    SOURCES += latencytrace.cpp
+}
 
 mce {
     SOURCES += mcewatcher.cpp
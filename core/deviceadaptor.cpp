@@ -29,6 +29,7 @@
 
 #include "deviceadaptor.h"
 #include "sensormanager.h"
+#include "latencytrace.h"
 
 AdaptedSensorEntry::AdaptedSensorEntry(const QString& name, const QString& description, RingBufferBase* buffer) :
     name_(name),
@@ -96,6 +97,9 @@ DeviceAdaptor::~DeviceAdaptor()
 
 void DeviceAdaptor::setAdaptedSensor(const QString& name, const QString& description, RingBufferBase* buffer)
 {
+    SENSORFW_TRACE_OBJECT_NAME(buffer, id() + "/" + name);
+    if (buffer)
+        buffer->enableRecording(id() + "/" + name);
     setAdaptedSensor(name, new AdaptedSensorEntry(name, description, buffer));
 }
 
@@ -159,3 +163,8 @@ bool DeviceAdaptor::resume()
 {
     return false;
 }
+
+bool DeviceAdaptor::pollingRate(double&, double&, quint64&) const
+{
+    return false;
+}
@@ -198,6 +198,16 @@ public:
      */
     virtual bool resume();
 
+    /**
+     * Sampling rate statistics for adaptors polling their device.
+     *
+     * @param requested Requested rate in Hz.
+     * @param achieved Rate achieved since polling was started, in Hz.
+     * @param missed Number of polling periods missed.
+     * @return false if adaptor is not polling.
+     */
+    virtual bool pollingRate(double& requested, double& achieved, quint64& missed) const;
+
     const QString& name() { return sensor_.first; }
 
 protected:
@@ -28,9 +28,11 @@
 #define DEVICEADAPTORRINGBUFFER_H
 
 #include "ringbuffer.h"
+#include "samplerecorder.h"
 
 /**
- * Ring buffer specialization for sensor adaptors.
+ * Ring buffer specialization for sensor adaptors. Committed samples are
+ * also passed to #SampleRecorder once recording has been enabled.
  * @tparam TYPE data type in buffer.
  */
 template <class TYPE>
@@ -43,12 +45,30 @@ public:
      * @param size how many elements fit into buffer.
      */
     DeviceAdaptorRingBuffer(unsigned size) :
-        RingBuffer<TYPE>(size)
+        RingBuffer<TYPE>(size),
+        recordingStream_(-1)
     {}
 
     using RingBuffer<TYPE>::nextSlot;
-    using RingBuffer<TYPE>::commit;
     using RingBuffer<TYPE>::wakeUpReaders;
+
+    /**
+     * Commit the slot returned by nextSlot().
+     */
+    void commit()
+    {
+        if (recordingStream_ >= 0)
+            SampleRecorder::append(recordingStream_, RecordedSampleType<TYPE>::ID, nextSlot(), sizeof(TYPE));
+        RingBuffer<TYPE>::commit();
+    }
+
+    void enableRecording(const QString& stream)
+    {
+        recordingStream_ = SampleRecorder::addStream(stream, RecordedSampleType<TYPE>::ID, sizeof(TYPE));
+    }
+
+private:
+    int recordingStream_; /**< recording stream ID, -1 if not recorded */
 };
 
 #endif
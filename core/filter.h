@@ -37,6 +37,13 @@
  */
 class FilterBase : public Consumer, public Producer
 {
+public:
+    /**
+     * Number of samples filters process as one batch without allocating.
+     * Larger batches are processed as well, with heap backed buffers.
+     */
+    static const int BATCH_SIZE = 64;
+
 protected:
     /**
      * Default constructor.
@@ -0,0 +1,284 @@
+/**
+   @file iioadaptor.cpp
+   @brief IioAdaptor
+
+   <p>
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include "iioadaptor.h"
+#include "config.h"
+#include "logging.h"
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <QDir>
+#include <QFileInfo>
+#include <QRegExp>
+
+static bool channelIndexLessThan(const IioChannel& a, const IioChannel& b)
+{
+    return a.index < b.index;
+}
+
+IioAdaptor::IioAdaptor(const QString& id) :
+    SysfsAdaptor(id, SysfsAdaptor::SelectMode, false),
+    bufferLength_(128),
+    scanSize_(0),
+    timestampChannel_(-1),
+    monotonicClock_(false),
+    pending_(0),
+    cachedInterval_(0),
+    reads_(0),
+    scans_(0)
+{
+}
+
+IioAdaptor::~IioAdaptor()
+{
+}
+
+void IioAdaptor::init()
+{
+    devicePath_ = Config::configuration()->value<QString>(name() + "/iio_device", "");
+    QString chardev = Config::configuration()->value<QString>(name() + "/iio_chardev", "");
+    if (chardev.isEmpty() && !devicePath_.isEmpty())
+        chardev = "/dev/" + QFileInfo(devicePath_).fileName();
+    enabledNames_ = Config::configuration()->value<QString>(name() + "/iio_channels", "").split(',', QString::SkipEmptyParts);
+    for (int i = 0; i < enabledNames_.size(); ++i)
+        enabledNames_[i] = enabledNames_[i].trimmed();
+    trigger_ = Config::configuration()->value<QString>(name() + "/iio_trigger", "");
+    bufferLength_ = qMax(Config::configuration()->value<int>(name() + "/iio_buffer_length", 128), 1);
+
+    if (devicePath_.isEmpty() || !readScanElements() || !addPath(chardev)) {
+        sensordLogW() << "IIO device not available for: " << name();
+        setValid(false);
+        return;
+    }
+
+    readBuffer_.resize(scanSize_ * bufferLength_);
+
+    QByteArray frequency = readFromFile((devicePath_ + "/sampling_frequency").toLocal8Bit());
+    double hz = frequency.trimmed().toDouble();
+    cachedInterval_ = hz > 0 ? (unsigned int)(1000 / hz) : 0;
+
+    introduceAvailableDataRanges(name());
+    introduceAvailableIntervals(name());
+    setDefaultInterval(Config::configuration()->value<int>(name() + "/default_interval", 0));
+}
+
+bool IioAdaptor::parseType(const QString& type, IioChannel& channel)
+{
+    QRegExp format("^(le|be):([su])(\\d+)/(\\d+)(?:X(\\d+))?>>(\\d+)$");
+    if (!format.exactMatch(type.trimmed()))
+        return false;
+
+    channel.bigEndian = format.cap(1) == "be";
+    channel.isSigned = format.cap(2) == "s";
+    channel.bits = format.cap(3).toInt();
+    channel.storageBits = format.cap(4).toInt();
+    channel.repeat = format.cap(5).isEmpty() ? 1 : format.cap(5).toInt();
+    channel.shift = format.cap(6).toInt();
+
+    int storage = channel.storageBits;
+    return (storage == 8 || storage == 16 || storage == 32 || storage == 64) &&
+           channel.bits > 0 && channel.bits + channel.shift <= storage && channel.repeat > 0;
+}
+
+bool IioAdaptor::readScanElements()
+{
+    QDir dir(devicePath_ + "/scan_elements");
+    QStringList enableFiles = dir.entryList(QStringList() << "in_*_en", QDir::Files);
+    if (enableFiles.isEmpty()) {
+        sensordLogW() << "No scan elements in " << dir.path();
+        return false;
+    }
+
+    allNames_.clear();
+    channels_.clear();
+    foreach (const QString& file, enableFiles) {
+        QString channelName = file.mid(3, file.size() - 6);
+        allNames_.append(channelName);
+        if (!enabledNames_.contains(channelName))
+            continue;
+
+        IioChannel channel;
+        channel.name = channelName;
+        QString prefix = dir.filePath("in_" + channelName);
+        QByteArray index = readFromFile((prefix + "_index").toLocal8Bit());
+        QByteArray type = readFromFile((prefix + "_type").toLocal8Bit());
+        bool ok = false;
+        channel.index = index.trimmed().toInt(&ok);
+        if (!ok || !parseType(QString::fromLatin1(type), channel)) {
+            sensordLogW() << "Invalid scan element " << channelName << ": index '" << index.trimmed()
+                          << "' type '" << type.trimmed() << "'";
+            return false;
+        }
+        channels_.append(channel);
+    }
+
+    foreach (const QString& channelName, enabledNames_) {
+        if (!allNames_.contains(channelName)) {
+            sensordLogW() << "Scan element " << channelName << " not found in " << dir.path();
+            return false;
+        }
+    }
+    if (channels_.isEmpty())
+        return false;
+
+    // Same layout rules as the kernel: every element is aligned to its
+    // own size and the scan to its largest element.
+    qSort(channels_.begin(), channels_.end(), channelIndexLessThan);
+    int bytes = 0;
+    int largest = 1;
+    timestampChannel_ = -1;
+    for (int i = 0; i < channels_.size(); ++i) {
+        IioChannel& channel = channels_[i];
+        int length = channel.storageBits / 8 * channel.repeat;
+        bytes = (bytes + length - 1) / length * length;
+        channel.offset = bytes;
+        bytes += length;
+        largest = qMax(largest, length);
+        if (channel.name == "timestamp")
+            timestampChannel_ = i;
+    }
+    scanSize_ = (bytes + largest - 1) / largest * largest;
+    sensordLogD() << name() << " scan size " << scanSize_ << " bytes, " << channels_.size() << " channel(s)";
+    return true;
+}
+
+bool IioAdaptor::enableBuffer(bool enable)
+{
+    QByteArray path = devicePath_.toLocal8Bit();
+    if (!enable)
+        return writeToFile(path + "/buffer/enable", "0");
+
+    // Scan elements, trigger and length can only be changed while the
+    // buffer is disabled.
+    writeToFile(path + "/buffer/enable", "0");
+    foreach (const QString& channelName, allNames_) {
+        QByteArray file = path + "/scan_elements/in_" + channelName.toLocal8Bit() + "_en";
+        if (!writeToFile(file, enabledNames_.contains(channelName) ? "1" : "0"))
+            return false;
+    }
+    if (!trigger_.isEmpty() && !writeToFile(path + "/trigger/current_trigger", trigger_.toLocal8Bit()))
+        return false;
+    if (!writeToFile(path + "/buffer/length", QByteArray::number(bufferLength_)))
+        return false;
+    // Device timestamps default to the realtime clock on most kernels.
+    if (timestampChannel_ >= 0) {
+        monotonicClock_ = writeToFile(path + "/current_timestamp_clock", "monotonic");
+        if (!monotonicClock_)
+            sensordLogW() << "Cannot use monotonic clock for IIO timestamps of " << name() << ", using read time";
+    }
+    return writeToFile(path + "/buffer/enable", "1");
+}
+
+bool IioAdaptor::startSensor()
+{
+    bool wasRunning = isRunning();
+    if (!wasRunning) {
+        pending_ = 0;
+        if (!enableBuffer(true)) {
+            sensordLogW() << "Failed to enable IIO buffer for " << name();
+            return false;
+        }
+    }
+    bool ret = SysfsAdaptor::startSensor();
+    if (!wasRunning && !isRunning())
+        enableBuffer(false);
+    return ret;
+}
+
+void IioAdaptor::stopSensor()
+{
+    SysfsAdaptor::stopSensor();
+    if (!isRunning())
+        enableBuffer(false);
+}
+
+void IioAdaptor::processSample(int pathId, int fd)
+{
+    Q_UNUSED(pathId);
+
+    int bytes = read(fd, readBuffer_.data() + pending_, readBuffer_.size() - pending_);
+    if (bytes <= 0) {
+        if (bytes == -1 && errno != EAGAIN)
+            sensordLogW() << "Failed to read IIO device of " << name() << ": " << strerror(errno);
+        return;
+    }
+    ++reads_;
+
+    // A read may end in the middle of a scan, keep the partial scan
+    // for the next read.
+    pending_ += bytes;
+    unsigned count = pending_ / scanSize_;
+    if (count) {
+        scans_ += count;
+        processScans(readBuffer_.constData(), count);
+        int used = count * scanSize_;
+        pending_ -= used;
+        if (pending_)
+            memmove(readBuffer_.data(), readBuffer_.constData() + used, pending_);
+    }
+}
+
+void IioAdaptor::statistics(quint64& reads, quint64& scans) const
+{
+    reads = reads_;
+    scans = scans_;
+}
+
+int IioAdaptor::channel(const QString& name) const
+{
+    for (int i = 0; i < channels_.size(); ++i) {
+        if (channels_.at(i).name == name)
+            return i;
+    }
+    return -1;
+}
+
+const QVector<IioChannel>& IioAdaptor::channels() const
+{
+    return channels_;
+}
+
+int IioAdaptor::scanSize() const
+{
+    return scanSize_;
+}
+
+unsigned int IioAdaptor::interval() const
+{
+    return cachedInterval_;
+}
+
+bool IioAdaptor::setInterval(const unsigned int value, const int sessionId)
+{
+    Q_UNUSED(sessionId);
+
+    if (!value)
+        return true;
+    QByteArray path = (devicePath_ + "/sampling_frequency").toLocal8Bit();
+    sensordLogD() << "Setting sampling frequency of " << name() << " to " << 1000.0 / value << " Hz";
+    if (writeToFile(path, QByteArray::number(1000.0 / value))) {
+        cachedInterval_ = value;
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,291 @@
+/**
+   @file iioadaptor.h
+   @brief IioAdaptor
+
+   <p>
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef IIOADAPTOR_H
+#define IIOADAPTOR_H
+
+#include "sysfsadaptor.h"
+#include "deviceadaptorringbuffer.h"
+#include "datatypes/utils.h"
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QByteArray>
+
+/**
+ * Description of an IIO scan element.
+ */
+struct IioChannel
+{
+    IioChannel() :
+        index(0), isSigned(false), bigEndian(false),
+        bits(0), storageBits(0), repeat(1), shift(0), offset(0) {}
+
+    QString name;        /**< channel name without in_ prefix, e.g. accel_x */
+    int     index;       /**< position in the scan */
+    bool    isSigned;    /**< is value signed */
+    bool    bigEndian;   /**< is value stored big endian */
+    int     bits;        /**< number of valid bits */
+    int     storageBits; /**< bits used to store the value */
+    int     repeat;      /**< number of repeated values */
+    int     shift;       /**< right shift applied before masking */
+    int     offset;      /**< byte offset in the scan */
+};
+
+/**
+ * @brief Base class for adaptors reading Linux Industrial I/O devices
+ * in buffered mode.
+ *
+ * The adaptor enables the configured scan elements, the trigger and the
+ * buffer of the device through sysfs and reads packed scans from the
+ * character device. Each read returns as many complete scans as are
+ * available, which are handed to #processScans() together so that
+ * subclasses can decode them into their ring buffer in bulk and wake
+ * up the readers once per read, or once per ring buffer capacity when
+ * the read holds more scans than fit into the ring buffer.
+ *
+ * Timestamps come from the <tt>timestamp</tt> scan element when it is
+ * enabled and the clock of the device can be switched to the monotonic
+ * clock through <tt>current_timestamp_clock</tt>, otherwise the time of
+ * the read is used, so that samples are never stamped with a different
+ * clock than the rest of sensord uses.
+ *
+ * Configuration keys in the group of the adaptor:
+ * <ul>
+ *   <li><tt>iio_device</tt> - sysfs directory of the device, e.g.
+ *       /sys/bus/iio/devices/iio:device0.</li>
+ *   <li><tt>iio_chardev</tt> - character device, defaults to /dev/ and the
+ *       name of the sysfs directory.</li>
+ *   <li><tt>iio_channels</tt> - scan elements to enable, e.g.
+ *       accel_x,accel_y,accel_z,timestamp.</li>
+ *   <li><tt>iio_trigger</tt> - trigger to use, if any.</li>
+ *   <li><tt>iio_buffer_length</tt> - buffer length in scans, default 128.</li>
+ * </ul>
+ */
+class IioAdaptor : public SysfsAdaptor
+{
+public:
+    /**
+     * Constructor.
+     *
+     * @param id The id for the adaptor.
+     */
+    IioAdaptor(const QString& id);
+
+    /**
+     * Destructor.
+     */
+    virtual ~IioAdaptor();
+
+    virtual void init();
+
+    virtual bool startSensor();
+
+    virtual void stopSensor();
+
+    /**
+     * Parse the type of a scan element, e.g. <tt>le:s12/16>>4</tt>.
+     *
+     * @param type Content of the in_*_type file.
+     * @param channel Channel to fill.
+     * @return was the type valid.
+     */
+    static bool parseType(const QString& type, IioChannel& channel);
+
+    /**
+     * Decode value of a channel from a scan. The value is shifted,
+     * masked and sign extended.
+     *
+     * @param scan First byte of the scan.
+     * @param channel Channel.
+     * @return channel value.
+     */
+    static qint64 decode(const char* scan, const IioChannel& channel)
+    {
+        const unsigned char* data = (const unsigned char*)scan + channel.offset;
+        int bytes = channel.storageBits / 8;
+        quint64 raw = 0;
+        for (int i = 0; i < bytes; ++i)
+            raw |= (quint64)data[channel.bigEndian ? bytes - 1 - i : i] << (8 * i);
+        raw >>= channel.shift;
+        if (channel.bits < 64) {
+            quint64 mask = ((quint64)1 << channel.bits) - 1;
+            raw &= mask;
+            if (channel.isSigned && (raw >> (channel.bits - 1)))
+                raw |= ~mask;
+        }
+        return (qint64)raw;
+    }
+
+    /**
+     * Number of reads from the character device and scans received.
+     *
+     * @param reads Number of reads.
+     * @param scans Number of scans.
+     */
+    void statistics(quint64& reads, quint64& scans) const;
+
+protected:
+    /**
+     * Handle complete scans read from the device. Called from the
+     * reactor thread.
+     *
+     * @param scans First byte of the first scan, scans follow each
+     *              other #scanSize() bytes apart.
+     * @param count Number of scans.
+     */
+    virtual void processScans(const char* scans, unsigned count) = 0;
+
+    /**
+     * Index of an enabled channel in #channels().
+     *
+     * @param name Channel name, e.g. accel_x.
+     * @return channel index, -1 if not enabled.
+     */
+    int channel(const QString& name) const;
+
+    /**
+     * Enabled channels in scan order.
+     *
+     * @return channels.
+     */
+    const QVector<IioChannel>& channels() const;
+
+    /**
+     * Size of a single scan in bytes.
+     *
+     * @return scan size.
+     */
+    int scanSize() const;
+
+    /**
+     * Timestamp of a scan in microseconds, from the timestamp channel
+     * if enabled and running on the monotonic clock.
+     *
+     * @param scan First byte of the scan.
+     * @param now Time to use without timestamp channel.
+     * @return timestamp.
+     */
+    quint64 timestamp(const char* scan, quint64 now) const
+    {
+        return timestampChannel_ >= 0 && monotonicClock_ ? decode(scan, channels_.at(timestampChannel_)) / 1000 : now;
+    }
+
+    /**
+     * Decode three channels of each scan into XYZ samples of a ring
+     * buffer and wake up its readers once, or once per buffer capacity
+     * so that samples are not overwritten before readers see them.
+     *
+     * @tparam TYPE sample type with timestamp_, x_, y_ and z_ members.
+     * @param scans First byte of the first scan.
+     * @param count Number of scans.
+     * @param x Channel index of x axis.
+     * @param y Channel index of y axis.
+     * @param z Channel index of z axis.
+     * @param buffer Ring buffer.
+     */
+    template <class TYPE>
+    void decodeXyz(const char* scans, unsigned count, int x, int y, int z, DeviceAdaptorRingBuffer<TYPE>* buffer)
+    {
+        const IioChannel& xChannel = channels_.at(x);
+        const IioChannel& yChannel = channels_.at(y);
+        const IioChannel& zChannel = channels_.at(z);
+        unsigned capacity = buffer->size();
+        quint64 now = Utils::getTimeStamp();
+        for (unsigned i = 1; i <= count; ++i, scans += scanSize_) {
+            TYPE* sample = buffer->nextSlot();
+            sample->timestamp_ = timestamp(scans, now);
+            sample->x_ = decode(scans, xChannel);
+            sample->y_ = decode(scans, yChannel);
+            sample->z_ = decode(scans, zChannel);
+            buffer->commit();
+            if (i % capacity == 0 || i == count)
+                buffer->wakeUpReaders();
+        }
+    }
+
+    /**
+     * Decode one channel of each scan into samples of a ring buffer and
+     * wake up its readers once, or once per buffer capacity so that
+     * samples are not overwritten before readers see them.
+     *
+     * @tparam TYPE sample type with timestamp_ and value_ members.
+     * @param scans First byte of the first scan.
+     * @param count Number of scans.
+     * @param value Channel index of the value.
+     * @param buffer Ring buffer.
+     */
+    template <class TYPE>
+    void decodeValue(const char* scans, unsigned count, int value, DeviceAdaptorRingBuffer<TYPE>* buffer)
+    {
+        const IioChannel& valueChannel = channels_.at(value);
+        unsigned capacity = buffer->size();
+        quint64 now = Utils::getTimeStamp();
+        for (unsigned i = 1; i <= count; ++i, scans += scanSize_) {
+            TYPE* sample = buffer->nextSlot();
+            sample->timestamp_ = timestamp(scans, now);
+            sample->value_ = decode(scans, valueChannel);
+            buffer->commit();
+            if (i % capacity == 0 || i == count)
+                buffer->wakeUpReaders();
+        }
+    }
+
+    void processSample(int pathId, int fd);
+
+    virtual unsigned int interval() const;
+
+    virtual bool setInterval(const unsigned int value, const int sessionId);
+
+private:
+    /**
+     * Read scan element descriptions and compute the scan layout.
+     *
+     * @return was the device usable.
+     */
+    bool readScanElements();
+
+    /**
+     * Enable or disable the buffer of the device, enabling the scan
+     * elements and trigger first.
+     *
+     * @param enable Enable or disable.
+     * @return was the buffer switched.
+     */
+    bool enableBuffer(bool enable);
+
+    QString             devicePath_;       /**< sysfs directory of the device */
+    QStringList         enabledNames_;     /**< configured channel names */
+    QStringList         allNames_;         /**< all scan elements of the device */
+    QString             trigger_;          /**< trigger name */
+    int                 bufferLength_;     /**< buffer length in scans */
+    QVector<IioChannel> channels_;         /**< enabled channels in scan order */
+    int                 scanSize_;         /**< bytes per scan */
+    int                 timestampChannel_; /**< index of timestamp channel, -1 if none */
+    bool                monotonicClock_;   /**< does the timestamp channel use the monotonic clock */
+    QByteArray          readBuffer_;       /**< read buffer */
+    int                 pending_;          /**< bytes of an incomplete scan in readBuffer_ */
+    unsigned int        cachedInterval_;   /**< interval from sampling_frequency */
+    quint64             reads_;            /**< number of reads */
+    quint64             scans_;            /**< number of scans */
+};
+
+#endif // IIOADAPTOR_H
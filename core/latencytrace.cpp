@@ -0,0 +1,191 @@
+/**
+   @file latencytrace.cpp
+   @brief LatencyTrace
+
+   <p>
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include "latencytrace.h"
+#include "genericdata.h"
+#include "utils.h"
+#include <QMutex>
+#include <QMutexLocker>
+#include <QMap>
+#include <QList>
+#include <QVector>
+#include <algorithm>
+#include <string.h>
+
+/**
+ * Single trace record.
+ */
+struct LatencyTraceRecord
+{
+    quint64 key;     /**< object or session */
+    quint32 latency; /**< sample age in microseconds */
+    quint32 stage;   /**< LatencyTrace::Stage */
+};
+
+/**
+ * Trace buffer of a single thread. Written only by the owning thread,
+ * read by #LatencyTrace::report() from any thread. Records are kept as
+ * long as they are not overwritten, buffers of exited threads are kept
+ * for reporting.
+ */
+struct LatencyTraceBuffer
+{
+    static const unsigned int SIZE = 8192; /**< record count, power of two */
+
+    LatencyTraceBuffer() : writeCount(0), filled(false) {}
+
+    LatencyTraceRecord records[SIZE]; /**< record ring */
+    unsigned int       writeCount;    /**< records written, published with release, wraps */
+    bool               filled;        /**< has the ring been filled once */
+};
+
+/**
+ * Name of a trace key. Stage kind selects the key space.
+ */
+struct LatencyTraceName
+{
+    bool    session; /**< is key a session ID */
+    quint64 key;     /**< key */
+
+    bool operator<(const LatencyTraceName& other) const
+    {
+        return session != other.session ? session < other.session : key < other.key;
+    }
+};
+
+static QMutex traceMutex;
+static QList<LatencyTraceBuffer*> traceBuffers;
+static QMap<LatencyTraceName, QString> traceNames;
+static __thread LatencyTraceBuffer* threadTraceBuffer = NULL;
+
+static const char* const STAGE_NAMES[LatencyTrace::StageCount] = {
+    "commit",
+    "propagate",
+    "writeToSession",
+    "dispatch",
+    "socketWrite"
+};
+
+quint64 latencyTraceTimestamp(const TimedData* value)
+{
+    return value->timestamp_;
+}
+
+void LatencyTrace::record(Stage stage, quint64 key, quint64 timestamp)
+{
+    if (!timestamp)
+        return;
+
+    quint64 now = Utils::getTimeStamp();
+    if (now < timestamp)
+        return;
+
+    LatencyTraceBuffer* buffer = threadTraceBuffer;
+    if (!buffer) {
+        buffer = new LatencyTraceBuffer;
+        QMutexLocker locker(&traceMutex);
+        traceBuffers.append(buffer);
+        threadTraceBuffer = buffer;
+    }
+
+    unsigned int writeCount = buffer->writeCount;
+    LatencyTraceRecord& record = buffer->records[writeCount & (LatencyTraceBuffer::SIZE - 1)];
+    record.key = key;
+    record.latency = (quint32)qMin(now - timestamp, (quint64)0xffffffff);
+    record.stage = stage;
+    if (writeCount + 1 == LatencyTraceBuffer::SIZE)
+        __atomic_store_n(&buffer->filled, true, __ATOMIC_RELAXED);
+    __atomic_store_n(&buffer->writeCount, writeCount + 1, __ATOMIC_RELEASE);
+}
+
+void LatencyTrace::recordPayload(Stage stage, int sessionId, const void* source, int size, unsigned int count)
+{
+    if (size < (int)sizeof(quint64))
+        return;
+
+    for (unsigned int i = 0; i < count; ++i) {
+        quint64 timestamp;
+        memcpy(&timestamp, (const char*)source + i * size, sizeof(timestamp));
+        record(stage, sessionId, timestamp);
+    }
+}
+
+void LatencyTrace::setObjectName(const void* object, const QString& name)
+{
+    LatencyTraceName key = { false, (quint64)(quintptr)object };
+    QMutexLocker locker(&traceMutex);
+    traceNames.insert(key, name);
+}
+
+void LatencyTrace::setSessionName(int sessionId, const QString& name)
+{
+    LatencyTraceName key = { true, (quint64)sessionId };
+    QMutexLocker locker(&traceMutex);
+    traceNames.insert(key, name);
+}
+
+void LatencyTrace::report(QStringList& output)
+{
+    QMap<QString, QVector<quint32> > latencies[StageCount];
+    {
+        QMutexLocker locker(&traceMutex);
+        foreach (LatencyTraceBuffer* buffer, traceBuffers) {
+            unsigned int end = __atomic_load_n(&buffer->writeCount, __ATOMIC_ACQUIRE);
+            unsigned int begin = __atomic_load_n(&buffer->filled, __ATOMIC_RELAXED) ? end - LatencyTraceBuffer::SIZE : 0;
+            QVector<LatencyTraceRecord> records;
+            records.reserve(end - begin);
+            for (unsigned int i = begin; i != end; ++i)
+                records.append(buffer->records[i & (LatencyTraceBuffer::SIZE - 1)]);
+
+            // Drop records the owner may have overwritten while copying.
+            // Distances stay correct when the counter wraps around.
+            unsigned int after = __atomic_load_n(&buffer->writeCount, __ATOMIC_ACQUIRE);
+            for (unsigned int i = begin; i != end; ++i) {
+                if (after - i >= LatencyTraceBuffer::SIZE)
+                    continue;
+                const LatencyTraceRecord& record = records.at(i - begin);
+                if (record.stage >= (quint32)StageCount)
+                    continue;
+                LatencyTraceName key = { record.stage >= (quint32)WriteToSession, record.key };
+                QString name = traceNames.value(key);
+                if (name.isEmpty())
+                    name = key.session ? QString("session %1").arg(record.key) : QString("0x%1").arg(record.key, 0, 16);
+                latencies[record.stage][name].append(record.latency);
+            }
+        }
+    }
+
+    output.append("  Latency (p50/p99/max us):");
+    for (int stage = 0; stage < StageCount; ++stage) {
+        for (QMap<QString, QVector<quint32> >::iterator it = latencies[stage].begin(); it != latencies[stage].end(); ++it) {
+            QVector<quint32>& values = it.value();
+            std::sort(values.begin(), values.end());
+            int n = values.size();
+            output.append(QString("    %1 %2: %3/%4/%5, %6 samples")
+                          .arg(STAGE_NAMES[stage])
+                          .arg(it.key())
+                          .arg(values.at((n - 1) * 50 / 100))
+                          .arg(values.at((n - 1) * 99 / 100))
+                          .arg(values.at(n - 1))
+                          .arg(n));
+        }
+    }
+}
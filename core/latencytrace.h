@@ -0,0 +1,137 @@
+/**
+   @file latencytrace.h
+   @brief LatencyTrace
+
+   <p>
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef LATENCYTRACE_H
+#define LATENCYTRACE_H
+
+#include <QtGlobal>
+#include <QString>
+#include <QStringList>
+
+class TimedData;
+
+/**
+ * Per-stage latency tracing of the sample pipeline.
+ *
+ * At each traced stage the age of the sample, measured from its
+ * TimedData timestamp to the monotonic clock, is recorded into a
+ * lock-free trace buffer owned by the calling thread. #report()
+ * summarizes the records currently held by all buffers as p50, p99
+ * and max per stage and sensor.
+ *
+ * Tracing is enabled by building with <tt>CONFIG+=latencytrace</tt>,
+ * which defines SENSORFW_LATENCY_TRACE. Otherwise the SENSORFW_TRACE_*
+ * macros expand to nothing and this file is not compiled.
+ */
+class LatencyTrace
+{
+public:
+    /**
+     * Traced stages in pipeline order.
+     */
+    enum Stage
+    {
+        Commit = 0,     /**< sample committed to adaptor ring buffer, keyed by buffer */
+        Propagate,      /**< sample propagated from a source, keyed by source */
+        WriteToSession, /**< sample written by sensor channel, keyed by session */
+        Dispatch,       /**< sample drained on the main thread, keyed by session */
+        SocketWrite,    /**< sample written to client socket, keyed by session */
+        StageCount
+    };
+
+    /**
+     * Record sample age at a stage.
+     *
+     * @param stage Stage.
+     * @param key Object or session identifying the hop.
+     * @param timestamp Sample timestamp in microseconds. Zero is ignored.
+     */
+    static void record(Stage stage, quint64 key, quint64 timestamp);
+
+    /**
+     * Record age of each sample in a session payload. Payload samples
+     * begin with TimedData.
+     *
+     * @param stage Stage.
+     * @param sessionId Session ID.
+     * @param source Payload.
+     * @param size Size of single sample.
+     * @param count Number of samples.
+     */
+    static void recordPayload(Stage stage, int sessionId, const void* source, int size, unsigned int count);
+
+    /**
+     * Name object used as key for #Commit and #Propagate stages.
+     *
+     * @param object Object.
+     * @param name Name.
+     */
+    static void setObjectName(const void* object, const QString& name);
+
+    /**
+     * Name session used as key for session stages.
+     *
+     * @param sessionId Session ID.
+     * @param name Name, normally sensor ID.
+     */
+    static void setSessionName(int sessionId, const QString& name);
+
+    /**
+     * Append latency summary to given list.
+     *
+     * @param output List to append to.
+     */
+    static void report(QStringList& output);
+};
+
+/**
+ * Timestamp of a traced sample.
+ *
+ * @param value Sample.
+ * @return timestamp in microseconds.
+ */
+quint64 latencyTraceTimestamp(const TimedData* value);
+
+/**
+ * Timestamp of a traced value without TimedData.
+ *
+ * @return always zero, value is not traced.
+ */
+inline quint64 latencyTraceTimestamp(const void*)
+{
+    return 0;
+}
+
+#ifdef SENSORFW_LATENCY_TRACE
+#define SENSORFW_TRACE_SAMPLE(stage, key, value) \
+    LatencyTrace::record(LatencyTrace::stage, (quint64)(quintptr)(key), latencyTraceTimestamp(&(value)))
+#define SENSORFW_TRACE_PAYLOAD(stage, sessionId, source, size, count) \
+    LatencyTrace::recordPayload(LatencyTrace::stage, sessionId, source, size, count)
+#define SENSORFW_TRACE_OBJECT_NAME(object, name) LatencyTrace::setObjectName(object, name)
+#define SENSORFW_TRACE_SESSION_NAME(sessionId, name) LatencyTrace::setSessionName(sessionId, name)
+#else
+#define SENSORFW_TRACE_SAMPLE(stage, key, value) do {} while (0)
+#define SENSORFW_TRACE_PAYLOAD(stage, sessionId, source, size, count) do {} while (0)
+#define SENSORFW_TRACE_OBJECT_NAME(object, name) do {} while (0)
+#define SENSORFW_TRACE_SESSION_NAME(sessionId, name) do {} while (0)
+#endif
+
+#endif // LATENCYTRACE_H
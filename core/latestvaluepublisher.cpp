@@ -0,0 +1,155 @@
+/**
+   @file latestvaluepublisher.cpp
+   @brief LatestValuePublisher
+
+   <p>
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include "latestvaluepublisher.h"
+#include "latestvaluepage.h"
+#include "config.h"
+#include "logging.h"
+
+#include <QMutex>
+#include <QMutexLocker>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <grp.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+
+namespace {
+
+/**
+ * Owner of the page mapping. Clears the page on destruction so that
+ * clients fall back to D-Bus.
+ */
+class PageOwner
+{
+public:
+    PageOwner() : memory_(MAP_FAILED), writer_(NULL), failed_(false) {}
+
+    ~PageOwner()
+    {
+        if (!writer_)
+            return;
+        writer_->close();
+        delete writer_;
+        munmap(memory_, latestValuePageSize());
+        unlink(LATEST_VALUE_PAGE_PATH);
+    }
+
+    /**
+     * Page writer, created on first call. Called with mutex_ held.
+     *
+     * @return writer, NULL if the page could not be created.
+     */
+    LatestValuePageWriter* writer()
+    {
+        if (writer_ || failed_)
+            return writer_;
+        failed_ = true;
+
+        // Never reuse a page left behind by a previous instance, clients
+        // may still have it mapped.
+        unlink(LATEST_VALUE_PAGE_PATH);
+        int fd = open(LATEST_VALUE_PAGE_PATH, O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0600);
+        if (fd == -1) {
+            sensordLogW() << "Failed to create latest value page: " << strerror(errno);
+            return NULL;
+        }
+        if (!setAccess(fd)) {
+            close(fd);
+            unlink(LATEST_VALUE_PAGE_PATH);
+            return NULL;
+        }
+        if (ftruncate(fd, latestValuePageSize()) == -1) {
+            sensordLogW() << "Failed to size latest value page: " << strerror(errno);
+            close(fd);
+            unlink(LATEST_VALUE_PAGE_PATH);
+            return NULL;
+        }
+        memory_ = mmap(NULL, latestValuePageSize(), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (memory_ == MAP_FAILED) {
+            sensordLogW() << "Failed to map latest value page: " << strerror(errno);
+            unlink(LATEST_VALUE_PAGE_PATH);
+            return NULL;
+        }
+        writer_ = new LatestValuePageWriter(memory_, getpid());
+        failed_ = false;
+        return writer_;
+    }
+
+    QMutex mutex_; /**< guards creation of the page */
+
+private:
+    /**
+     * Restrict the page to the group configured in
+     * <tt>global/latest_value_group</tt>, otherwise make it world
+     * readable.
+     *
+     * @param fd Descriptor of the page.
+     * @return was access set.
+     */
+    bool setAccess(int fd)
+    {
+        QString group = Config::configuration()->value<QString>("global/latest_value_group", "");
+        if (group.isEmpty())
+            return fchmod(fd, 0644) == 0;
+
+        struct group* entry = getgrnam(group.toLocal8Bit().constData());
+        if (!entry) {
+            sensordLogW() << "Unknown latest value page group " << group << ", not publishing latest values";
+            return false;
+        }
+        if (fchown(fd, -1, entry->gr_gid) == -1 || fchmod(fd, 0640) == -1) {
+            sensordLogW() << "Failed to restrict latest value page to group " << group << ": " << strerror(errno);
+            return false;
+        }
+        return true;
+    }
+
+    void*                  memory_;
+    LatestValuePageWriter* writer_;
+    bool                   failed_;
+};
+
+PageOwner& owner()
+{
+    static PageOwner instance;
+    return instance;
+}
+
+}
+
+LatestValuePageWriter* LatestValuePublisher::addChannel(const QString& id, int& slot)
+{
+    PageOwner& page = owner();
+    QMutexLocker locker(&page.mutex_);
+    LatestValuePageWriter* writer = page.writer();
+    if (!writer)
+        return NULL;
+    slot = writer->addChannel(id.toLatin1().constData());
+    if (slot < 0) {
+        sensordLogW() << "No latest value slot for channel " << id;
+        return NULL;
+    }
+    return writer;
+}
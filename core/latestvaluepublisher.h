@@ -0,0 +1,56 @@
+/**
+   @file latestvaluepublisher.h
+   @brief LatestValuePublisher
+
+   <p>
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef LATESTVALUEPUBLISHER_H
+#define LATESTVALUEPUBLISHER_H
+
+#include <QString>
+
+class LatestValuePageWriter;
+
+/**
+ * Daemon side of the latest value page. Sensor channels visible to
+ * clients get a slot in a page at #LATEST_VALUE_PAGE_PATH which holds
+ * their most recent sample, so that clients can implement synchronous
+ * getters without a D-Bus roundtrip.
+ *
+ * Reading the page bypasses the D-Bus policy. By default it is world
+ * readable; with <tt>global/latest_value_group</tt> configured only
+ * members of that group can read it, other clients use D-Bus.
+ *
+ * The page is created on first use and removed when sensord exits.
+ */
+class LatestValuePublisher
+{
+public:
+    /**
+     * Allocate slot for a channel. The returned writer stays valid
+     * until sensord exits and may be used without further locking to
+     * write the allocated slot.
+     *
+     * @param id Channel ID.
+     * @param slot Set to the slot index.
+     * @return page writer, NULL if the page is not available or full.
+     */
+    static LatestValuePageWriter* addChannel(const QString& id, int& slot);
+};
+
+#endif // LATESTVALUEPUBLISHER_H
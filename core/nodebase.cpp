@@ -27,6 +27,7 @@
 #include "nodebase.h"
 #include "logging.h"
 #include "ringbuffer.h"
+#include "chainexecutor.h"
 #include "config.h"
 
 NodeBase::NodeBase(const QString& id, QObject* parent) :
@@ -316,6 +317,8 @@ unsigned int NodeBase::getInterval(int sessionId) const
 
 bool NodeBase::setIntervalRequest(const int sessionId, const unsigned int value)
 {
+    ChainExecutor::Pause pause(processingExecutors());
+
     // Has single defined source, pass the request that way
     if (!hasLocalInterval())
     {
@@ -482,6 +485,7 @@ bool NodeBase::requestDefaultInterval(const int sessionId)
 
 void NodeBase::removeIntervalRequest(const int sessionId)
 {
+    ChainExecutor::Pause pause(processingExecutors());
     unsigned int previousInterval = interval();
 
     foreach (NodeBase *source, m_sourceList)
@@ -522,12 +526,20 @@ bool NodeBase::connectToSource(NodeBase* source, const QString& bufferName, Ring
         return false;
     }
 
+    ChainExecutor::Pause pause(processingExecutors() + source->processingExecutors());
+    ChainExecutor* chainExecutor = executor();
+    if (chainExecutor && !reader->setExecutor(chainExecutor))
+        sensordLogW() << "Reader of buffer '" << bufferName << "' runs inline in worker node: " << id();
+
     bool success = rb->join(reader);
+    if (!success && chainExecutor)
+        reader->setExecutor(NULL);
 
     if (success)
     {
         // Store a reference to the source
         m_sourceList.append(source);
+        m_readerList.append(reader);
     }
 
     return success;
@@ -542,7 +554,9 @@ bool NodeBase::disconnectFromSource(NodeBase* source, const QString& bufferName,
         return false;
     }
 
+    ChainExecutor::Pause pause(processingExecutors() + source->processingExecutors());
     bool success = rb->unjoin(reader);
+    reader->setExecutor(NULL);
 
     if (success)
     {
@@ -551,11 +565,44 @@ bool NodeBase::disconnectFromSource(NodeBase* source, const QString& bufferName,
         {
             sensordLogW() << "Buffer '" << bufferName << "' not disconnected properly for node: " << id();
         }
+        m_readerList.removeOne(reader);
+    }
+
+    return success;
+}
+
+bool NodeBase::connectToBuffer(RingBufferBase* buffer, RingBufferReaderBase* reader)
+{
+    bool success = buffer->join(reader);
+
+    if (success)
+    {
+        m_readerList.append(reader);
     }
 
     return success;
 }
 
+QList<ChainExecutor*> NodeBase::processingExecutors() const
+{
+    QList<ChainExecutor*> executors;
+    if (executor())
+        executors.append(executor());
+    foreach (NodeBase* source, m_sourceList)
+        executors += source->processingExecutors();
+    return executors;
+}
+
+quint64 NodeBase::lostSamples() const
+{
+    quint64 lost = 0;
+    foreach (RingBufferReaderBase* reader, m_readerList)
+    {
+        lost += reader->lostSamples();
+    }
+    return lost;
+}
+
 bool NodeBase::isValidIntervalRequest(const unsigned int value) const
 {
     for(QList<DataRange>::const_iterator it = m_intervalList.constBegin(); it != m_intervalList.constEnd(); ++it)
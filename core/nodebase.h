@@ -35,6 +35,7 @@
 
 class RingBufferReaderBase;
 class RingBufferBase;
+class ChainExecutor;
 
 /**
  * Base class for all nodes in sensord framework filtering chain.
@@ -49,6 +50,7 @@ class NodeBase : public QObject
     Q_PROPERTY(unsigned int interval READ getInterval)
     Q_PROPERTY(QString id READ id)
     Q_PROPERTY(bool isValid READ isValid)
+    Q_PROPERTY(quint64 lostSamples READ lostSamples)
 
 protected:
     /**
@@ -293,6 +295,31 @@ public Q_SLOTS:
      */
     virtual void removeSession(int sessionId);
 
+    /**
+     * Number of samples dropped by the ring buffer readers of this node
+     * because they fell too far behind their source buffers.
+     *
+     * @return lost sample count.
+     */
+    quint64 lostSamples() const;
+
+    /**
+     * Executor processing input of this node on a worker thread.
+     * Readers connected with #connectToSource() are handed over to it.
+     *
+     * @return executor, NULL if input is processed inline.
+     */
+    virtual ChainExecutor* executor() const { return NULL; }
+
+    /**
+     * Executors which may be processing this node: its own and the ones
+     * of its sources. Pause them with #ChainExecutor::Pause before
+     * changing the node from the main thread.
+     *
+     * @return executors, may contain duplicates.
+     */
+    QList<ChainExecutor*> processingExecutors() const;
+
 Q_SIGNALS:
     /**
      * Property value has changed signal.
@@ -329,6 +356,16 @@ protected:
      */
     bool disconnectFromSource(NodeBase* source, const QString& bufferName, RingBufferReaderBase* reader);
 
+    /**
+     * Connect reader to a buffer owned by this node. Reader is accounted
+     * in #lostSamples().
+     *
+     * @param buffer buffer to connect to.
+     * @param reader reader to connect.
+     * @return was connection succesful.
+     */
+    bool connectToBuffer(RingBufferBase* buffer, RingBufferReaderBase* reader);
+
     /**
      * Validates the metadata setup for the node. To pass, exactly one
      * of the following conditions must be fullfilled for each propagative
@@ -561,6 +598,7 @@ private:
     unsigned int            m_defaultInterval; /**< locally set interval */
 
     QList<NodeBase*>        m_sourceList; /**< source nodes */
+    QList<RingBufferReaderBase*> m_readerList; /**< connected readers */
 
     //Oldest session wins for these:
     QMap<int, unsigned int> m_bufferSizeMap; /**< buffersize requests for sessions. */
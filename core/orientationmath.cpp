@@ -0,0 +1,129 @@
+/**
+   @file orientationmath.cpp
+   @brief OrientationMath
+
+   <p>
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include "orientationmath.h"
+#include "config.h"
+#include "logging.h"
+#include <math.h>
+
+static const char* const NAMES[] = { "exact", "fast", "coarse" };
+
+/**
+ * Arctangent of x for |x| <= 1.
+ */
+static inline double atanUnit(double x, OrientationMath::Precision precision)
+{
+    if (precision == OrientationMath::Coarse) {
+        // Rajan et al., "Efficient approximations for the arctangent function"
+        double ax = fabs(x);
+        return M_PI_4 * x - x * (ax - 1) * (0.2447 + 0.0663 * ax);
+    }
+
+    // Abramowitz & Stegun 4.4.49
+    double x2 = x * x;
+    return x * (0.9998660 + x2 * (-0.3302995 + x2 * (0.1801410 + x2 * (-0.0851330 + x2 * 0.0208351))));
+}
+
+OrientationMath::Precision OrientationMath::configuredPrecision()
+{
+    QString value = Config::configuration()->value<QString>("heading/precision", NAMES[Exact]);
+    for (int i = Exact; i <= Coarse; ++i) {
+        if (value == NAMES[i])
+            return (Precision)i;
+    }
+    sensordLogW() << "Unknown heading/precision '" << value << "', using " << NAMES[Exact];
+    return Exact;
+}
+
+const char* OrientationMath::name(Precision precision)
+{
+    return NAMES[precision];
+}
+
+double OrientationMath::atan2(double y, double x, Precision precision)
+{
+    if (precision == Exact)
+        return ::atan2(y, x);
+
+    if (x == 0 && y == 0)
+        return 0;
+
+    if (fabs(x) >= fabs(y)) {
+        double angle = atanUnit(y / x, precision);
+        if (x < 0)
+            angle += (y < 0) ? -M_PI : M_PI;
+        return angle;
+    }
+    return ((y < 0) ? -M_PI_2 : M_PI_2) - atanUnit(x / y, precision);
+}
+
+double OrientationMath::elevation(int a, int b, int c, Precision precision)
+{
+    if (precision == Exact)
+        return atan((double)a / sqrt(b * b + c * c));
+
+    return atan2(a, sqrt((double)b * b + (double)c * c), precision);
+}
+
+double OrientationMath::heading(double gx, double gy, double gz,
+                                double mx, double my, double mz,
+                                Precision precision)
+{
+    if (precision == Exact) {
+        // This algorithm is from Circuit Cellar Aug 2012 by Mark Pedley,
+        // Electronic Compass: Tilt Compensation & Calibration. There are
+        // no restrictions on your use of the software listed in the
+        // Circuit Cellar magazine. http://circuitcellar.com/
+        double divisor = sqrt(gx * gx + gy * gy + gz * gz);
+        gx /= divisor;
+        gy /= divisor;
+        gz /= divisor;
+
+        /* roll angle Phi (-180deg, 180deg), Equation 2 */
+        double phi = ::atan2(gy, gz);
+        double sinAngle = sin(phi);
+        double cosAngle = cos(phi);
+
+        /* de-rotate by roll angle Phi, Equation 5 y component */
+        double by = my * cosAngle - mz * sinAngle;
+        mz = my * sinAngle + mz * cosAngle;
+        gz = gy * sinAngle + gz * cosAngle;
+
+        /* pitch angle Theta (-90deg, 90deg), Equation 3 */
+        double theta = atan(-gx / gz);
+        sinAngle = sin(theta);
+        cosAngle = cos(theta);
+
+        /* de-rotate by pitch angle Theta, Equation 5 x component */
+        double bx = mx * cosAngle + mz * sinAngle;
+
+        /* yaw, Equation 7 */
+        return ::atan2(-by, bx);
+    }
+
+    // Horizontal field components are the x components of g x m and of
+    // g x (m x g), scaled by |g| and |g|^2 respectively.
+    double gg = gy * gy + gz * gz;
+    double gm = gy * my + gz * mz;
+    double east = sqrt(gg + gx * gx) * (gy * mz - gz * my);
+    double north = mx * gg - gx * gm;
+    return atan2(east, north, precision);
+}
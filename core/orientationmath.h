@@ -0,0 +1,113 @@
+/**
+   @file orientationmath.h
+   @brief OrientationMath
+
+   <p>
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef ORIENTATIONMATH_H
+#define ORIENTATIONMATH_H
+
+/**
+ * Angle computations shared by the heading and rotation filters.
+ *
+ * Each function takes a precision tier. #Exact evaluates the same libm
+ * expressions the filters have always used. The approximate tiers
+ * replace trigonometry with vector algebra and a polynomial arctangent:
+ * #Fast stays within 1.2e-5 rad of the exact arctangent, #Coarse within
+ * 0.0016 rad (0.09 degrees).
+ *
+ * The tier is configured with \c heading/precision in sensord.conf as
+ * one of \c exact, \c fast or \c coarse.
+ */
+class OrientationMath
+{
+public:
+    /**
+     * Precision tiers.
+     */
+    enum Precision
+    {
+        Exact = 0, /**< libm trigonometry */
+        Fast,      /**< vector algebra, 5th order arctangent */
+        Coarse     /**< vector algebra, 3rd order arctangent */
+    };
+
+    /**
+     * Precision tier configured in sensord.conf. Unknown values fall
+     * back to #Exact.
+     *
+     * @return configured precision.
+     */
+    static Precision configuredPrecision();
+
+    /**
+     * Name of a precision tier, as used in the configuration.
+     *
+     * @param precision Precision tier.
+     * @return name.
+     */
+    static const char* name(Precision precision);
+
+    /**
+     * Four quadrant arctangent of y/x.
+     *
+     * @param y Y coordinate.
+     * @param x X coordinate.
+     * @param precision Precision tier.
+     * @return angle in radians, in [-pi, pi].
+     */
+    static double atan2(double y, double x, Precision precision);
+
+    /**
+     * Angle between a vector and the plane of its other two axes,
+     * atan(a / sqrt(b^2 + c^2)).
+     *
+     * @param a Component normal to the plane.
+     * @param b First in-plane component.
+     * @param c Second in-plane component.
+     * @param precision Precision tier.
+     * @return angle in radians, in [-pi/2, pi/2].
+     */
+    static double elevation(int a, int b, int c, Precision precision);
+
+    /**
+     * Tilt compensated heading of a magnetic field vector, in aerospace
+     * coordinates (x forward, y right, z down).
+     *
+     * With the #Exact tier the device is de-rotated by roll and pitch
+     * angles as in "Electronic Compass: Tilt Compensation & Calibration"
+     * by Mark Pedley (Circuit Cellar, Aug 2012). The approximate tiers
+     * project the field onto the horizontal plane with cross products
+     * against gravity instead, which gives the same angle without
+     * evaluating sines and cosines.
+     *
+     * @param gx Gravity X.
+     * @param gy Gravity Y.
+     * @param gz Gravity Z.
+     * @param mx Magnetic field X.
+     * @param my Magnetic field Y.
+     * @param mz Magnetic field Z.
+     * @param precision Precision tier.
+     * @return heading in radians, in [-pi, pi].
+     */
+    static double heading(double gx, double gy, double gz,
+                          double mx, double my, double mz,
+                          Precision precision);
+};
+
+#endif // ORIENTATIONMATH_H
@@ -33,21 +33,105 @@
 #include "sink.h"
 #include "pusher.h"
 #include "logging.h"
-#include <QSet>
+#include "latencytrace.h"
+#include "subscriberlist.h"
+#include <string.h>
 
 template <class TYPE>
 class RingBuffer;
 
+class ChainExecutor;
+
+/**
+ * Name identifying the data type of a ring buffer or reader. Used for
+ * type checking buffer joins without RTTI. Names are compared by
+ * content as plugins may carry their own copies of the function.
+ *
+ * @tparam TYPE data type.
+ * @return type name.
+ */
+template <class TYPE>
+inline const char* ringBufferTypeName()
+{
+    return __PRETTY_FUNCTION__;
+}
+
+/**
+ * Copy helper for ring buffer spans. Trivially copyable types are
+ * copied with a single memcpy, others element by element.
+ *
+ * @tparam TYPE data type.
+ * @tparam TRIVIAL is the type trivially copyable.
+ */
+template <class TYPE, bool TRIVIAL = __is_trivially_copyable(TYPE)>
+struct RingBufferCopy
+{
+    static void copy(TYPE* to, const TYPE* from, unsigned n)
+    {
+        while (n--)
+            *to++ = *from++;
+    }
+};
+
+template <class TYPE>
+struct RingBufferCopy<TYPE, true>
+{
+    static void copy(TYPE* to, const TYPE* from, unsigned n)
+    {
+        if (n)
+            memcpy((void*)to, (const void*)from, n * sizeof(TYPE));
+    }
+};
+
 /**
  * Base-class for ring buffer reader subclasses.
  */
 class RingBufferReaderBase : public Pusher
 {
+public:
+    /**
+     * Name of the data type this reader accepts.
+     *
+     * @return type name.
+     */
+    const char* typeName() const { return typeName_; }
+
+    /**
+     * Number of samples overwritten in the buffer before this reader
+     * got to them. Safe to call from any thread.
+     *
+     * @return lost sample count.
+     */
+    quint64 lostSamples() const { return __atomic_load_n(&lost_, __ATOMIC_RELAXED); }
+
+    /**
+     * Hand processing of new data over to an executor instead of doing
+     * it when woken up. Readers which don't support this keep
+     * processing inline.
+     *
+     * @param executor executor, NULL to process inline again.
+     * @return is the executor used.
+     */
+    virtual bool setExecutor(ChainExecutor* executor) { return !executor; }
+
 protected:
+    /**
+     * Constructor.
+     *
+     * @param typeName name of the data type this reader accepts.
+     */
+    RingBufferReaderBase(const char* typeName) : typeName_(typeName), lost_(0) {}
+
     /**
      * Destructor
      */
     virtual ~RingBufferReaderBase();
+
+private:
+    template <class TYPE> friend class RingBuffer;
+
+    const char* typeName_; /**< data type name */
+    quint64     lost_;     /**< overwritten sample count */
 };
 
 /**
@@ -62,7 +146,11 @@ public:
     /**
      * Constructor.
      */
-    RingBufferReader() : readCount_(0) {}
+    RingBufferReader() :
+        RingBufferReaderBase(ringBufferTypeName<TYPE>()),
+        readCount_(0),
+        buffer_(NULL)
+    {}
 
     /**
      * Destructor
@@ -116,6 +204,15 @@ public:
      */
     bool unjoin(RingBufferReaderBase* reader);
 
+    /**
+     * Record samples committed to this buffer under given stream name,
+     * if sample recording is configured. Default implementation does
+     * not record.
+     *
+     * @param stream recording stream name.
+     */
+    virtual void enableRecording(const QString& stream) { Q_UNUSED(stream); }
+
 private:
     /**
      * Connect reader to this buffer.
@@ -135,7 +232,16 @@ private:
 };
 
 /**
- * Ring buffer implementation.
+ * Ring buffer implementation. Capacity is rounded up to a power of two
+ * so that positions are mapped to slots with a mask, and data is
+ * copied in at most two contiguous spans.
+ *
+ * Readers which fall more than capacity behind the writer are moved
+ * to the oldest sample still in the buffer instead of reading data
+ * that has been overwritten. Skipped samples are accounted to the
+ * reader, see RingBufferReaderBase::lostSamples(). Positions are free
+ * running unsigned counters, distances between them stay correct when
+ * the counters wrap around.
  *
  * @tparam TYPE data type in buffer.
  */
@@ -146,14 +252,16 @@ public:
     /**
      * Constructor.
      *
-     * @param size how many elements can be buffered.
+     * @param size how many elements can be buffered. Rounded up to the
+     *             next power of two.
      */
     RingBuffer(unsigned size) :
         sink_(this, &RingBuffer::write),
-        bufferSize_(size),
+        bufferSize_(roundUp(size)),
+        mask_(bufferSize_ - 1),
         writeCount_()
     {
-        buffer_ = new TYPE[size];
+        buffer_ = new TYPE[bufferSize_];
         addSink(&sink_, "sink");
     }
 
@@ -177,15 +285,37 @@ public:
                   TYPE*                   values,
                   RingBufferReader<TYPE>& reader) const
     {
-        unsigned itemsRead = 0;
-        while (itemsRead < n && reader.readCount_ != (unsigned)writeCount_) {
+        unsigned available = writeCount_ - reader.readCount_;
+        if (available > bufferSize_) {
+            unsigned skipped = available - bufferSize_;
+            // Warn once per reader, the counter tells the rest.
+            if (__atomic_fetch_add(&reader.lost_, skipped, __ATOMIC_RELAXED) == 0)
+                sensordLogW() << "Ring buffer reader overrun, skipping " << skipped << " overwritten samples";
+            else
+                sensordLogD() << "Ring buffer reader overrun, skipping " << skipped << " overwritten samples";
+            reader.readCount_ = writeCount_ - bufferSize_;
+            available = bufferSize_;
+        }
+        if (n > available)
+            n = available;
 
-            *values++ = buffer_[reader.readCount_++ % bufferSize_];
+        unsigned offset = reader.readCount_ & mask_;
+        unsigned first = qMin(n, bufferSize_ - offset);
+        RingBufferCopy<TYPE>::copy(values, buffer_ + offset, first);
+        RingBufferCopy<TYPE>::copy(values + first, buffer_, n - first);
+        reader.readCount_ += n;
 
-            ++itemsRead;
-        }
+        return n;
+    }
 
-        return itemsRead;
+    /**
+     * Capacity of the buffer.
+     *
+     * @return how many elements can be buffered.
+     */
+    unsigned size() const
+    {
+        return bufferSize_;
     }
 
 protected:
@@ -196,7 +326,7 @@ protected:
      */
     TYPE* nextSlot()
     {
-        return &buffer_[writeCount_ % bufferSize_];
+        return &buffer_[writeCount_ & mask_];
     }
 
     /**
@@ -204,6 +334,7 @@ protected:
      */
     void commit()
     {
+        SENSORFW_TRACE_SAMPLE(Commit, static_cast<const RingBufferBase*>(this), buffer_[writeCount_ & mask_]);
         ++writeCount_;
     }
 
@@ -212,9 +343,11 @@ protected:
      */
     void wakeUpReaders()
     {
-        RingBufferReader<TYPE>* reader;
-        foreach (reader, readers_) {
-            reader->wakeup();
+        // Readers may join and unjoin from other threads or while woken
+        // up, the snapshot stays valid until it goes out of scope.
+        typename SubscriberList<RingBufferReader<TYPE>*>::Snapshot readers(readers_);
+        for (int i = 0; i < readers.size(); ++i) {
+            readers.at(i)->wakeup();
         }
     }
 
@@ -226,12 +359,19 @@ protected:
      */
     void write(unsigned n, const TYPE* values)
     {
-        // buffer incoming data
-        while (n) {
-            *nextSlot() = *values++;
-            commit();
-            --n;
+        // Only the last bufferSize_ objects would survive anyway.
+        if (n > bufferSize_) {
+            values += n - bufferSize_;
+            writeCount_ += n - bufferSize_;
+            n = bufferSize_;
         }
+
+        unsigned offset = writeCount_ & mask_;
+        unsigned first = qMin(n, bufferSize_ - offset);
+        RingBufferCopy<TYPE>::copy(buffer_ + offset, values, first);
+        RingBufferCopy<TYPE>::copy(buffer_, values + first, n - first);
+        writeCount_ += n;
+
         wakeUpReaders();
     }
 
@@ -244,11 +384,11 @@ protected:
     {
         sensordLogT() << "joining reader to ringbuffer.";
 
-        RingBufferReader<TYPE>* r = dynamic_cast<RingBufferReader<TYPE>*>(reader);
-        if (r == NULL) {
+        if (strcmp(reader->typeName(), ringBufferTypeName<TYPE>()) != 0) {
             sensordLogW() << "Ringbuffer join failed!";
             return false;
         }
+        RingBufferReader<TYPE>* r = static_cast<RingBufferReader<TYPE>*>(reader);
 
         r->readCount_ = writeCount_;
         r->buffer_    = this;
@@ -264,23 +404,37 @@ protected:
      */
     virtual bool unjoinTypeChecked(RingBufferReaderBase* reader)
     {
-        RingBufferReader<TYPE>* r = dynamic_cast<RingBufferReader<TYPE>*>(reader);
-        if (r == NULL) {
+        if (strcmp(reader->typeName(), ringBufferTypeName<TYPE>()) != 0) {
             sensordLogW() << "Ringbuffer unjoin failed!";
             return false;
         }
+        RingBufferReader<TYPE>* r = static_cast<RingBufferReader<TYPE>*>(reader);
 
         readers_.remove(r);
         return true;
     }
 
 private:
+    /**
+     * Round size up to the next power of two.
+     *
+     * @param size requested size.
+     * @return rounded size.
+     */
+    static unsigned roundUp(unsigned size)
+    {
+        unsigned rounded = 1;
+        while (rounded < size)
+            rounded <<= 1;
+        return rounded;
+    }
 
-    Sink<RingBuffer, TYPE>        sink_;       /**< data sink */
-    const unsigned                bufferSize_; /**< buffer size */
-    TYPE*                         buffer_;     /**< buffer */
-    unsigned int                  writeCount_; /**< how many objects have been written */
-    QSet<RingBufferReader<TYPE>*> readers_;    /**< connected readers */
+    Sink<RingBuffer, TYPE>           sink_;       /**< data sink */
+    const unsigned                   bufferSize_; /**< buffer size, power of two */
+    const unsigned                   mask_;       /**< bufferSize_ - 1 */
+    TYPE*                            buffer_;     /**< buffer */
+    unsigned int                     writeCount_; /**< how many objects have been written */
+    SubscriberList<RingBufferReader<TYPE>*> readers_; /**< connected readers */
 };
 
 #endif
@@ -0,0 +1,330 @@
+/**
+   @file samplerecorder.cpp
+   @brief SampleRecorder
+
+   <p>
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include "samplerecorder.h"
+#include "config.h"
+#include "logging.h"
+#include <QMutex>
+#include <QMutexLocker>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+static const char MAGIC[8] = { 'S', 'F', 'W', 'R', 'E', 'C', '0', '1' };
+static const quint32 VERSION = 1;
+static const quint64 DEFAULT_MAX_SIZE = 64 << 20;
+
+/**
+ * Recording file header.
+ */
+struct FileHeader
+{
+    char    magic[8];   /**< MAGIC */
+    quint32 version;    /**< format version */
+    quint32 headerSize; /**< size of this header */
+    quint64 startTime;  /**< monotonic time of recording start, microseconds */
+    quint64 reserved;   /**< zero */
+};
+
+/**
+ * Record header, followed by payload padded to eight bytes.
+ */
+struct RecordHeader
+{
+    quint32 size;      /**< payload size */
+    quint16 type;      /**< SampleRecorder::SampleType, written last */
+    quint16 stream;    /**< stream ID */
+    quint64 timestamp; /**< monotonic time, microseconds */
+};
+
+/**
+ * Payload of a stream declaration, followed by the UTF-8 stream name.
+ */
+struct StreamHeader
+{
+    quint16 type;       /**< sample type */
+    quint16 sampleSize; /**< sample size */
+};
+
+static inline size_t recordSize(size_t payload)
+{
+    return sizeof(RecordHeader) + ((payload + 7) & ~(size_t)7);
+}
+
+static quint64 monotonicTime()
+{
+    timespec stamp;
+    clock_gettime(CLOCK_MONOTONIC, &stamp);
+    return (quint64)stamp.tv_sec * 1000000 + stamp.tv_nsec / 1000;
+}
+
+/**
+ * The mapped recording file of this process.
+ */
+class RecorderFile
+{
+public:
+    RecorderFile() : initialized(false), fd(-1), data(NULL), size(0), offset(0), dropped(0), streams(0) {}
+
+    ~RecorderFile()
+    {
+        close();
+    }
+
+    bool open(const QString& path, size_t maxSize)
+    {
+        fd = ::open(path.toLocal8Bit().constData(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            sensordLogW() << "Failed to open sample recording " << path << ": " << strerror(errno);
+            return false;
+        }
+        if (ftruncate(fd, maxSize) < 0) {
+            sensordLogW() << "Failed to size sample recording " << path << ": " << strerror(errno);
+            ::close(fd);
+            fd = -1;
+            return false;
+        }
+        void* map = mmap(NULL, maxSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (map == MAP_FAILED) {
+            sensordLogW() << "Failed to map sample recording " << path << ": " << strerror(errno);
+            ::close(fd);
+            fd = -1;
+            return false;
+        }
+
+        data = static_cast<char*>(map);
+        size = maxSize;
+        FileHeader* header = reinterpret_cast<FileHeader*>(data);
+        memcpy(header->magic, MAGIC, sizeof(MAGIC));
+        header->version = VERSION;
+        header->headerSize = sizeof(FileHeader);
+        header->startTime = monotonicTime();
+        header->reserved = 0;
+        offset = sizeof(FileHeader);
+
+        sensordLogD() << "Recording adaptor samples to " << path;
+        return true;
+    }
+
+    void close()
+    {
+        if (!data)
+            return;
+        size_t used = qMin(offset, size);
+        munmap(data, size);
+        data = NULL;
+        // Runs at exit, when logging may already be gone
+        int ret = ftruncate(fd, used);
+        Q_UNUSED(ret);
+        ::close(fd);
+        fd = -1;
+    }
+
+    void write(int stream, int type, const void* payload, size_t payloadSize,
+               const void* extra = NULL, size_t extraSize = 0)
+    {
+        size_t bytes = recordSize(payloadSize + extraSize);
+        size_t at = __atomic_fetch_add(&offset, bytes, __ATOMIC_RELAXED);
+        if (at + bytes > size) {
+            if (__atomic_fetch_add(&dropped, 1, __ATOMIC_RELAXED) == 0)
+                sensordLogW() << "Sample recording full, dropping samples";
+            return;
+        }
+
+        RecordHeader* header = reinterpret_cast<RecordHeader*>(data + at);
+        header->size = payloadSize + extraSize;
+        header->stream = stream;
+        header->timestamp = monotonicTime();
+        memcpy(header + 1, payload, payloadSize);
+        if (extraSize)
+            memcpy(reinterpret_cast<char*>(header + 1) + payloadSize, extra, extraSize);
+        __atomic_store_n(&header->type, (quint16)type, __ATOMIC_RELEASE);
+    }
+
+    QMutex   mutex;       /**< protects initialization and stream declarations */
+    bool     initialized; /**< has configuration been read */
+    int      fd;          /**< file descriptor */
+    char*    data;        /**< mapped file, NULL if not recording */
+    size_t   size;        /**< mapped size */
+    size_t   offset;      /**< next free byte */
+    unsigned dropped;     /**< samples that did not fit */
+    int      streams;     /**< number of declared streams */
+};
+
+static RecorderFile recorder;
+
+int SampleRecorder::addStream(const QString& name, int type, int sampleSize)
+{
+    QMutexLocker locker(&recorder.mutex);
+
+    if (!recorder.initialized) {
+        recorder.initialized = true;
+        QString path = Config::configuration()->value<QString>("recorder/file", "");
+        if (!path.isEmpty()) {
+            qulonglong maxSize = Config::configuration()->value<qulonglong>("recorder/max_size", DEFAULT_MAX_SIZE);
+            recorder.open(path, qMax(maxSize, (qulonglong)sizeof(FileHeader)));
+        }
+    }
+
+    if (!recorder.data || recorder.streams >= StreamDeclaration)
+        return -1;
+
+    int stream = recorder.streams++;
+    StreamHeader header;
+    header.type = type;
+    header.sampleSize = sampleSize;
+    QByteArray utf8 = name.toUtf8();
+    recorder.write(stream, StreamDeclaration, &header, sizeof(header), utf8.constData(), utf8.size());
+
+    sensordLogD() << "Recording stream " << stream << ": " << name;
+    return stream;
+}
+
+void SampleRecorder::append(int stream, int type, const void* sample, int size)
+{
+    recorder.write(stream, type, sample, size);
+}
+
+unsigned SampleRecorder::dropped()
+{
+    return __atomic_load_n(&recorder.dropped, __ATOMIC_RELAXED);
+}
+
+SampleRecording::SampleRecording() :
+    data_(NULL),
+    size_(0),
+    offset_(0)
+{
+}
+
+SampleRecording::~SampleRecording()
+{
+    close();
+}
+
+bool SampleRecording::open(const QString& path)
+{
+    close();
+
+    int fd = ::open(path.toLocal8Bit().constData(), O_RDONLY);
+    if (fd < 0) {
+        sensordLogW() << "Failed to open sample recording " << path << ": " << strerror(errno);
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) < 0 || (size_t)info.st_size < sizeof(FileHeader)) {
+        sensordLogW() << "Invalid sample recording " << path;
+        ::close(fd);
+        return false;
+    }
+    void* map = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) {
+        sensordLogW() << "Failed to map sample recording " << path << ": " << strerror(errno);
+        return false;
+    }
+
+    data_ = static_cast<const char*>(map);
+    size_ = info.st_size;
+
+    const FileHeader* header = reinterpret_cast<const FileHeader*>(data_);
+    if (memcmp(header->magic, MAGIC, sizeof(MAGIC)) || header->version != VERSION ||
+        header->headerSize < sizeof(FileHeader) || header->headerSize > size_) {
+        sensordLogW() << "Invalid sample recording " << path;
+        close();
+        return false;
+    }
+
+    // Collect stream declarations
+    offset_ = header->headerSize;
+    while (offset_ + sizeof(RecordHeader) <= size_) {
+        const RecordHeader* record = reinterpret_cast<const RecordHeader*>(data_ + offset_);
+        if (record->type == SampleRecorder::NoSample || offset_ + recordSize(record->size) > size_)
+            break;
+        if (record->type == SampleRecorder::StreamDeclaration && record->size >= sizeof(StreamHeader)) {
+            const StreamHeader* declaration = reinterpret_cast<const StreamHeader*>(record + 1);
+            if (streams_.size() <= record->stream)
+                streams_.resize(record->stream + 1);
+            Stream& stream = streams_[record->stream];
+            stream.name = QString::fromUtf8(reinterpret_cast<const char*>(declaration + 1),
+                                            record->size - sizeof(StreamHeader));
+            stream.type = declaration->type;
+            stream.sampleSize = declaration->sampleSize;
+        }
+        offset_ += recordSize(record->size);
+    }
+
+    rewind();
+    return true;
+}
+
+void SampleRecording::close()
+{
+    if (data_)
+        munmap(const_cast<char*>(data_), size_);
+    data_ = NULL;
+    size_ = 0;
+    offset_ = 0;
+    streams_.clear();
+}
+
+const QVector<SampleRecording::Stream>& SampleRecording::streams() const
+{
+    return streams_;
+}
+
+int SampleRecording::findStream(const QString& name) const
+{
+    for (int i = 0; i < streams_.size(); ++i) {
+        if (streams_.at(i).name == name)
+            return i;
+    }
+    return -1;
+}
+
+void SampleRecording::rewind()
+{
+    offset_ = data_ ? reinterpret_cast<const FileHeader*>(data_)->headerSize : 0;
+}
+
+bool SampleRecording::next(Record& record)
+{
+    while (data_ && offset_ + sizeof(RecordHeader) <= size_) {
+        const RecordHeader* header = reinterpret_cast<const RecordHeader*>(data_ + offset_);
+        if (header->type == SampleRecorder::NoSample || offset_ + recordSize(header->size) > size_)
+            return false;
+        offset_ += recordSize(header->size);
+        if (header->type == SampleRecorder::StreamDeclaration)
+            continue;
+
+        record.stream = header->stream;
+        record.type = header->type;
+        record.timestamp = header->timestamp;
+        record.data = header + 1;
+        record.size = header->size;
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,210 @@
+/**
+   @file samplerecorder.h
+   @brief SampleRecorder
+
+   <p>
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef SAMPLERECORDER_H
+#define SAMPLERECORDER_H
+
+#include <QString>
+#include <QVector>
+
+class TimedXyzData;
+class TimedUnsigned;
+class CalibratedMagneticFieldData;
+class CompassData;
+class ProximityData;
+class TapData;
+class TouchData;
+
+/**
+ * Process wide recorder of raw adaptor samples.
+ *
+ * When \c recorder/file is set in the configuration, every sample
+ * committed to a #DeviceAdaptorRingBuffer is appended to that file.
+ * The file is memory mapped and sized up front to \c recorder/max_size
+ * bytes (64 MiB by default); appending reserves space with an atomic
+ * add and copies the sample, so adaptor threads never block on each
+ * other or on I/O. Samples that do not fit are dropped and counted.
+ * The file is truncated to its used length on exit.
+ *
+ * File layout, all fields in host byte order and records aligned to
+ * eight bytes:
+ *  - file header: magic "SFWREC01", version, header size, start time.
+ *  - records: payload size, sample type, stream id, monotonic time in
+ *    microseconds, payload. A record of type #StreamDeclaration names a
+ *    stream ("adaptor/sensor") and gives its sample type and size.
+ *    A record of type #NoSample ends the file.
+ */
+class SampleRecorder
+{
+public:
+    /**
+     * Recorded sample types.
+     */
+    enum SampleType
+    {
+        NoSample = 0,                   /**< end of recording */
+        TimedXyzSample,                 /**< TimedXyzData and typedefs of it */
+        TimedUnsignedSample,            /**< TimedUnsigned */
+        CalibratedMagneticFieldSample,  /**< CalibratedMagneticFieldData */
+        CompassSample,                  /**< CompassData */
+        ProximitySample,                /**< ProximityData */
+        TapSample,                      /**< TapData */
+        TouchSample,                    /**< TouchData */
+        OpaqueSample = 0x7fff,          /**< other types, not replayable */
+        StreamDeclaration = 0xffff      /**< stream declaration record */
+    };
+
+    /**
+     * Declare a recorded stream.
+     *
+     * @param name Stream name.
+     * @param type Sample type.
+     * @param sampleSize Size of a sample in bytes.
+     * @return stream ID, or -1 if recording is not enabled.
+     */
+    static int addStream(const QString& name, int type, int sampleSize);
+
+    /**
+     * Append a sample to the recording.
+     *
+     * @param stream Stream ID from addStream().
+     * @param type Sample type.
+     * @param sample Sample.
+     * @param size Size of sample in bytes.
+     */
+    static void append(int stream, int type, const void* sample, int size);
+
+    /**
+     * Number of samples dropped because the recording was full.
+     *
+     * @return dropped sample count.
+     */
+    static unsigned dropped();
+};
+
+/**
+ * Sample type of a ring buffer data type for #SampleRecorder.
+ *
+ * @tparam TYPE data type.
+ */
+template <class TYPE>
+struct RecordedSampleType
+{
+    enum { ID = SampleRecorder::OpaqueSample };
+};
+
+template <> struct RecordedSampleType<TimedXyzData> { enum { ID = SampleRecorder::TimedXyzSample }; };
+template <> struct RecordedSampleType<TimedUnsigned> { enum { ID = SampleRecorder::TimedUnsignedSample }; };
+template <> struct RecordedSampleType<CalibratedMagneticFieldData> { enum { ID = SampleRecorder::CalibratedMagneticFieldSample }; };
+template <> struct RecordedSampleType<CompassData> { enum { ID = SampleRecorder::CompassSample }; };
+template <> struct RecordedSampleType<ProximityData> { enum { ID = SampleRecorder::ProximitySample }; };
+template <> struct RecordedSampleType<TapData> { enum { ID = SampleRecorder::TapSample }; };
+template <> struct RecordedSampleType<TouchData> { enum { ID = SampleRecorder::TouchSample }; };
+
+/**
+ * Read access to a file written by #SampleRecorder.
+ */
+class SampleRecording
+{
+public:
+    /**
+     * Recorded stream.
+     */
+    struct Stream
+    {
+        QString name;       /**< stream name, "adaptor/sensor" */
+        int     type;       /**< sample type */
+        int     sampleSize; /**< sample size in bytes */
+    };
+
+    /**
+     * Recorded sample.
+     */
+    struct Record
+    {
+        int         stream;    /**< stream ID */
+        int         type;      /**< sample type */
+        quint64     timestamp; /**< recording time in microseconds */
+        const void* data;      /**< sample */
+        int         size;      /**< sample size in bytes */
+    };
+
+    /**
+     * Constructor.
+     */
+    SampleRecording();
+
+    /**
+     * Destructor.
+     */
+    ~SampleRecording();
+
+    /**
+     * Map recording and read its stream declarations.
+     *
+     * @param path Recording file.
+     * @return was recording opened.
+     */
+    bool open(const QString& path);
+
+    /**
+     * Unmap recording.
+     */
+    void close();
+
+    /**
+     * Streams of the recording, indexed by stream ID.
+     *
+     * @return streams.
+     */
+    const QVector<Stream>& streams() const;
+
+    /**
+     * Find stream by name.
+     *
+     * @param name Stream name.
+     * @return stream ID, or -1 if not found.
+     */
+    int findStream(const QString& name) const;
+
+    /**
+     * Restart reading from the first record.
+     */
+    void rewind();
+
+    /**
+     * Read next sample record. Stream declarations are skipped.
+     *
+     * @param record Record, valid until the recording is closed.
+     * @return false at the end of the recording.
+     */
+    bool next(Record& record);
+
+private:
+    Q_DISABLE_COPY(SampleRecording)
+
+    const char*     data_;   /**< mapped file */
+    size_t          size_;   /**< mapped size */
+    size_t          offset_; /**< read position */
+    QVector<Stream> streams_; /**< declared streams */
+};
+
+#endif // SAMPLERECORDER_H
@@ -0,0 +1,125 @@
+/**
+   @file samplering.cpp
+   @brief SampleRing
+
+   <p>
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include "samplering.h"
+#include <string.h>
+
+SampleRing::SampleRing(unsigned int capacity) :
+    capacity_(64),
+    writePos_(0),
+    readPos_(0)
+{
+    while (capacity_ < capacity)
+        capacity_ <<= 1;
+    mask_ = capacity_ - 1;
+    data_ = new char[capacity_];
+}
+
+SampleRing::~SampleRing()
+{
+    delete[] data_;
+}
+
+unsigned int SampleRing::idsSize(int count)
+{
+    return (count * sizeof(int) + 7) & ~7;
+}
+
+unsigned int SampleRing::recordSize(int count, int size)
+{
+    // Keep every record 8 byte aligned so that a header always fits
+    // into the remaining space before the end of the ring.
+    return sizeof(Header) + idsSize(count) + ((size + 7) & ~7);
+}
+
+unsigned int SampleRing::capacity() const
+{
+    return capacity_;
+}
+
+bool SampleRing::push(int id, const void* source, int size)
+{
+    return push(&id, 1, source, size);
+}
+
+bool SampleRing::push(const int* ids, int count, const void* source, int size)
+{
+    if (size < 0 || count < 1)
+        return false;
+    unsigned int needed = recordSize(count, size);
+    if (needed > capacity_ / 2)
+        return false;
+
+    unsigned int write = (unsigned int)writePos_.load();
+    unsigned int read = (unsigned int)readPos_.loadAcquire();
+    unsigned int offset = write & mask_;
+    unsigned int tail = capacity_ - offset;
+    unsigned int total = (tail < needed) ? tail + needed : needed;
+
+    if (capacity_ - (write - read) < total)
+        return false;
+
+    if (tail < needed) {
+        Header* marker = (Header*)(data_ + offset);
+        marker->count = 0;
+        marker->size = -1;
+        write += tail;
+        offset = 0;
+    }
+
+    Header* header = (Header*)(data_ + offset);
+    header->count = count;
+    header->size = size;
+    memcpy(data_ + offset + sizeof(Header), ids, count * sizeof(int));
+    memcpy(data_ + offset + sizeof(Header) + idsSize(count), source, size);
+
+    writePos_.storeRelease((int)(write + needed));
+    return true;
+}
+
+bool SampleRing::front(const int*& ids, int& count, const void*& data, int& size)
+{
+    unsigned int read = (unsigned int)readPos_.load();
+    unsigned int write = (unsigned int)writePos_.loadAcquire();
+
+    while (read != write) {
+        unsigned int offset = read & mask_;
+        const Header* header = (const Header*)(data_ + offset);
+        if (header->size < 0) {
+            read += capacity_ - offset;
+            readPos_.storeRelease((int)read);
+            continue;
+        }
+        count = header->count;
+        size = header->size;
+        ids = (const int*)(data_ + offset + sizeof(Header));
+        data = data_ + offset + sizeof(Header) + idsSize(count);
+        return true;
+    }
+    return false;
+}
+
+void SampleRing::pop()
+{
+    unsigned int read = (unsigned int)readPos_.load();
+    const Header* header = (const Header*)(data_ + (read & mask_));
+    readPos_.storeRelease((int)(read + recordSize(header->count, header->size)));
+}
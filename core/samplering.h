@@ -0,0 +1,133 @@
+/**
+   @file samplering.h
+   @brief SampleRing
+
+   <p>
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef SAMPLERING_H
+#define SAMPLERING_H
+
+#include <QAtomicInt>
+
+/**
+ * Lock-free single-producer/single-consumer queue used for handing
+ * session samples from an adaptor thread over to the main thread.
+ *
+ * Samples are stored as variable sized records back-to-back in a
+ * preallocated byte ring, so pushing and popping never allocates. A
+ * record carries the list of sessions it is addressed to, so a sample
+ * fanned out to several clients is copied into the ring only once.
+ * Exactly one thread may call #push() and exactly one thread may call
+ * #front() and #pop().
+ */
+class SampleRing
+{
+public:
+    /**
+     * Constructor.
+     *
+     * @param capacity Size of the ring in bytes. Rounded up to the next
+     *                 power of two.
+     */
+    SampleRing(unsigned int capacity);
+
+    /**
+     * Destructor.
+     */
+    ~SampleRing();
+
+    /**
+     * Append sample for a single session to the ring. Producer side.
+     *
+     * @param id Session ID.
+     * @param source Location from where to copy the sample.
+     * @param size Size of the sample in bytes.
+     * @return was there room for the sample.
+     */
+    bool push(int id, const void* source, int size);
+
+    /**
+     * Append sample for several sessions to the ring. Producer side.
+     *
+     * @param ids Session routes, see SocketHandler::addSession(int).
+     * @param count Number of session IDs.
+     * @param source Location from where to copy the sample.
+     * @param size Size of the sample in bytes.
+     * @return was there room for the sample.
+     */
+    bool push(const int* ids, int count, const void* source, int size);
+
+    /**
+     * Peek oldest sample in the ring. Consumer side. Returned data is
+     * valid until #pop() is called.
+     *
+     * @param ids Session routes of the sample.
+     * @param count Number of session IDs.
+     * @param data Location of the sample data.
+     * @param size Size of the sample in bytes.
+     * @return was there a sample available.
+     */
+    bool front(const int*& ids, int& count, const void*& data, int& size);
+
+    /**
+     * Release the sample returned by previous #front(). Consumer side.
+     */
+    void pop();
+
+    /**
+     * Ring capacity in bytes.
+     *
+     * @return capacity.
+     */
+    unsigned int capacity() const;
+
+private:
+    /**
+     * Record header preceding each sample in the ring.
+     */
+    struct Header
+    {
+        int count; /**< number of session IDs following the header */
+        int size;  /**< payload size, or -1 for wrap marker */
+    };
+
+    /**
+     * Size a record occupies in the ring.
+     *
+     * @param count number of session IDs.
+     * @param size payload size.
+     * @return record size.
+     */
+    static unsigned int recordSize(int count, int size);
+
+    /**
+     * Size session IDs occupy in a record.
+     *
+     * @param count number of session IDs.
+     * @return size of the ID list.
+     */
+    static unsigned int idsSize(int count);
+
+    char*        data_;     /**< ring storage */
+    unsigned int capacity_; /**< ring size in bytes */
+    unsigned int mask_;     /**< capacity_ - 1 */
+    QAtomicInt   writePos_; /**< producer position, written by producer only */
+    QAtomicInt   readPos_;  /**< consumer position, written by consumer only */
+};
+
+#endif // SAMPLERING_H
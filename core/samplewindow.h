@@ -0,0 +1,307 @@
+/**
+   @file samplewindow.h
+   @brief SampleWindow
+
+   <p>
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef SAMPLEWINDOW_H
+#define SAMPLEWINDOW_H
+
+#include <QVector>
+#include "genericdata.h"
+#include "orientationdata.h"
+
+/**
+ * Averaging rules of a sample type for #SampleWindow. Specialize
+ * for every decimated type. A specialization provides a running sum
+ * type and functions to add a sample to the sum, remove it again and
+ * produce the average of the summed samples.
+ */
+template <class TYPE>
+struct AveragingTraits;
+
+/**
+ * Averaging of TimedXyzData, each axis separately.
+ */
+template <>
+struct AveragingTraits<TimedXyzData>
+{
+    /**
+     * Running sum.
+     */
+    struct Sum
+    {
+        Sum() : x(0), y(0), z(0) {}
+        long x; /**< sum of X */
+        long y; /**< sum of Y */
+        long z; /**< sum of Z */
+    };
+
+    static void add(Sum& sum, int, TimedXyzData& sample)
+    {
+        sum.x += sample.x_;
+        sum.y += sample.y_;
+        sum.z += sample.z_;
+    }
+
+    static void remove(Sum& sum, const TimedXyzData& sample)
+    {
+        sum.x -= sample.x_;
+        sum.y -= sample.y_;
+        sum.z -= sample.z_;
+    }
+
+    static TimedXyzData average(const Sum& sum, int count, const TimedXyzData& latest)
+    {
+        return TimedXyzData(latest.timestamp_, sum.x / count, sum.y / count, sum.z / count);
+    }
+};
+
+/**
+ * Averaging of CalibratedMagneticFieldData. Calibration level is taken
+ * from the latest sample.
+ */
+template <>
+struct AveragingTraits<CalibratedMagneticFieldData>
+{
+    /**
+     * Running sum.
+     */
+    struct Sum
+    {
+        Sum() : x(0), y(0), z(0), rx(0), ry(0), rz(0) {}
+        long x;  /**< sum of X */
+        long y;  /**< sum of Y */
+        long z;  /**< sum of Z */
+        long rx; /**< sum of raw X */
+        long ry; /**< sum of raw Y */
+        long rz; /**< sum of raw Z */
+    };
+
+    static void add(Sum& sum, int, CalibratedMagneticFieldData& sample)
+    {
+        sum.x += sample.x_;
+        sum.y += sample.y_;
+        sum.z += sample.z_;
+        sum.rx += sample.rx_;
+        sum.ry += sample.ry_;
+        sum.rz += sample.rz_;
+    }
+
+    static void remove(Sum& sum, const CalibratedMagneticFieldData& sample)
+    {
+        sum.x -= sample.x_;
+        sum.y -= sample.y_;
+        sum.z -= sample.z_;
+        sum.rx -= sample.rx_;
+        sum.ry -= sample.ry_;
+        sum.rz -= sample.rz_;
+    }
+
+    static CalibratedMagneticFieldData average(const Sum& sum, int count, const CalibratedMagneticFieldData& latest)
+    {
+        return CalibratedMagneticFieldData(latest.timestamp_,
+                                           sum.x / count, sum.y / count, sum.z / count,
+                                           sum.rx / count, sum.ry / count, sum.rz / count,
+                                           latest.level_);
+    }
+};
+
+/**
+ * Averaging of CompassData. Headings are unwrapped to within half a turn
+ * of the running mean before summing, so averaging across north does not
+ * point south. Calibration level is taken from the latest sample.
+ */
+template <>
+struct AveragingTraits<CompassData>
+{
+    /**
+     * Running sum.
+     */
+    struct Sum
+    {
+        Sum() : degrees(0), rawDegrees(0), correctedDegrees(0) {}
+        long degrees;          /**< sum of unwrapped degrees */
+        long rawDegrees;       /**< sum of unwrapped raw degrees */
+        long correctedDegrees; /**< sum of unwrapped corrected degrees */
+    };
+
+    static int unwrap(int angle, long sum, int count)
+    {
+        if (!count)
+            return angle;
+        long mean = sum / count;
+        while (angle - mean > 180)
+            angle -= 360;
+        while (angle - mean < -180)
+            angle += 360;
+        return angle;
+    }
+
+    static int wrap(long angle)
+    {
+        return (int)(((angle % 360) + 360) % 360);
+    }
+
+    static void add(Sum& sum, int count, CompassData& sample)
+    {
+        sample.degrees_ = unwrap(sample.degrees_, sum.degrees, count);
+        sample.rawDegrees_ = unwrap(sample.rawDegrees_, sum.rawDegrees, count);
+        sample.correctedDegrees_ = unwrap(sample.correctedDegrees_, sum.correctedDegrees, count);
+        sum.degrees += sample.degrees_;
+        sum.rawDegrees += sample.rawDegrees_;
+        sum.correctedDegrees += sample.correctedDegrees_;
+    }
+
+    static void remove(Sum& sum, const CompassData& sample)
+    {
+        sum.degrees -= sample.degrees_;
+        sum.rawDegrees -= sample.rawDegrees_;
+        sum.correctedDegrees -= sample.correctedDegrees_;
+    }
+
+    static CompassData average(const Sum& sum, int count, const CompassData& latest)
+    {
+        return CompassData(latest.timestamp_,
+                           wrap(sum.degrees / count),
+                           latest.level_,
+                           wrap(sum.correctedDegrees / count),
+                           wrap(sum.rawDegrees / count));
+    }
+};
+
+/**
+ * Fixed capacity ring of samples with a running sum of its contents.
+ * Adding and evicting a sample and reading the average of the window are
+ * constant time, and do not allocate once the ring has been reserved.
+ */
+template <class TYPE>
+class SampleWindow
+{
+public:
+    /**
+     * Constructor.
+     *
+     * @param capacity Initial capacity.
+     */
+    SampleWindow(int capacity = 0) : head_(0), count_(0)
+    {
+        reserve(capacity);
+    }
+
+    /**
+     * Number of samples the ring can hold.
+     *
+     * @return capacity.
+     */
+    int capacity() const
+    {
+        return samples_.size();
+    }
+
+    /**
+     * Number of samples in the window.
+     *
+     * @return sample count.
+     */
+    int count() const
+    {
+        return count_;
+    }
+
+    /**
+     * Oldest sample. Window must not be empty.
+     *
+     * @return oldest sample.
+     */
+    const TYPE& front() const
+    {
+        return samples_.at(head_);
+    }
+
+    /**
+     * Drop the oldest sample. Window must not be empty.
+     */
+    void popFront()
+    {
+        AveragingTraits<TYPE>::remove(sum_, samples_.at(head_));
+        head_ = (head_ + 1) % samples_.size();
+        --count_;
+    }
+
+    /**
+     * Append a sample. Window must not be full.
+     *
+     * @param sample Sample.
+     */
+    void push(const TYPE& sample)
+    {
+        TYPE& slot = samples_[(head_ + count_) % samples_.size()];
+        slot = sample;
+        AveragingTraits<TYPE>::add(sum_, count_, slot);
+        ++count_;
+    }
+
+    /**
+     * Average of the samples in the window. Window must not be empty.
+     *
+     * @param latest Sample providing the non-averaged fields.
+     * @return average.
+     */
+    TYPE average(const TYPE& latest) const
+    {
+        return AveragingTraits<TYPE>::average(sum_, count_, latest);
+    }
+
+    /**
+     * Drop all samples.
+     */
+    void clear()
+    {
+        head_ = 0;
+        count_ = 0;
+        sum_ = Sum();
+    }
+
+    /**
+     * Grow the ring to hold at least the given number of samples,
+     * keeping its contents.
+     *
+     * @param capacity Required capacity.
+     */
+    void reserve(int capacity)
+    {
+        if (capacity <= samples_.size())
+            return;
+        QVector<TYPE> grown(capacity);
+        for (int i = 0; i < count_; ++i)
+            grown[i] = samples_.at((head_ + i) % samples_.size());
+        samples_.swap(grown);
+        head_ = 0;
+    }
+
+private:
+    typedef typename AveragingTraits<TYPE>::Sum Sum;
+
+    QVector<TYPE> samples_; /**< sample ring */
+    int           head_;    /**< index of oldest sample */
+    int           count_;   /**< number of samples in window */
+    Sum           sum_;     /**< running sum of samples in window */
+};
+
+#endif // SAMPLEWINDOW_H
@@ -38,19 +38,20 @@
 #endif // SENSORFW_MCE_WATCHER
 #include <QSocketNotifier>
 #include <errno.h>
+#include <string.h>
 #include "sockethandler.h"
+#include "samplering.h"
+#include "latencytrace.h"
+#include "chainexecutor.h"
+#include "abstractsensor_a.h"
+#include "datatypes/sessionconfig.h"
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/eventfd.h>
 #include <unistd.h>
 #include <QSettings>
-
-
-typedef struct {
-        int id;
-        int size;
-        void* buffer;
-} PipeData;
+#include <QThread>
 
 SensorManager* SensorManager::instance_ = NULL;
 int SensorManager::sessionIdCount_ = 0;
@@ -105,7 +106,11 @@ SensorManager& SensorManager::instance()
 
 SensorManager::SensorManager()
     : errorCode_(SmNoError),
-    pipeNotifier_(0),
+    eventFd_(-1),
+    eventNotifier_(0),
+    samplesPending_(0),
+    sampleRingCount_(0),
+    ringDropped_(0),
     deviation(0)
 {
     const char* SOCKET_NAME = "/var/run/sensord.sock";
@@ -117,12 +122,14 @@ SensorManager::SensorManager()
 
     Q_ASSERT(socketHandler_->listen(SOCKET_NAME));
 
-    if (pipe(pipefds_) == -1) {
-        sensordLogC() << "Failed to create pipe: " << strerror(errno);
-        pipefds_[0] = pipefds_[1] = 0;
+    memset(sampleRings_, 0, sizeof(sampleRings_));
+    memset(sampleRingOwners_, 0, sizeof(sampleRingOwners_));
+
+    if ((eventFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) == -1) {
+        sensordLogC() << "Failed to create eventfd: " << strerror(errno);
     } else {
-        pipeNotifier_ = new QSocketNotifier(pipefds_[0], QSocketNotifier::Read);
-        connect(pipeNotifier_, SIGNAL(activated(int)), this, SLOT(sensorDataHandler(int)));
+        eventNotifier_ = new QSocketNotifier(eventFd_, QSocketNotifier::Read);
+        connect(eventNotifier_, SIGNAL(activated(int)), this, SLOT(sensorDataHandler(int)));
     }
 
     if (chmod(SOCKET_NAME, S_IRWXU|S_IRWXG|S_IRWXO) != 0) {
@@ -190,9 +197,10 @@ SensorManager::~SensorManager()
     }
 
     delete socketHandler_;
-    delete pipeNotifier_;
-    if (pipefds_[0]) close(pipefds_[0]);
-    if (pipefds_[1]) close(pipefds_[1]);
+    delete eventNotifier_;
+    if (eventFd_ != -1) close(eventFd_);
+    for (int i = 0; i < sampleRingCount_.loadAcquire(); ++i)
+        delete sampleRings_[i];
 
 #ifdef SENSORFW_MCE_WATCHER
     delete mceWatcher_;
@@ -281,6 +289,7 @@ AbstractSensorChannel* SensorManager::addSensor(const QString& id)
         delete sensorChannel;
         return NULL;
     }
+    sensorChannel->enableLatestValue();
     return sensorChannel;
 }
 
@@ -336,6 +345,8 @@ int SensorManager::requestSensor(const QString& id)
         entryIt.value().sensor_ = sensor;
     }
     entryIt.value().sessions_.insert(sessionId);
+    sessionSensors_.insert(sessionId, cleanId);
+    SENSORFW_TRACE_SESSION_NAME(sessionId, cleanId);
 
     return sessionId;
 }
@@ -373,6 +384,7 @@ bool SensorManager::releaseSensor(const QString& id, int sessionId)
 
     if(entryIt.value().sessions_.remove( sessionId ))
     {
+        sessionSensors_.remove(sessionId);
         /** Fix for NB#242237
         if ( entryIt.value().sessions_.empty() )
         {
@@ -392,6 +404,43 @@ bool SensorManager::releaseSensor(const QString& id, int sessionId)
     return returnValue;
 }
 
+bool SensorManager::startSession(const QString& id, int sessionId, const SessionConfig& config)
+{
+    clearError();
+
+    QMap<QString, SensorInstanceEntry>::iterator entryIt = sensorInstanceMap_.find(getCleanId(id));
+    if (entryIt == sensorInstanceMap_.end() || !entryIt.value().sensor_ ||
+        !entryIt.value().sessions_.contains(sessionId))
+    {
+        setError(SmNotInstantiated, tr("invalid sessionId, no session to start"));
+        return false;
+    }
+
+    AbstractSensorChannelAdaptor* adaptor = entryIt.value().sensor_->findChild<AbstractSensorChannelAdaptor*>();
+    if (!adaptor)
+    {
+        setError(SmNotInstantiated, tr("sensor has no D-Bus adaptor"));
+        return false;
+    }
+
+    // Apply every setting before starting, so that the first samples
+    // already follow them. As with the separate setter calls, a rejected
+    // setting is logged and the session starts without it.
+    adaptor->setDefaultInterval(sessionId);
+    if (config.interval > 0 && !adaptor->applyInterval(sessionId, config.interval))
+        sensordLogW() << "Interval " << config.interval << " rejected for session " << sessionId << " of " << id;
+    if (config.standbyOverride && !adaptor->setStandbyOverride(sessionId, true))
+        sensordLogW() << "Standby override rejected for session " << sessionId << " of " << id;
+    if (!adaptor->applyBufferInterval(sessionId, config.bufferInterval))
+        sensordLogW() << "Buffer interval " << config.bufferInterval << " rejected for session " << sessionId << " of " << id;
+    if (!adaptor->applyBufferSize(sessionId, config.bufferSize > 1 ? config.bufferSize : 0))
+        sensordLogW() << "Buffer size " << config.bufferSize << " rejected for session " << sessionId << " of " << id;
+
+    adaptor->setDownsampling(sessionId, config.downsampling);
+    adaptor->start(sessionId);
+    return true;
+}
+
 AbstractChain* SensorManager::requestChain(const QString& id)
 {
     sensordLogD() << "Requesting chain: " << id;
@@ -595,54 +644,151 @@ FilterBase* SensorManager::instantiateFilter(const QString& id)
     return it.value()();
 }
 
-bool SensorManager::write(int id, const void* source, int size)
+SampleRing* SensorManager::threadSampleRing()
 {
-    void* buffer = malloc(size);
-    if(!buffer) {
-        sensordLogC() << "Malloc failed!";
-        return false;
+    if (threadSampleRing_.hasLocalData())
+        return sampleRings_[threadSampleRing_.localData()];
+
+    QMutexLocker locker(&sampleRingMutex_);
+
+    QThread* thread = QThread::currentThread();
+    int count = sampleRingCount_.loadAcquire();
+    int index = 0;
+    while (index < count && sampleRingOwners_[index] != thread)
+        ++index;
+
+    if (index == count) {
+        if (count == MAX_SAMPLE_RINGS) {
+            sensordLogC() << "Too many threads writing sensor data, no sample ring available.";
+            return NULL;
+        }
+        sampleRings_[index] = new SampleRing(SAMPLE_RING_SIZE);
+        sampleRingOwners_[index] = thread;
+        sampleRingCount_.storeRelease(count + 1);
     }
-    PipeData pipeData;
-    pipeData.id = id;
-    pipeData.size = size;
-    pipeData.buffer = buffer;
 
-    memcpy(buffer, source, size);
+    threadSampleRing_.setLocalData(index);
+    return sampleRings_[index];
+}
+
+bool SensorManager::write(int id, const void* source, int size)
+{
+    return write(&id, 1, source, size);
+}
+
+bool SensorManager::write(const int* ids, int count, const void* source, int size)
+{
+    SampleRing* ring = threadSampleRing();
+    if (!ring)
+        return false;
 
-    if (::write(pipefds_[1], &pipeData, sizeof(pipeData)) < (int)sizeof(pipeData)) {
-        sensordLogW() << "Failed to write all data to pipe.";
+    if (!ring->push(ids, count, source, size)) {
+        // Warn once, the counter tells the rest.
+        if (__atomic_fetch_add(&ringDropped_, 1, __ATOMIC_RELAXED) == 0)
+            sensordLogW() << "Sample ring full, dropping samples";
         return false;
     }
+
+    // Only the first sample after the main thread has drained the rings
+    // needs to signal, later ones are picked up by the same wakeup.
+    if (samplesPending_.fetchAndStoreOrdered(1) == 0) {
+        quint64 value = 1;
+        if (::write(eventFd_, &value, sizeof(value)) != (ssize_t)sizeof(value)) {
+            // Sample stays queued, next write will retry signalling.
+            sensordLogW() << "Failed to signal eventfd: " << strerror(errno);
+            samplesPending_.fetchAndStoreOrdered(0);
+        }
+    }
     return true;
 }
 
 void SensorManager::sensorDataHandler(int)
 {
-    PipeData pipeData;
-    read(pipefds_[0], &pipeData, sizeof(pipeData));
+    quint64 value;
+    if (::read(eventFd_, &value, sizeof(value)) == -1 && errno != EAGAIN) {
+        sensordLogW() << "Failed to read eventfd: " << strerror(errno);
+    }
+    samplesPending_.fetchAndStoreOrdered(0);
+
+    int rings = sampleRingCount_.loadAcquire();
+    for (int i = 0; i < rings; ++i) {
+        SampleRing* ring = sampleRings_[i];
+        const int* ids;
+        int count;
+        int size;
+        const void* data;
+        while (ring->front(ids, count, data, size)) {
+            for (int j = 0; j < count; ++j) {
+                SENSORFW_TRACE_PAYLOAD(Dispatch, socketHandler_->routeSession(ids[j]), data, size, 1);
+                appendToBatch(ids[j], data, size);
+            }
+            ring->pop();
+        }
+    }
+
+    flushSessionBatches();
+}
+
+void SensorManager::appendToBatch(int route, const void* data, int size)
+{
+    int slot = route & SocketHandler::ROUTE_SLOT_MASK;
+    if (slot >= sessionBatches_.size())
+        sessionBatches_.resize(slot + 1);
+
+    SessionBatch& batch = sessionBatches_[slot];
+    if (batch.count && (batch.size != size || batch.route != route))
+        writeBatch(batch);
+    if (!batch.pending) {
+        batch.pending = true;
+        pendingBatches_.append(slot);
+    }
+    batch.route = route;
+    batch.size = size;
+    if (batch.data.capacity() < batch.data.size() + size) {
+        // Reserved capacity survives resize(0) between drains.
+        batch.data.reserve(qMax(batch.data.size() + size, 2 * batch.data.capacity()));
+    }
+    batch.data.append((const char*)data, size);
+    ++batch.count;
+}
 
-    if (!socketHandler_->write(pipeData.id, pipeData.buffer, pipeData.size)) {
+void SensorManager::writeBatch(SessionBatch& batch)
+{
+    if (!socketHandler_->writeRoute(batch.route, batch.data.constData(), batch.size, batch.count)) {
         sensordLogW() << "Failed to write data to socket.";
     }
+    batch.data.resize(0);
+    batch.count = 0;
+}
 
-    free(pipeData.buffer);
+void SensorManager::flushSessionBatches()
+{
+    foreach (int slot, pendingBatches_) {
+        SessionBatch& batch = sessionBatches_[slot];
+        if (batch.count)
+            writeBatch(batch);
+        batch.pending = false;
+    }
+    pendingBatches_.resize(0);
 }
 
 void SensorManager::lostClient(int sessionId)
 {
-    for(QMap<QString, SensorInstanceEntry>::iterator it = sensorInstanceMap_.begin(); it != sensorInstanceMap_.end(); ++it) {
-        if (it.value().sessions_.contains(sessionId)) {
-            sensordLogD() << "[SensorManager]: Lost session " << sessionId << " detected as " << it.key();
+    QHash<int, QString>::const_iterator session = sessionSensors_.constFind(sessionId);
+    QMap<QString, SensorInstanceEntry>::iterator it = session != sessionSensors_.constEnd() ?
+        sensorInstanceMap_.find(*session) : sensorInstanceMap_.end();
+    if (it == sensorInstanceMap_.end()) {
+        sensordLogW() << "[SensorManager]: Lost session " << sessionId << " detected, but not found from session list";
+        return;
+    }
 
-            sensordLogD() << "[SensorManager]: Stopping sessionId " << sessionId;
-            it.value().sensor_->stop(sessionId);
+    sensordLogD() << "[SensorManager]: Lost session " << sessionId << " detected as " << it.key();
 
-            sensordLogD() << "[SensorManager]: Releasing sessionId " << sessionId;
-            releaseSensor(it.key(), sessionId);
-            return;
-        }
-    }
-    sensordLogW() << "[SensorManager]: Lost session " << sessionId << " detected, but not found from session list";
+    sensordLogD() << "[SensorManager]: Stopping sessionId " << sessionId;
+    it.value().sensor_->stop(sessionId);
+
+    sensordLogD() << "[SensorManager]: Releasing sessionId " << sessionId;
+    releaseSensor(it.key(), sessionId);
 }
 
 void SensorManager::displayStateChanged(bool displayState)
@@ -686,12 +832,28 @@ void SensorManager::printStatus(QStringList& output) const
 {
     output.append("  Adaptors:");
     for (QMap<QString, DeviceAdaptorInstanceEntry>::const_iterator it = deviceAdaptorInstanceMap_.constBegin(); it != deviceAdaptorInstanceMap_.constEnd(); ++it) {
-        output.append(QString("    %1 [%2 listener(s)] %3").arg(it.value().type_).arg(it.value().cnt_).arg(it.value().adaptor_->deviceStandbyOverride() ? "Standby Overriden" : "No standby override"));
+        QString str(QString("    %1 [%2 listener(s)] %3").arg(it.value().type_).arg(it.value().cnt_).arg(it.value().adaptor_->deviceStandbyOverride() ? "Standby Overriden" : "No standby override"));
+        double requested;
+        double achieved;
+        quint64 missed;
+        if (it.value().adaptor_->pollingRate(requested, achieved, missed))
+            str.append(QString(". Rate %1/%2 Hz, %3 missed").arg(achieved, 0, 'f', 1).arg(requested, 0, 'f', 1).arg(missed));
+        output.append(str);
     }
 
     output.append("  Chains:\n");
     for (QMap<QString, ChainInstanceEntry>::const_iterator it = chainInstanceMap_.constBegin(); it != chainInstanceMap_.constEnd(); ++it) {
-        output.append(QString("    %1 [%2 listener(s)]. %3").arg(it.value().type_).arg(it.value().cnt_).arg((it.value().chain_ && it.value().chain_->running()) ? "Running" : "Stopped"));
+        QString str(QString("    %1 [%2 listener(s)]. %3").arg(it.value().type_).arg(it.value().cnt_).arg((it.value().chain_ && it.value().chain_->running()) ? "Running" : "Stopped"));
+        if (it.value().chain_)
+            str.append(QString(". %1 lost sample(s)").arg(it.value().chain_->lostSamples()));
+        if (it.value().chain_ && it.value().chain_->executor()) {
+            ChainExecutor::Metrics metrics = it.value().chain_->executor()->metrics();
+            str.append(QString(". Worker: queue %1 (max %2), %3 batch(es), avg %4 us, max %5 us, %6 dropped")
+                       .arg(metrics.depth).arg(metrics.maxDepth).arg(metrics.batches)
+                       .arg(metrics.batches ? metrics.totalNs / metrics.batches / 1000 : 0)
+                       .arg(metrics.maxNs / 1000).arg(metrics.dropped));
+        }
+        output.append(str);
     }
 
     output.append("  Logical sensors:");
@@ -704,8 +866,23 @@ void SensorManager::printStatus(QStringList& output) const
         else
             str.append("No sessions]");
         str.append(QString(". %1").arg((it.value().sensor_ && it.value().sensor_->running()) ? "Running" : "Stopped"));
+        if (it.value().sensor_)
+            str.append(QString(". %1 lost sample(s)").arg(it.value().sensor_->lostSamples()));
+        quint64 dropped = 0;
+        foreach (int session, it.value().sessions_)
+            dropped += socketHandler_->droppedSamples(session);
+        if (dropped)
+            str.append(QString(". %1 sample(s) dropped for slow clients").arg(dropped));
         output.append(str);
     }
+
+    quint64 ringDropped = __atomic_load_n(&ringDropped_, __ATOMIC_RELAXED);
+    if (ringDropped)
+        output.append(QString("  %1 sample(s) dropped because a sample ring was full").arg(ringDropped));
+
+#ifdef SENSORFW_LATENCY_TRACE
+    LatencyTrace::report(output);
+#endif
 }
 
 QString SensorManager::socketToPid(int id) const
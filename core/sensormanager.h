@@ -38,6 +38,9 @@
 #include "idutils.h"
 #include "parameterparser.h"
 #include "logging.h"
+#include <QMutex>
+#include <QThreadStorage>
+#include <QVector>
 
 #ifdef SENSORFW_MCE_WATCHER
 #include "mcewatcher.h"
@@ -46,7 +49,10 @@ class MceWatcher;
 #endif
 
 class QSocketNotifier;
+class QThread;
 class SocketHandler;
+class SampleRing;
+struct SessionConfig;
 
 /**
  * Sensor instance entry. Contains list of connected sessions.
@@ -256,14 +262,29 @@ public:
 #endif
 
     /**
-     * Write sensor data for given session.
+     * Write sensor data for given session. Data is queued into the
+     * sample ring of the calling thread and written to the session
+     * socket from the main thread.
      *
-     * @param id Session ID.
+     * @param id Session route, see SocketHandler::addSession(int).
      * @param source Source from where to write.
      * @param size How many bytes to write.
      */
     bool write(int id, const void* source, int size);
 
+    /**
+     * Write the same sensor data to several sessions. The sample is
+     * queued once together with the session list and written to each
+     * session socket from the main thread, so the cost on the calling
+     * thread does not grow with the number of sessions.
+     *
+     * @param ids Session routes.
+     * @param count Number of session routes.
+     * @param source Source from where to write.
+     * @param size How many bytes to write.
+     */
+    bool write(const int* ids, int count, const void* source, int size);
+
     /**
      * Load plugin.
      *
@@ -288,6 +309,20 @@ public:
      */
     bool releaseSensor(const QString& id, int sessionId);
 
+    /**
+     * Start session and apply its client settings in one go, so that
+     * the first samples delivered already follow them. Settings are
+     * applied before the session starts. Like with the separate setter
+     * calls, a rejected setting is logged and the session starts
+     * without it.
+     *
+     * @param id Sensor ID.
+     * @param sessionId Session ID.
+     * @param config Session settings.
+     * @return was session started.
+     */
+    bool startSession(const QString& id, int sessionId, const SessionConfig& config);
+
     /**
      * Get sensor instance.
      *
@@ -348,8 +383,9 @@ private Q_SLOTS:
     void devicePSMStateChanged(bool deviceMode);
 
     /**
-     * Callback for arrived sensor data in internal pipe which SensorManager
-     * needs to propagate to the SocketHandler.
+     * Callback for arrived sensor data in the sample rings which
+     * SensorManager needs to propagate to the SocketHandler. All
+     * pending samples are drained with a single invocation.
      */
     void sensorDataHandler(int);
 
@@ -437,6 +473,54 @@ private:
      */
     QString socketToPid(const QSet<int>& ids) const;
 
+    /**
+     * Get sample ring of the calling thread. Ring is created on first
+     * use and reused when the same QThread is restarted.
+     *
+     * @return sample ring or NULL if no more rings can be created.
+     */
+    SampleRing* threadSampleRing();
+
+    /**
+     * Samples collected for a single session during one drain of the
+     * sample rings.
+     */
+    struct SessionBatch
+    {
+        SessionBatch() : route(-1), size(0), count(0), pending(false) {}
+
+        int          route;   /**< session route */
+        int          size;    /**< size of a single sample */
+        unsigned int count;   /**< number of samples in data */
+        bool         pending; /**< listed in pendingBatches_ */
+        QByteArray   data;    /**< samples back-to-back */
+    };
+
+    /**
+     * Append sample to the batch of given session.
+     *
+     * @param route Session route.
+     * @param data Sample.
+     * @param size Sample size.
+     */
+    void appendToBatch(int route, const void* data, int size);
+
+    /**
+     * Write batch to the SocketHandler and reset it.
+     *
+     * @param batch Session batch.
+     */
+    void writeBatch(SessionBatch& batch);
+
+    /**
+     * Write collected session batches to the SocketHandler and reset
+     * them for the next drain.
+     */
+    void flushSessionBatches();
+
+    static const int MAX_SAMPLE_RINGS = 32;           /**< max number of producing threads */
+    static const unsigned int SAMPLE_RING_SIZE = 65536; /**< sample ring size in bytes */
+
     QMap<QString, SensorChannelFactoryMethod>      sensorFactoryMap_; /**< factories for sensor types */
     QMap<QString, SensorInstanceEntry>             sensorInstanceMap_; /**< sensor instances */
 
@@ -452,8 +536,18 @@ private:
     MceWatcher*                                    mceWatcher_; /**< MCE watcher */
     SensorManagerError                             errorCode_; /** global error code */
     QString                                        errorString_; /** global error description */
-    int                                            pipefds_[2]; /** pipe for sensor samples */
-    QSocketNotifier*                               pipeNotifier_; /** notifier for pipe stream */
+    int                                            eventFd_; /** eventfd signalling pending samples */
+    QSocketNotifier*                               eventNotifier_; /** notifier for eventfd */
+    QAtomicInt                                     samplesPending_; /** is eventfd already signalled */
+    SampleRing*                                    sampleRings_[MAX_SAMPLE_RINGS]; /** per thread sample rings */
+    QThread*                                       sampleRingOwners_[MAX_SAMPLE_RINGS]; /** threads owning the rings */
+    QAtomicInt                                     sampleRingCount_; /** number of published rings */
+    quint64                                        ringDropped_; /** samples dropped because a sample ring was full */
+    QMutex                                         sampleRingMutex_; /** protects ring creation */
+    QThreadStorage<int>                            threadSampleRing_; /** ring index of the calling thread */
+    QVector<SessionBatch>                          sessionBatches_; /** per session slot samples of current drain */
+    QVector<int>                                   pendingBatches_; /** slots with samples in current drain */
+    QHash<int, QString>                            sessionSensors_; /** sensor ID of session */
 
     static SensorManager*                          instance_; /** singleton */
     static int                                     sessionIdCount_; /** session ID counter */
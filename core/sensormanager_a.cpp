@@ -67,6 +67,26 @@ bool SensorManagerAdaptor::releaseSensor(const QString &id, int sessionId, qint6
     return sensorManager()->releaseSensor(id, sessionId);
 }
 
+int SensorManagerAdaptor::openAndStart(const QString &id, qint64 pid, const SessionConfig &config)
+{
+    int session = config.sessionId;
+    bool opened = false;
+    if (session < 0) {
+        session = sensorManager()->requestSensor(id);
+        if (session < 0)
+            return INVALID_SESSION;
+        opened = true;
+    }
+    sensordLog() << "Sensor '" << id << "' start requested for session " << session << ". Client PID: " << pid;
+
+    if (!sensorManager()->startSession(id, session, config)) {
+        if (opened)
+            sensorManager()->releaseSensor(getCleanId(id), session);
+        return INVALID_SESSION;
+    }
+    return session;
+}
+
 void SensorManagerAdaptor::setMagneticDeviation(double level)
 {
     sensorManager()->setMagneticDeviation(level);
@@ -77,6 +97,15 @@ double SensorManagerAdaptor::magneticDeviation()
     return sensorManager()->magneticDeviation();
 }
 
+#ifdef SENSORFW_LATENCY_TRACE
+QStringList SensorManagerAdaptor::status()
+{
+    QStringList output;
+    sensorManager()->printStatus(output);
+    return output;
+}
+#endif
+
 SensorManager* SensorManagerAdaptor::sensorManager() const
 {
     return dynamic_cast<SensorManager*>(parent());
@@ -31,6 +31,7 @@
 
 #include <QtDBus/QtDBus>
 #include "sensormanager.h"
+#include "datatypes/sessionconfig.h"
 
 /**
  * Adaptor class for SensorManager DBus interface.
@@ -106,9 +107,32 @@ public Q_SLOTS:
      */
     bool releaseSensor(const QString &id, int sessionId, qint64 pid);
 
+    /**
+     * Open sensor session, apply its settings and start it in one call.
+     *
+     * @param id Sensor ID.
+     * @param pid Requestor PID.
+     * @param config Session settings. If config.sessionId refers to an
+     *               already requested session that one is started,
+     *               otherwise a new session is created.
+     * @return Session ID, INVALID_SESSION on failure.
+     */
+    int openAndStart(const QString &id, qint64 pid, const SessionConfig &config);
+
     double magneticDeviation();
     void setMagneticDeviation(double level);
 
+#ifdef SENSORFW_LATENCY_TRACE
+    /**
+     * Daemon status including per-stage latency statistics. Only
+     * exported in builds with latency tracing enabled, as it reveals
+     * the sessions and PIDs of all clients.
+     *
+     * @return status lines, as logged on SIGUSR2.
+     */
+    QStringList status();
+#endif
+
 Q_SIGNALS:
     /**
      * Signal which is emitted for occured errors.
@@ -0,0 +1,102 @@
+/**
+   @file sessiondecimator.h
+   @brief SessionDecimator
+
+   <p>
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef SESSIONDECIMATOR_H
+#define SESSIONDECIMATOR_H
+
+#include <QHash>
+#include "samplewindow.h"
+
+/**
+ * Per-session boxcar decimator. Each session collects the samples of one
+ * output period into a ring together with their running sum, and gets
+ * the average of the period once it is complete. Samples older than
+ * #MAX_AGE compared to the newest one are dropped from the window.
+ *
+ * Ring storage is allocated when a session first uses a given
+ * decimation factor and reused afterwards, so steady state sample
+ * handling does not allocate.
+ */
+template <class TYPE>
+class SessionDecimator
+{
+public:
+    /** Maximum age of a sample in a window, in microseconds. */
+    static const quint64 MAX_AGE = 2000000;
+
+    /**
+     * Add sample for session.
+     *
+     * @param sessionId Session ID.
+     * @param sample Sample.
+     * @param factor Number of samples averaged into one output sample.
+     * @param output Averaged sample, set when true is returned.
+     * @return is an output sample available.
+     */
+    bool add(int sessionId, const TYPE& sample, int factor, TYPE& output)
+    {
+        Window& window = windows_[sessionId];
+        if (factor < 1)
+            factor = 1;
+        window.reserve(factor);
+
+        while (window.count() > 0 &&
+               (window.count() >= factor ||
+                sample.timestamp_ - window.front().timestamp_ > MAX_AGE))
+            window.popFront();
+
+        window.push(sample);
+        if (window.count() < factor)
+            return false;
+
+        output = window.average(sample);
+        return true;
+    }
+
+    /**
+     * Reset window of session after its output was delivered.
+     *
+     * @param sessionId Session ID.
+     */
+    void clear(int sessionId)
+    {
+        typename QHash<int, Window>::iterator it = windows_.find(sessionId);
+        if (it != windows_.end())
+            it->clear();
+    }
+
+    /**
+     * Forget session.
+     *
+     * @param sessionId Session ID.
+     */
+    void remove(int sessionId)
+    {
+        windows_.remove(sessionId);
+    }
+
+private:
+    typedef SampleWindow<TYPE> Window;
+
+    QHash<int, Window> windows_; /**< windows by session */
+};
+
+#endif // SESSIONDECIMATOR_H
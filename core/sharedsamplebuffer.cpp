@@ -0,0 +1,179 @@
+/**
+   @file sharedsamplebuffer.cpp
+   @brief SharedSampleBuffer
+
+   <p>
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include "sharedsamplebuffer.h"
+#include "sharedsamplering.h"
+#include "logging.h"
+
+#include <QMutexLocker>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/eventfd.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC 0x0001U
+#endif
+#ifndef MFD_ALLOW_SEALING
+#define MFD_ALLOW_SEALING 0x0002U
+#endif
+#ifndef F_ADD_SEALS
+#define F_ADD_SEALS 1033
+#endif
+#ifndef F_SEAL_SEAL
+#define F_SEAL_SEAL 0x0001
+#endif
+#ifndef F_SEAL_SHRINK
+#define F_SEAL_SHRINK 0x0002
+#endif
+#ifndef F_SEAL_GROW
+#define F_SEAL_GROW 0x0004
+#endif
+#ifndef F_SEAL_FUTURE_WRITE
+#define F_SEAL_FUTURE_WRITE 0x0010
+#endif
+
+static int createMemFd(const char* name)
+{
+#ifdef __NR_memfd_create
+    return syscall(__NR_memfd_create, name, MFD_CLOEXEC | MFD_ALLOW_SEALING);
+#else
+    Q_UNUSED(name);
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+SharedSampleBuffer::SharedSampleBuffer() :
+    memFd_(-1),
+    memory_(MAP_FAILED),
+    writer_(NULL)
+{
+    memFd_ = createMemFd("sensorfw-samples");
+    if (memFd_ == -1) {
+        sensordLogW() << "Failed to create shared sample memory: " << strerror(errno);
+        return;
+    }
+    if (ftruncate(memFd_, sharedSampleRingSize()) == -1) {
+        sensordLogW() << "Failed to size shared sample memory: " << strerror(errno);
+        return;
+    }
+    memory_ = mmap(NULL, sharedSampleRingSize(), PROT_READ | PROT_WRITE, MAP_SHARED, memFd_, 0);
+    if (memory_ == MAP_FAILED) {
+        sensordLogW() << "Failed to map shared sample memory: " << strerror(errno);
+        return;
+    }
+
+    // Our mapping stays writable, but clients can neither resize the
+    // memory nor map it writable. Without the seals the transport is
+    // not offered at all.
+    if (fcntl(memFd_, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_FUTURE_WRITE | F_SEAL_SEAL) == -1) {
+        sensordLogW() << "Failed to seal shared sample memory: " << strerror(errno);
+        return;
+    }
+
+    writer_ = new SharedSampleRingWriter(memory_);
+}
+
+SharedSampleBuffer::~SharedSampleBuffer()
+{
+    delete writer_;
+    if (memory_ != MAP_FAILED)
+        munmap(memory_, sharedSampleRingSize());
+    foreach (int fd, sessions_)
+        close(fd);
+    if (memFd_ != -1)
+        close(memFd_);
+}
+
+bool SharedSampleBuffer::isValid() const
+{
+    return writer_ != NULL;
+}
+
+int SharedSampleBuffer::readFd() const
+{
+    return memFd_;
+}
+
+bool SharedSampleBuffer::addSession(int sessionId, int& notifyFd)
+{
+    if (!isValid())
+        return false;
+
+    QMutexLocker locker(&mutex_);
+    QHash<int, int>::const_iterator it = sessions_.find(sessionId);
+    if (it != sessions_.end()) {
+        notifyFd = it.value();
+        return true;
+    }
+
+    notifyFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (notifyFd == -1) {
+        sensordLogW() << "Failed to create shared sample eventfd: " << strerror(errno);
+        return false;
+    }
+    sessions_.insert(sessionId, notifyFd);
+    notifyFds_.insert(notifyFd);
+    return true;
+}
+
+void SharedSampleBuffer::removeSession(int sessionId)
+{
+    QMutexLocker locker(&mutex_);
+    QHash<int, int>::iterator it = sessions_.find(sessionId);
+    if (it == sessions_.end())
+        return;
+    int fd = it.value();
+    sessions_.erase(it);
+    // No write() signals the descriptor anymore once this returns.
+    notifyFds_.remove(fd);
+    close(fd);
+}
+
+bool SharedSampleBuffer::hasSession(int sessionId) const
+{
+    QMutexLocker locker(&mutex_);
+    return sessions_.contains(sessionId);
+}
+
+bool SharedSampleBuffer::write(const void* source, int size)
+{
+    SubscriberList<int>::Snapshot fds(notifyFds_);
+    if (!fds.size())
+        return true;
+    if (!writer_->write(source, size)) {
+        sensordLogW() << "Sample of " << size << " bytes does not fit into shared sample ring";
+        return false;
+    }
+
+    // A full counter means the client does not read its eventfd, which
+    // only keeps that client from being woken up.
+    quint64 value = 1;
+    for (int i = 0; i < fds.size(); ++i) {
+        if (::write(fds.at(i), &value, sizeof(value)) == -1 && errno != EAGAIN)
+            sensordLogW() << "Failed to signal shared sample eventfd: " << strerror(errno);
+    }
+    return true;
+}
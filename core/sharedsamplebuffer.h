@@ -0,0 +1,119 @@
+/**
+   @file sharedsamplebuffer.h
+   @brief SharedSampleBuffer
+
+   <p>
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef SHAREDSAMPLEBUFFER_H
+#define SHAREDSAMPLEBUFFER_H
+
+#include <QHash>
+#include <QMutex>
+#include "subscriberlist.h"
+
+class SharedSampleRingWriter;
+
+/**
+ * Daemon side of the shared memory data channel. Owns a memfd backed
+ * #SharedSampleRingWriter for one sensor channel and an eventfd per
+ * attached session, which is signalled once per published sample. The
+ * payload is written once and never copied into per-client socket
+ * buffers.
+ *
+ * Clients receive the ring descriptor and their own eventfd in the
+ * reply to the requestSharedTransport D-Bus call. The memfd is sealed
+ * against resizing and new writable mappings, so clients can only map
+ * it read-only. A client tampering with its eventfd only affects its
+ * own wakeups.
+ */
+class SharedSampleBuffer
+{
+public:
+    /**
+     * Constructor. Creates and maps the shared memory.
+     */
+    SharedSampleBuffer();
+
+    /**
+     * Destructor. Unmaps memory and closes all descriptors.
+     */
+    ~SharedSampleBuffer();
+
+    /**
+     * Was the shared memory succesfully set up.
+     *
+     * @return is buffer usable.
+     */
+    bool isValid() const;
+
+    /**
+     * Sealed descriptor of the ring to pass to clients.
+     *
+     * @return descriptor.
+     */
+    int readFd() const;
+
+    /**
+     * Attach session to the buffer. The eventfd of an already attached
+     * session is returned again.
+     *
+     * @param sessionId Session ID.
+     * @param notifyFd set to eventfd of the session, signalled for
+     *                 every published sample, to pass to the client.
+     * @return was session attached.
+     */
+    bool addSession(int sessionId, int& notifyFd);
+
+    /**
+     * Detach session from the buffer and close its eventfd.
+     *
+     * @param sessionId Session ID.
+     */
+    void removeSession(int sessionId);
+
+    /**
+     * Is given session attached.
+     *
+     * @param sessionId Session ID.
+     * @return is session attached.
+     */
+    bool hasSession(int sessionId) const;
+
+    /**
+     * Publish sample and wake up attached clients. Does nothing if no
+     * sessions are attached. Must only be called from the thread which
+     * produces the output of the channel.
+     *
+     * @param source Location from where to copy the sample.
+     * @param size Size of the sample.
+     * @return was sample published.
+     */
+    bool write(const void* source, int size);
+
+private:
+    Q_DISABLE_COPY(SharedSampleBuffer)
+
+    int                     memFd_;     /**< sealed memfd backing the ring */
+    void*                   memory_;    /**< writable mapping */
+    SharedSampleRingWriter* writer_;    /**< ring writer */
+    QHash<int, int>         sessions_;  /**< eventfds of attached sessions by session ID */
+    SubscriberList<int>     notifyFds_; /**< eventfds signalled by #write() */
+    mutable QMutex          mutex_;     /**< guards sessions_ */
+};
+
+#endif // SHAREDSAMPLEBUFFER_H
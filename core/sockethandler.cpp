@@ -31,23 +31,33 @@
 #include <sys/socket.h>
 #include "logging.h"
 #include "sockethandler.h"
+#include "latencytrace.h"
+#include "config.h"
 #include <unistd.h>
 #include <limits.h>
+#include <string.h>
 
-SessionData::SessionData(QLocalSocket* socket, QObject* parent) : QObject(parent),
+SessionData::SessionData(QLocalSocket* socket, int sessionId, QObject* parent) : QObject(parent),
                                                                   socket(socket),
+                                                                  sessionId(sessionId),
                                                                   interval(-1),
                                                                   buffer(0),
                                                                   size(0),
                                                                   count(0),
                                                                   bufferSize(1),
                                                                   bufferInterval(0),
-                                                                  downsampling(false)
+                                                                  downsampling(false),
+                                                                  queuedBytes(0),
+                                                                  queueLimit(0),
+                                                                  policy(DropOldest),
+                                                                  overflowed(false),
+                                                                  droppedSamples(0)
 {
     lastWrite.tv_sec = 0;
     lastWrite.tv_usec = 0;
     timer.setSingleShot(true);
     connect(&timer, SIGNAL(timeout()), this, SLOT(timerTimeout()));
+    connect(socket, SIGNAL(bytesWritten(qint64)), this, SLOT(socketBytesWritten()));
 }
 
 SessionData::~SessionData()
@@ -73,18 +83,90 @@ long SessionData::sinceLastWrite() const
 
 bool SessionData::write(void* source, int size, unsigned int count)
 {
-    if(socket && count)
+    return send((const char*)source + sizeof(unsigned int), size, count);
+}
+
+bool SessionData::send(const void* source, int size, unsigned int count)
+{
+    if(!socket || !count)
+        return false;
+
+    if(overflowed)
     {
-        memcpy(source, &count, sizeof(unsigned int));
-        int written = socket->write((const char*)source, size * count + sizeof(unsigned int));
-        if(written < 0)
+        droppedSamples += count;
+        return false;
+    }
+
+    int frameSize = sizeof(unsigned int) + size * count;
+
+    // Header and payload go to the socket in a single write, so a failed
+    // write cannot leave a torn frame in the stream. The frame is built in
+    // the session's scratch buffer, which keeps its capacity between calls.
+    if(queue.isEmpty() && socket->bytesToWrite() < SOCKET_HIGH_WATER)
+    {
+        if(scratch.size() < frameSize)
+            scratch.resize(frameSize);
+        char* frame = scratch.data();
+        memcpy(frame, &count, sizeof(unsigned int));
+        memcpy(frame + sizeof(unsigned int), source, size * count);
+        if(socket->write(frame, frameSize) != frameSize)
         {
             sensordLogW() << "[SocketHandler]: failed to write payload to the socket: " << socket->errorString();
             return false;
         }
+        SENSORFW_TRACE_PAYLOAD(SocketWrite, sessionId, source, size, count);
         return true;
     }
-    return false;
+
+    // Client is not keeping up, hold the frame back so that stale frames
+    // can still be dropped and memory use stays bounded.
+    if(queuedBytes + frameSize > queueLimit)
+    {
+        if(policy == DropOldest)
+        {
+            while(!queue.isEmpty() && queuedBytes + frameSize > queueLimit)
+            {
+                const QByteArray& oldest = queue.first();
+                droppedSamples += *(const unsigned int*)oldest.constData();
+                queuedBytes -= oldest.size();
+                queue.removeFirst();
+            }
+        }
+        if(queuedBytes + frameSize > queueLimit)
+        {
+            droppedSamples += count;
+            if(policy == Disconnect)
+            {
+                sensordLogW() << "[SocketHandler]: output queue of session " << sessionId << " overflowed, disconnecting";
+                overflowed = true;
+                emit overflow(sessionId);
+                return false;
+            }
+            return true;
+        }
+    }
+
+    QByteArray frame(frameSize, Qt::Uninitialized);
+    memcpy(frame.data(), &count, sizeof(unsigned int));
+    memcpy(frame.data() + sizeof(unsigned int), source, size * count);
+    queue.append(frame);
+    queuedBytes += frameSize;
+    SENSORFW_TRACE_PAYLOAD(SocketWrite, sessionId, source, size, count);
+    return true;
+}
+
+void SessionData::socketBytesWritten()
+{
+    while(socket && !queue.isEmpty() && socket->bytesToWrite() < SOCKET_HIGH_WATER)
+    {
+        QByteArray frame = queue.takeFirst();
+        queuedBytes -= frame.size();
+        if(socket->write(frame) < 0)
+        {
+            sensordLogW() << "[SocketHandler]: failed to write payload to the socket: " << socket->errorString();
+            return;
+        }
+    }
 }
 
 bool SessionData::write(const void* source, int size)
@@ -95,7 +177,6 @@ bool SessionData::write(const void* source, int size)
         buffer = new char[allocSize];
     else if(size != this->size)
     {
-        socket->waitForBytesWritten();
         delete[] buffer;
         buffer = new char[allocSize];
     }
@@ -132,6 +213,20 @@ bool SessionData::write(const void* source, int size)
     return true;
 }
 
+bool SessionData::writeBatch(const void* source, int size, unsigned int count)
+{
+    if(count == 1 || bufferSize > 1 || downsampling)
+    {
+        bool ret = true;
+        for(unsigned int i = 0; i < count; ++i)
+            ret &= write((const char*)source + i * size, size);
+        return ret;
+    }
+
+    gettimeofday(&lastWrite, 0);
+    return send(source, size, count);
+}
+
 bool SessionData::delayedWrite()
 {
     if(timer.isActive())
@@ -180,7 +275,6 @@ void SessionData::setBufferSize(unsigned int size)
     {
         if(timer.isActive())
             timer.stop();
-        socket->waitForBytesWritten();
         delete[] buffer;
         buffer = 0;
         count = 0;
@@ -211,10 +305,35 @@ bool SessionData::getDownsampling() const
     return downsampling;
 }
 
+void SessionData::setQueueLimit(int bytes, OverflowPolicy policy)
+{
+    queueLimit = bytes;
+    this->policy = policy;
+}
+
+quint64 SessionData::getDroppedSamples() const
+{
+    return droppedSamples;
+}
+
+qint64 SessionData::getPendingBytes() const
+{
+    return queuedBytes + (socket ? socket->bytesToWrite() : 0);
+}
+
 SocketHandler::SocketHandler(QObject* parent) : QObject(parent), m_server(NULL)
 {
     m_server = new QLocalServer(this);
     connect(m_server, SIGNAL(newConnection()), this, SLOT(newConnection()));
+
+    m_queueLimit = Config::configuration()->value<int>("global/session_queue_size", 262144);
+    QString policy = Config::configuration()->value<QString>("global/session_overflow", "drop_oldest");
+    if (policy == "drop_newest")
+        m_overflowPolicy = SessionData::DropNewest;
+    else if (policy == "disconnect")
+        m_overflowPolicy = SessionData::Disconnect;
+    else
+        m_overflowPolicy = SessionData::DropOldest;
 }
 
 SocketHandler::~SocketHandler()
@@ -244,34 +363,105 @@ bool SocketHandler::listen(const QString& serverName)
     return m_server->isListening();
 }
 
+int SocketHandler::addSession(int sessionId)
+{
+    QHash<int, int>::const_iterator it = m_idMap.constFind(sessionId);
+    if (it != m_idMap.constEnd())
+        return *it;
+
+    int slot;
+    if (!m_freeSlots.isEmpty()) {
+        slot = m_freeSlots.back();
+        m_freeSlots.pop_back();
+    } else if (m_slots.size() <= ROUTE_SLOT_MASK) {
+        slot = m_slots.size();
+        m_slots.append(SessionSlot());
+    } else {
+        sensordLogC() << "[SocketHandler]: Session table full.";
+        return -1;
+    }
+
+    SessionSlot& entry = m_slots[slot];
+    entry.sessionId = sessionId;
+    entry.route = (entry.generation << ROUTE_SLOT_BITS) | slot;
+    m_idMap.insert(sessionId, entry.route);
+    return entry.route;
+}
+
+int SocketHandler::route(int sessionId) const
+{
+    return m_idMap.value(sessionId, -1);
+}
+
+int SocketHandler::routeSession(int route) const
+{
+    int slot = route & ROUTE_SLOT_MASK;
+    if (route < 0 || slot >= m_slots.size() || m_slots.at(slot).route != route)
+        return -1;
+    return m_slots.at(slot).sessionId;
+}
+
+SessionData* SocketHandler::session(int sessionId) const
+{
+    QHash<int, int>::const_iterator it = m_idMap.constFind(sessionId);
+    if (it == m_idMap.constEnd())
+        return NULL;
+    return m_slots.at(*it & ROUTE_SLOT_MASK).data;
+}
+
 bool SocketHandler::write(int id, const void* source, int size)
 {
-    QMap<int, SessionData*>::iterator it = m_idMap.find(id);
-    if (it == m_idMap.end())
+    SessionData* data = session(id);
+    if (!data)
     {
         sensordLogD() << "[SocketHandler]: Trying to write to nonexistent session (normal, no panic).";
         return false;
     }
-    return (*it)->write(source, size);
+    return data->write(source, size);
+}
+
+bool SocketHandler::writeRoute(int route, const void* source, int size, unsigned int count)
+{
+    // Routes of removed sessions carry an old generation and do not
+    // match even if the slot has been reused.
+    int slot = route & ROUTE_SLOT_MASK;
+    if (route < 0 || slot >= m_slots.size() || m_slots.at(slot).route != route || !m_slots.at(slot).data)
+    {
+        sensordLogD() << "[SocketHandler]: Trying to write to nonexistent session (normal, no panic).";
+        return false;
+    }
+    return m_slots.at(slot).data->writeBatch(source, size, count);
 }
 
 bool SocketHandler::removeSession(int sessionId)
 {
-    if (!(m_idMap.keys().contains(sessionId))) {
+    QHash<int, int>::iterator it = m_idMap.find(sessionId);
+    if (it == m_idMap.end()) {
         sensordLogW() << "[SocketHandler]: Trying to remove nonexistent session.";
         return false;
     }
 
-    QLocalSocket* socket = (*m_idMap.find(sessionId))->stealSocket();
-
-    if (socket) {
-        disconnect(socket, SIGNAL(readyRead()), this, SLOT(socketReadable()));
-        disconnect(socket, SIGNAL(disconnected()), this, SLOT(socketDisconnected()));
-        disconnect(socket, SIGNAL(error(QLocalSocket::LocalSocketError)), this, SLOT(socketError(QLocalSocket::LocalSocketError)));
-        socket->deleteLater();
+    int slot = *it & ROUTE_SLOT_MASK;
+    m_idMap.erase(it);
+
+    SessionSlot& entry = m_slots[slot];
+    if (entry.data) {
+        QLocalSocket* socket = entry.data->stealSocket();
+        if (socket) {
+            m_socketMap.remove(socket);
+            disconnect(socket, SIGNAL(readyRead()), this, SLOT(socketReadable()));
+            disconnect(socket, SIGNAL(disconnected()), this, SLOT(socketDisconnected()));
+            disconnect(socket, SIGNAL(error(QLocalSocket::LocalSocketError)), this, SLOT(socketError(QLocalSocket::LocalSocketError)));
+            socket->deleteLater();
+        }
+        delete entry.data;
     }
 
-    delete m_idMap.take(sessionId);
+    entry.data = NULL;
+    entry.sessionId = -1;
+    entry.route = -1;
+    entry.generation = (entry.generation + 1) & ROUTE_GENERATION_MASK;
+    m_freeSlots.append(slot);
 
     return true;
 }
@@ -287,9 +477,8 @@ void SocketHandler::newConnection()
         connect(socket, SIGNAL(disconnected()), this, SLOT(socketDisconnected()));
         connect(socket, SIGNAL(error(QLocalSocket::LocalSocketError)), this, SLOT(socketError(QLocalSocket::LocalSocketError)));
 
-        // Initialize socket
+        // Initialize socket, flushed by the event loop
         socket->write("\n", 1);
-        socket->waitForBytesWritten();
     }
 }
 
@@ -301,9 +490,15 @@ void SocketHandler::socketReadable()
 
     disconnect(socket, SIGNAL(readyRead()), this, SLOT(socketReadable()));
 
-    if (sessionId >= 0) {
-        if(!m_idMap.contains(sessionId))
-            m_idMap.insert(sessionId, new SessionData((QLocalSocket*)sender(), this));
+    int route = sessionId >= 0 ? addSession(sessionId) : -1;
+    if (route >= 0) {
+        SessionSlot& entry = m_slots[route & ROUTE_SLOT_MASK];
+        if(!entry.data) {
+            entry.data = new SessionData(socket, sessionId, this);
+            entry.data->setQueueLimit(m_queueLimit, m_overflowPolicy);
+            connect(entry.data, SIGNAL(overflow(int)), this, SLOT(sessionOverflow(int)), Qt::QueuedConnection);
+            m_socketMap.insert(socket, sessionId);
+        }
     } else {
         sensordLogC() << "[SocketHandler]: Failed to read valid session ID from client. Closing socket.";
         socket->abort();
@@ -314,12 +509,7 @@ void SocketHandler::socketDisconnected()
 {
     QLocalSocket* socket = (QLocalSocket*)sender();
 
-    int sessionId = -1;
-    for(QMap<int, SessionData*>::const_iterator it = m_idMap.constBegin(); it != m_idMap.constEnd(); ++it)
-    {
-        if(it.value()->getSocket() == socket)
-            sessionId = it.key();
-    }
+    int sessionId = m_socketMap.value(socket, -1);
 
     if (sessionId == -1) {
         sensordLogW() << "[SocketHandler]: Noticed lost session, but can't find it.";
@@ -336,41 +526,47 @@ void SocketHandler::socketError(QLocalSocket::LocalSocketError socketError)
     socketDisconnected();
 }
 
+void SocketHandler::sessionOverflow(int sessionId)
+{
+    if (session(sessionId))
+        emit lostSession(sessionId);
+}
+
 int SocketHandler::getSocketFd(int sessionId) const
 {
-    QMap<int, SessionData*>::const_iterator it = m_idMap.find(sessionId);
-    if (it != m_idMap.end() && (*it)->getSocket())
-        return (*it)->getSocket()->socketDescriptor();
+    SessionData* data = session(sessionId);
+    if (data && data->getSocket())
+        return data->getSocket()->socketDescriptor();
     return 0;
 }
 
 void SocketHandler::setInterval(int sessionId, int value)
 {
-    QMap<int, SessionData*>::iterator it = m_idMap.find(sessionId);
-    if (it != m_idMap.end())
-        (*it)->setInterval(value);
+    SessionData* data = session(sessionId);
+    if (data)
+        data->setInterval(value);
 }
 
 void SocketHandler::clearInterval(int sessionId)
 {
-    QMap<int, SessionData*>::iterator it = m_idMap.find(sessionId);
-    if (it != m_idMap.end())
-        (*it)->setInterval(-1);
+    SessionData* data = session(sessionId);
+    if (data)
+        data->setInterval(-1);
 }
 
 int SocketHandler::interval(int sessionId) const
 {
-    QMap<int, SessionData*>::const_iterator it = m_idMap.find(sessionId);
-    if (it != m_idMap.end())
-        return (*it)->getInterval();
+    SessionData* data = session(sessionId);
+    if (data)
+        return data->getInterval();
     return 0;
 }
 
 void SocketHandler::setBufferSize(int sessionId, unsigned int value)
 {
-    QMap<int, SessionData*>::iterator it = m_idMap.find(sessionId);
-    if (it != m_idMap.end())
-        (*it)->setBufferSize(value);
+    SessionData* data = session(sessionId);
+    if (data)
+        data->setBufferSize(value);
 }
 
 void SocketHandler::clearBufferSize(int sessionId)
@@ -380,17 +576,17 @@ void SocketHandler::clearBufferSize(int sessionId)
 
 unsigned int SocketHandler::bufferSize(int sessionId) const
 {
-    QMap<int, SessionData*>::const_iterator it = m_idMap.find(sessionId);
-    if (it != m_idMap.end())
-        return (*it)->getBufferSize();
+    SessionData* data = session(sessionId);
+    if (data)
+        return data->getBufferSize();
     return 0;
 }
 
 void SocketHandler::setBufferInterval(int sessionId, unsigned int value)
 {
-    QMap<int, SessionData*>::iterator it = m_idMap.find(sessionId);
-    if (it != m_idMap.end())
-        (*it)->setBufferInterval(value);
+    SessionData* data = session(sessionId);
+    if (data)
+        data->setBufferInterval(value);
 }
 
 void SocketHandler::clearBufferInterval(int sessionId)
@@ -400,23 +596,31 @@ void SocketHandler::clearBufferInterval(int sessionId)
 
 unsigned int SocketHandler::bufferInterval(int sessionId) const
 {
-    QMap<int, SessionData*>::const_iterator it = m_idMap.find(sessionId);
-    if (it != m_idMap.end())
-        return (*it)->getBufferInterval();
+    SessionData* data = session(sessionId);
+    if (data)
+        return data->getBufferInterval();
     return 0;
 }
 
 bool SocketHandler::downsampling(int sessionId) const
 {
-    QMap<int, SessionData*>::const_iterator it = m_idMap.find(sessionId);
-    if (it != m_idMap.end())
-        return (*it)->getBufferSize();
+    SessionData* data = session(sessionId);
+    if (data)
+        return data->getBufferSize();
     return 0;
 }
 
 void SocketHandler::setDownsampling(int sessionId, bool value)
 {
-    QMap<int, SessionData*>::iterator it = m_idMap.find(sessionId);
-    if (it != m_idMap.end())
-        (*it)->setBufferInterval(value);
+    SessionData* data = session(sessionId);
+    if (data)
+        data->setBufferInterval(value);
+}
+
+quint64 SocketHandler::droppedSamples(int sessionId) const
+{
+    SessionData* data = session(sessionId);
+    if (data)
+        return data->getDroppedSamples();
+    return 0;
 }
@@ -30,10 +30,13 @@
 
 #include <QObject>
 #include <QMap>
+#include <QHash>
+#include <QVector>
 #include <QTimer>
 #include <QList>
 #include <QMutex>
 #include <QLocalSocket>
+#include <QByteArray>
 #include <sys/time.h>
 
 class QLocalServer;
@@ -48,14 +51,31 @@ class SessionData : public QObject
     Q_DISABLE_COPY(SessionData)
 
 public:
+    /**
+     * What to do when the output queue of a session is full.
+     */
+    enum OverflowPolicy
+    {
+        DropOldest = 0, /**< drop queued frames to make room for the new one */
+        DropNewest,     /**< drop the new frame */
+        Disconnect      /**< drop the new frame and close the session */
+    };
+
+    /**
+     * Bytes allowed in the socket write buffer before frames are kept
+     * in the session queue instead.
+     */
+    static const int SOCKET_HIGH_WATER = 16384;
+
     /**
      * Constructor.
      *
      * @param socket Established socket connection. SessionData will take
      *               the ownership of it.
+     * @param sessionId Session ID.
      * @param parent Parent object.
      */
-    SessionData(QLocalSocket* socket, QObject* parent = 0);
+    SessionData(QLocalSocket* socket, int sessionId, QObject* parent = 0);
 
     /**
      * Destructor.
@@ -71,6 +91,19 @@ public:
      */
     bool write(const void* source, int size);
 
+    /**
+     * Write several samples to socket. When the session is neither
+     * buffering nor downsampling the samples are written as a single
+     * [count][payload...] frame, otherwise each sample goes through
+     * #write(const void*, int).
+     *
+     * @param source Location of the samples, laid out back-to-back.
+     * @param size Size of a single sample in bytes.
+     * @param count How many samples to write.
+     * @return was data succesfully written.
+     */
+    bool writeBatch(const void* source, int size, unsigned int count);
+
     /**
      * Get used local socket pointer.
      *
@@ -146,6 +179,41 @@ public:
      */
     bool getDownsampling() const;
 
+    /**
+     * Set output queue limit. Frames which cannot be handed to the socket
+     * without growing its write buffer past #SOCKET_HIGH_WATER are queued,
+     * up to the given number of bytes. The policy decides what happens
+     * to frames beyond that.
+     *
+     * @param bytes Queue limit in bytes.
+     * @param policy Overflow policy.
+     */
+    void setQueueLimit(int bytes, OverflowPolicy policy);
+
+    /**
+     * Get number of samples dropped because the client did not keep up.
+     *
+     * @return dropped samples.
+     */
+    quint64 getDroppedSamples() const;
+
+    /**
+     * Get number of bytes waiting to be written to the client, both in
+     * the session queue and in the socket write buffer.
+     *
+     * @return pending bytes.
+     */
+    qint64 getPendingBytes() const;
+
+Q_SIGNALS:
+    /**
+     * Emitted once when the output queue overflows and the policy is
+     * #Disconnect.
+     *
+     * @param sessionId Session ID.
+     */
+    void overflow(int sessionId);
+
 private:
     /**
      * How many milliseconds since last time data was written to socket.
@@ -164,6 +232,17 @@ private:
      */
     bool write(void* source, int size, unsigned int count);
 
+    /**
+     * Write a [count][payload] frame to the socket, or queue it if the
+     * client is not keeping up. Never blocks.
+     *
+     * @param source Samples, laid out back-to-back.
+     * @param size Size of a single sample in bytes.
+     * @param count How many samples.
+     * @return was the frame written or queued.
+     */
+    bool send(const void* source, int size, unsigned int count);
+
     /**
      * Delayed write invocation.
      *
@@ -172,6 +251,7 @@ private:
     bool delayedWrite();
 
     QLocalSocket* socket;        /**< socket pointer. */
+    int sessionId;               /**< session ID. */
     int interval;                /**< interval in milliseconds. */
     char* buffer;                /**< pointer to buffer allocation. */
     int size;                    /**< allocated buffer size. */
@@ -181,6 +261,13 @@ private:
     unsigned int bufferSize;     /**< buffer size */
     unsigned int bufferInterval; /**< buffer interval in milliseconds */
     bool downsampling;           /**< sample dropping */
+    QByteArray scratch;          /**< frame buffer reused for direct writes */
+    QList<QByteArray> queue;     /**< frames waiting for the socket */
+    int queuedBytes;             /**< bytes in queue */
+    int queueLimit;              /**< queue limit in bytes */
+    OverflowPolicy policy;       /**< overflow policy */
+    bool overflowed;             /**< queue overflowed with Disconnect policy */
+    quint64 droppedSamples;      /**< samples dropped for slow client */
 
 private slots:
 
@@ -188,10 +275,21 @@ private slots:
      * Callback for delayed write timer.
      */
     void timerTimeout();
+
+    /**
+     * Move queued frames to the socket as its write buffer drains.
+     */
+    void socketBytesWritten();
 };
 
 /**
  * Establishes and track session data connections.
+ *
+ * Sessions live in a dense slot table. Producers address a session by
+ * its route, which is the slot index combined with a generation count
+ * of the slot, so sample routing is a direct array access and samples
+ * still in flight for a removed session never reach a later session
+ * reusing the same slot.
  */
 class SocketHandler : public QObject
 {
@@ -199,6 +297,10 @@ class SocketHandler : public QObject
     Q_DISABLE_COPY(SocketHandler)
 
 public:
+    static const int ROUTE_SLOT_BITS = 16;                           /**< bits of slot index in a route */
+    static const int ROUTE_SLOT_MASK = (1 << ROUTE_SLOT_BITS) - 1;   /**< slot index of a route */
+    static const int ROUTE_GENERATION_MASK = 0x7fff;                 /**< slot generation of a route */
+
     /**
      * Constructor.
      *
@@ -229,7 +331,44 @@ public:
     bool write(int id, const void* source, int size);
 
     /**
-     * Close related socket connection for session.
+     * Write several samples to session with given route. For more
+     * details see #SessionData::writeBatch(const void*, int, unsigned int).
+     *
+     * @param route Session route from #addSession(int).
+     * @param source Location of the samples, laid out back-to-back.
+     * @param size Size of a single sample in bytes.
+     * @param count How many samples to write.
+     * @return was data written, false if the route is stale.
+     */
+    bool writeRoute(int route, const void* source, int size, unsigned int count);
+
+    /**
+     * Reserve a slot for session. The client connection may arrive
+     * before or after this.
+     *
+     * @param sessionId Session ID.
+     * @return route of the session, -1 if the session table is full.
+     */
+    int addSession(int sessionId);
+
+    /**
+     * Get route of session.
+     *
+     * @param sessionId Session ID.
+     * @return route, -1 if session has no slot.
+     */
+    int route(int sessionId) const;
+
+    /**
+     * Get session ID of route.
+     *
+     * @param route Session route.
+     * @return session ID, -1 if route is stale.
+     */
+    int routeSession(int route) const;
+
+    /**
+     * Close related socket connection for session and release its slot.
      *
      * @param sessionId Session ID.
      * @return was socket connection closed succesfully.
@@ -337,6 +476,15 @@ public:
      */
     void setDownsampling(int sessionId, bool value);
 
+    /**
+     * Get number of samples dropped for given session because the
+     * client did not read them in time.
+     *
+     * @param sessionId Session ID.
+     * @return dropped samples.
+     */
+    quint64 droppedSamples(int sessionId) const;
+
 Q_SIGNALS:
     /**
      * Signal is emitted for lost sessions which can happen for example
@@ -369,10 +517,42 @@ private slots:
      */
     void socketError(QLocalSocket::LocalSocketError socketError);
 
+    /**
+     * Callback for session which overflowed its output queue.
+     *
+     * @param sessionId Session ID.
+     */
+    void sessionOverflow(int sessionId);
+
 private:
+    /**
+     * Entry of the session table.
+     */
+    struct SessionSlot
+    {
+        SessionSlot() : data(NULL), sessionId(-1), route(-1), generation(0) {}
+
+        SessionData* data;  /**< session connection, NULL until client connects */
+        int sessionId;      /**< owning session, -1 if free */
+        int route;          /**< current route, -1 if free */
+        int generation;     /**< reuse count of the slot */
+    };
+
+    /**
+     * Get connection of session.
+     *
+     * @param sessionId Session ID.
+     * @return session, NULL if client is not connected.
+     */
+    SessionData* session(int sessionId) const;
 
-    QLocalServer*            m_server; /**< listening server socket. */
-    QMap<int, SessionData*>  m_idMap;  /**< map of client sessions. */
+    QLocalServer*               m_server;         /**< listening server socket. */
+    QVector<SessionSlot>        m_slots;          /**< session table. */
+    QVector<int>                m_freeSlots;      /**< released slots for reuse. */
+    QHash<int, int>             m_idMap;          /**< route of session ID. */
+    QHash<QLocalSocket*, int>   m_socketMap;      /**< session ID of connected socket. */
+    int                         m_queueLimit;     /**< session queue limit in bytes. */
+    SessionData::OverflowPolicy m_overflowPolicy; /**< session queue overflow policy. */
 };
 
 #endif // SOCKETHANDLER_H
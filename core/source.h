@@ -31,6 +31,8 @@
 
 #include "sink.h"
 #include "logging.h"
+#include "latencytrace.h"
+#include "subscriberlist.h"
 #include <typeinfo>
 #include <QSet>
 
@@ -99,8 +101,13 @@ public:
      */
     void propagate(int n, const TYPE* values)
     {
-        foreach (SinkTyped<TYPE>* sink, sinks_) {
-            sink->collect(n, values);
+#ifdef SENSORFW_LATENCY_TRACE
+        for (int i = 0; i < n; ++i)
+            SENSORFW_TRACE_SAMPLE(Propagate, static_cast<const SourceBase*>(this), values[i]);
+#endif
+        typename SubscriberList<SinkTyped<TYPE>*>::Snapshot sinks(sinks_);
+        for (int i = 0; i < sinks.size(); ++i) {
+            sinks.at(i)->collect(n, values);
         }
     }
 private:
@@ -128,7 +135,7 @@ private:
         return false;
     }
 
-    QSet<SinkTyped<TYPE>*> sinks_; /**< connected sinks. */
+    SubscriberList<SinkTyped<TYPE>*> sinks_; /**< connected sinks. */
 };
 
 #endif
@@ -0,0 +1,318 @@
+/**
+   @file subscriberlist.h
+   @brief SubscriberList
+
+   <p>
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef SUBSCRIBERLIST_H
+#define SUBSCRIBERLIST_H
+
+#include <QVector>
+#include <QList>
+#include <QMutex>
+#include <QMutexLocker>
+#include <sched.h>
+
+/**
+ * Copy-on-write list of subscribers which can be iterated from any
+ * thread without locking while subscribers are added and removed.
+ *
+ * Iteration goes through a #Snapshot, an immutable array published by
+ * the last modification. Modifications build a new array, publish it
+ * and retire the old one. Each snapshot registers itself in one of two
+ * reader counters selected by the current epoch, and modifications
+ * flip the epoch so that new readers use the other counter. A retired
+ * array is freed once both counters have been seen at zero after its
+ * retirement, as no reader can then still use it.
+ *
+ * Additions never wait for readers: retired arrays are reclaimed by
+ * later modifications or by the destructor. Removal waits, without
+ * holding the modification lock, until no snapshot of another thread
+ * can see the removed subscriber anymore, so that it can be destroyed
+ * right after. Snapshots the calling thread itself holds on the same
+ * list are not waited for, and arrays they use are left for later
+ * reclamation; such an iteration may still visit the removed
+ * subscriber. Two threads must not remove from inside snapshots of
+ * the same list at the same time, as they would wait for each other.
+ *
+ * Modifications are serialized with a mutex and are expected to be
+ * rare compared to iterations.
+ *
+ * @tparam TYPE subscriber type, usually a pointer.
+ */
+template <class TYPE>
+class SubscriberList
+{
+public:
+    /**
+     * Read-only view of the subscribers at the time of construction.
+     * Subscribers removed while the snapshot exists may still be seen
+     * through it.
+     */
+    class Snapshot
+    {
+    public:
+        /**
+         * Constructor.
+         *
+         * @param list Subscriber list.
+         */
+        Snapshot(const SubscriberList& list) :
+            list_(list),
+            previous_(heldSnapshots_)
+        {
+            heldSnapshots_ = this;
+            counter_ = __atomic_load_n(&list.epoch_, __ATOMIC_SEQ_CST) & 1;
+            __atomic_fetch_add(&list.active_[counter_], 1, __ATOMIC_SEQ_CST);
+            items_ = __atomic_load_n(&list.current_, __ATOMIC_SEQ_CST);
+        }
+
+        /**
+         * Destructor.
+         */
+        ~Snapshot()
+        {
+            __atomic_fetch_sub(&list_.active_[counter_], 1, __ATOMIC_RELEASE);
+            heldSnapshots_ = previous_;
+        }
+
+        /**
+         * Number of subscribers.
+         *
+         * @return subscriber count.
+         */
+        int size() const { return items_->size(); }
+
+        /**
+         * Subscriber at index.
+         *
+         * @param i index.
+         * @return subscriber.
+         */
+        const TYPE& at(int i) const { return items_->at(i); }
+
+    private:
+        Q_DISABLE_COPY(Snapshot)
+
+        friend class SubscriberList;
+
+        const SubscriberList& list_;     /**< list the snapshot was taken from */
+        const Snapshot*       previous_; /**< snapshot held before this one by the same thread */
+        const QVector<TYPE>*  items_;    /**< published subscribers */
+        int                   counter_;  /**< index of the reader counter used */
+    };
+
+    /**
+     * Constructor.
+     */
+    SubscriberList() :
+        current_(new QVector<TYPE>()),
+        epoch_(0),
+        sequence_(0)
+    {
+        active_[0] = 0;
+        active_[1] = 0;
+    }
+
+    /**
+     * Destructor. No snapshots may exist anymore.
+     */
+    ~SubscriberList()
+    {
+        delete current_;
+        foreach (const Retired& retired, retired_)
+            delete retired.items;
+    }
+
+    /**
+     * Add subscriber.
+     *
+     * @param item subscriber.
+     * @return false if the subscriber was already in the list.
+     */
+    bool insert(const TYPE& item)
+    {
+        QMutexLocker locker(&mutex_);
+        if (current_->contains(item))
+            return false;
+        QVector<TYPE>* items = new QVector<TYPE>(*current_);
+        items->append(item);
+        publish(items);
+        return true;
+    }
+
+    /**
+     * Remove subscriber. Waits for snapshots of other threads which
+     * may still see the subscriber.
+     *
+     * @param item subscriber.
+     * @return false if the subscriber was not in the list.
+     */
+    bool remove(const TYPE& item)
+    {
+        quint64 sequence;
+        {
+            QMutexLocker locker(&mutex_);
+            int index = current_->indexOf(item);
+            if (index == -1)
+                return false;
+            QVector<TYPE>* items = new QVector<TYPE>(*current_);
+            items->remove(index);
+            sequence = publish(items);
+        }
+
+        int own[2] = { 0, 0 };
+        for (const Snapshot* snapshot = heldSnapshots_; snapshot; snapshot = snapshot->previous_) {
+            if (&snapshot->list_ == this)
+                ++own[snapshot->counter_];
+        }
+        synchronize(own);
+
+        // Arrays retired up to this removal can be freed unless the
+        // calling thread still iterates one of them.
+        if (!own[0] && !own[1]) {
+            QMutexLocker locker(&mutex_);
+            typename QList<Retired>::iterator it = retired_.begin();
+            while (it != retired_.end()) {
+                if (it->sequence <= sequence) {
+                    delete it->items;
+                    it = retired_.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+        return true;
+    }
+
+    /**
+     * Is subscriber in the list.
+     *
+     * @param item subscriber.
+     * @return is subscriber in the list.
+     */
+    bool contains(const TYPE& item) const
+    {
+        Snapshot snapshot(*this);
+        for (int i = 0; i < snapshot.size(); ++i) {
+            if (snapshot.at(i) == item)
+                return true;
+        }
+        return false;
+    }
+
+    /**
+     * Number of retired arrays not yet freed, for tests.
+     *
+     * @return retired array count.
+     */
+    int retiredCount() const
+    {
+        QMutexLocker locker(&mutex_);
+        return retired_.size();
+    }
+
+private:
+    Q_DISABLE_COPY(SubscriberList)
+
+    /**
+     * Wait until both reader counters have been seen with no other
+     * snapshots than those of the calling thread. Called without the
+     * mutex held, so that snapshot holders can modify the list
+     * meanwhile.
+     *
+     * @param own Number of snapshots the calling thread holds in each
+     *            reader counter.
+     */
+    void synchronize(const int own[2])
+    {
+        // Move new readers over to the other counter before draining
+        // one, so that it eventually empties. Flips by concurrent
+        // modifications only delay draining, each counter is still
+        // observed on its own.
+        bool drained[2] = { false, false };
+        while (!drained[0] || !drained[1]) {
+            int counter = drained[0] ? 1 : (drained[1] ? 0 : (__atomic_load_n(&epoch_, __ATOMIC_SEQ_CST) + 1) & 1);
+            if ((__atomic_load_n(&epoch_, __ATOMIC_SEQ_CST) & 1) == (unsigned int)counter)
+                __atomic_fetch_add(&epoch_, 1, __ATOMIC_SEQ_CST);
+            while (__atomic_load_n(&active_[counter], __ATOMIC_SEQ_CST) > own[counter])
+                sched_yield();
+            drained[counter] = true;
+        }
+    }
+
+    /**
+     * Retired array waiting for readers to drain.
+     */
+    struct Retired
+    {
+        QVector<TYPE>* items;      /**< retired array */
+        quint64        sequence;   /**< modification which retired the array */
+        bool           drained[2]; /**< has reader counter been seen at zero */
+    };
+
+    /**
+     * Publish new array, retire the current one and free arrays no
+     * reader can see anymore. Called with mutex held.
+     *
+     * @param items new subscribers.
+     * @return sequence number of the modification.
+     */
+    quint64 publish(QVector<TYPE>* items)
+    {
+        Retired retired;
+        retired.items = __atomic_exchange_n(&current_, items, __ATOMIC_SEQ_CST);
+        retired.sequence = ++sequence_;
+        retired.drained[0] = false;
+        retired.drained[1] = false;
+        retired_.append(retired);
+        __atomic_fetch_add(&epoch_, 1, __ATOMIC_SEQ_CST);
+
+        for (int counter = 0; counter < 2; ++counter) {
+            if (__atomic_load_n(&active_[counter], __ATOMIC_SEQ_CST) != 0)
+                continue;
+            for (typename QList<Retired>::iterator it = retired_.begin(); it != retired_.end(); ++it)
+                it->drained[counter] = true;
+        }
+
+        typename QList<Retired>::iterator it = retired_.begin();
+        while (it != retired_.end()) {
+            if (it->drained[0] && it->drained[1]) {
+                delete it->items;
+                it = retired_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        return sequence_;
+    }
+
+    QVector<TYPE>*      current_;   /**< published subscribers */
+    mutable int         active_[2]; /**< reader counters */
+    unsigned int        epoch_;     /**< selects reader counter of new snapshots */
+    quint64             sequence_;  /**< modification count */
+    QList<Retired>      retired_;   /**< retired arrays */
+    mutable QMutex      mutex_;     /**< serializes modifications */
+
+    static __thread const Snapshot* heldSnapshots_; /**< innermost snapshot held by the calling thread */
+};
+
+template <class TYPE>
+__thread const typename SubscriberList<TYPE>::Snapshot* SubscriberList<TYPE>::heldSnapshots_ = NULL;
+
+#endif // SUBSCRIBERLIST_H
@@ -31,7 +31,6 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
-#include <sys/epoll.h>
 #include <unistd.h>
 #include <QFile>
 #include "logging.h"
@@ -45,7 +44,6 @@ SysfsAdaptor::SysfsAdaptor(const QString& id,
     DeviceAdaptor(id),
     reader_(this),
     mode_(mode),
-    epollDescriptor_(-1),
     interval_(0),
     inStandbyMode_(false),
     running_(false),
@@ -55,9 +53,6 @@ SysfsAdaptor::SysfsAdaptor(const QString& id,
     if (!path.isEmpty()) {
         addPath(path, pathId);
     }
-
-    pipeDescriptors_[0] = -1;
-    pipeDescriptors_[1] = -1;
 }
 
 SysfsAdaptor::~SysfsAdaptor()
@@ -226,46 +221,6 @@ bool SysfsAdaptor::openFds()
         sysfsDescriptors_.append(fd);
     }
 
-    // Set up epoll for select mode
-    if (mode_ == SelectMode) {
-
-        if (pipe(pipeDescriptors_) == -1 ) {
-            sensordLogW() << "pipe(): " << strerror(errno);
-            return false;
-        }
-
-        if (fcntl(pipeDescriptors_[0], F_SETFD, FD_CLOEXEC) == -1) {
-            sensordLogW() << "fcntl(): " << strerror(errno);
-            return false;
-        }
-
-        // Set up epoll fd
-        if ((epollDescriptor_ = epoll_create(sysfsDescriptors_.size() + 1)) == -1) {
-            sensordLogW() << "epoll_create(): " << strerror(errno);
-            return false;
-        }
-
-        struct epoll_event ev;
-        memset(&ev, 0, sizeof(epoll_event));
-        ev.events  = EPOLLIN;
-
-        // Set up epolling for the list
-        for (int i = 0; i < sysfsDescriptors_.size(); ++i) {
-            ev.data.fd = sysfsDescriptors_.at(i);
-            if (epoll_ctl(epollDescriptor_, EPOLL_CTL_ADD, sysfsDescriptors_.at(i), &ev) == -1) {
-                sensordLogW() << "epoll_ctl(): " << strerror(errno);
-                return false;
-            }
-        }
-
-        // Add control pipe to poll list
-        ev.data.fd = pipeDescriptors_[0];
-        if (epoll_ctl(epollDescriptor_, EPOLL_CTL_ADD, pipeDescriptors_[0], &ev) == -1) {
-            sensordLogW() << "epoll_ctl(): " << strerror(errno);
-            return false;
-        }
-    }
-
     return true;
 }
 
@@ -273,20 +228,6 @@ void SysfsAdaptor::closeAllFds()
 {
     QMutexLocker locker(&mutex_);
 
-    /* Epoll */
-    if (epollDescriptor_ != -1) {
-        close(epollDescriptor_);
-        epollDescriptor_ = -1;
-    }
-
-    /* Pipe */
-    for (int i = 0; i < 2; ++i) {
-        if (pipeDescriptors_[i] != -1) {
-            close(pipeDescriptors_[i]);
-            pipeDescriptors_[i] = -1;
-        }
-    }
-
     /* SysFS */
     while (!sysfsDescriptors_.empty()) {
         if (sysfsDescriptors_.last() != -1) {
@@ -298,25 +239,17 @@ void SysfsAdaptor::closeAllFds()
 
 void SysfsAdaptor::stopReaderThread()
 {
-    if (mode_ == SelectMode) {
-        quint64 dummy = 1;
-        write(pipeDescriptors_[1], &dummy, 8);
-    }
-    else
-        reader_.stopReader();
-    reader_.wait();
+    reader_.stopReader();
 }
 
 bool SysfsAdaptor::startReaderThread()
 {
-    if (!openFds()) {
+    if (!openFds() || !reader_.startReader()) {
 
         closeAllFds();
         return false;
     }
 
-    reader_.startReader();
-
     return true;
 }
 
@@ -386,88 +319,96 @@ bool SysfsAdaptor::setInterval(const unsigned int value, const int sessionId)
     if(!checkIntervalUsage())
         return false;
     interval_ = value;
+
+    // Move to the timer of the new interval.
+    if (running_ && mode_ == IntervalMode) {
+        reader_.stopReader();
+        return reader_.startReader();
+    }
     return true;
 }
 
+bool SysfsAdaptor::pollingRate(double& requested, double& achieved, quint64& missed) const
+{
+    return reader_.rate(requested, achieved, missed);
+}
+
 SysfsAdaptor::PollMode SysfsAdaptor::mode() const
 {
     return mode_;
 }
 
-SysfsAdaptorReader::SysfsAdaptorReader(SysfsAdaptor *parent) : running_(false), parent_(parent)
+SysfsAdaptorReader::SysfsAdaptorReader(SysfsAdaptor *parent) : parent_(parent)
 {
 }
 
-void SysfsAdaptorReader::stopReader()
+SysfsAdaptorReader::~SysfsAdaptorReader()
 {
-    running_ = false;
+    stopReader();
 }
 
-void SysfsAdaptorReader::startReader()
+void SysfsAdaptorReader::stopReader()
 {
-    running_ = true;
-    start();
+    foreach (int id, registrations_)
+        AdaptorReactor::instance().remove(id);
+    registrations_.clear();
 }
 
-void SysfsAdaptorReader::run()
+bool SysfsAdaptorReader::startReader()
 {
-    while (running_) {
-
-        if (parent_->mode_ == SysfsAdaptor::SelectMode) {
-
-            struct epoll_event events[parent_->sysfsDescriptors_.size() + 1];
-            memset(events, 0x0, sizeof(events));
-
-            int descriptors = epoll_wait(parent_->epollDescriptor_, events, parent_->sysfsDescriptors_.size() + 1, -1);
-
-            if (descriptors == -1) {
-                sensordLogD() << "epoll_wait(): " << strerror(errno);
-                QThread::msleep(1000);
-            } else {
-                bool errorInInput = false;
-                for (int i = 0; i < descriptors; ++i) {
-                    if (events[i].events & (EPOLLHUP | EPOLLERR)) {
-                        //Note: we ignore error so the sensordiverter.sh works. This should be handled better when testcases are improved.
-                        sensordLogD() << "epoll_wait(): error in input fd";
-                        errorInInput = true;
-                    }
-                    int index = parent_->sysfsDescriptors_.lastIndexOf(events[i].data.fd);
-                    if (index != -1) {
-                        parent_->processSample(parent_->pathIds_.at(index), events[i].data.fd);
-
-                        if (parent_->doSeek_)
-                        {
-                            if (lseek(events[i].data.fd, 0, SEEK_SET) == -1)
-                            {
-                                sensordLogW() << "Failed to lseek fd: " << strerror(errno);
-                                QThread::msleep(1000);
-                            }
-                        }
-                    } else if (events[i].data.fd == parent_->pipeDescriptors_[0]) {
-                        running_ = false;
-                    }
-                }
-                if (errorInInput)
-                    QThread::msleep(50);
-            }
-        } else { //IntervalMode
-
-            // Read through all fds.
-            for (int i = 0; i < parent_->sysfsDescriptors_.size(); ++i) {
-                parent_->processSample(parent_->pathIds_.at(i), parent_->sysfsDescriptors_.at(i));
-
-                if (parent_->doSeek_)
-                {
-                    if (lseek(parent_->sysfsDescriptors_.at(i), 0, SEEK_SET) == -1)
-                    {
-                        sensordLogW() << "Failed to lseek fd: " << strerror(errno);
-                        QThread::msleep(1000);
-                    }
-                }
+    if (parent_->mode_ == SysfsAdaptor::SelectMode) {
+        foreach (int fd, parent_->sysfsDescriptors_) {
+            int id = AdaptorReactor::instance().addDescriptor(fd, this);
+            if (id == -1) {
+                stopReader();
+                return false;
             }
+            registrations_.append(id);
+        }
+    } else { //IntervalMode
+        int id = AdaptorReactor::instance().addTimer(parent_->interval(), this);
+        if (id == -1)
+            return false;
+        registrations_.append(id);
+    }
+    return true;
+}
 
-            // Sleep for interval
-            QThread::msleep(parent_->interval());
+void SysfsAdaptorReader::readyRead(int fd, bool error)
+{
+    if (error) {
+        //Note: we ignore error so the sensordiverter.sh works. This should be handled better when testcases are improved.
+        sensordLogD() << "epoll_wait(): error in input fd";
+    }
+    int index = parent_->sysfsDescriptors_.lastIndexOf(fd);
+    if (index != -1)
+        readPath(index);
+}
+
+void SysfsAdaptorReader::timeout()
+{
+    // Read through all fds.
+    for (int i = 0; i < parent_->sysfsDescriptors_.size(); ++i)
+        readPath(i);
+}
+
+bool SysfsAdaptorReader::rate(double& requested, double& achieved, quint64& missed) const
+{
+    if (parent_->mode_ != SysfsAdaptor::IntervalMode || registrations_.isEmpty())
+        return false;
+    return AdaptorReactor::instance().timerRate(registrations_.first(), requested, achieved, missed);
+}
+
+void SysfsAdaptorReader::readPath(int index)
+{
+    int fd = parent_->sysfsDescriptors_.at(index);
+    parent_->processSample(parent_->pathIds_.at(index), fd);
+
+    if (parent_->doSeek_)
+    {
+        if (lseek(fd, 0, SEEK_SET) == -1)
+        {
+            sensordLogW() << "Failed to lseek fd: " << strerror(errno);
         }
     }
 }
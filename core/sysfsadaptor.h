@@ -31,6 +31,7 @@
 
 #include "deviceadaptor.h"
 #include "deviceadaptorringbuffer.h"
+#include "adaptorreactor.h"
 #include <QString>
 #include <QStringList>
 #include <QThread>
@@ -40,13 +41,12 @@
 class SysfsAdaptor;
 
 /**
- * Threading functionality for SysfsAdaptor. Helper class that removes
- * ambiguous inheritance from QObject. Should not be invoked directly
- * by anything except #SysfsAdaptor.
+ * Reactor callbacks for SysfsAdaptor. Helper class that removes
+ * ambiguous inheritance. Should not be invoked directly by anything
+ * except #SysfsAdaptor.
  */
-class SysfsAdaptorReader : public QThread
+class SysfsAdaptorReader : public ReactorHandler
 {
-    Q_OBJECT
     Q_DISABLE_COPY(SysfsAdaptorReader)
 
 public:
@@ -58,23 +58,43 @@ public:
     SysfsAdaptorReader(SysfsAdaptor *parent);
 
     /**
-     * Reader thread entry-function.
+     * Destructor.
      */
-    void run();
+    ~SysfsAdaptorReader();
 
     /**
-     * Initiate reader stopping.
+     * Initiate reader stopping. When this returns no reads are in
+     * progress.
      */
     void stopReader();
 
     /**
-     * Initiate reader starting.
+     * Initiate reader starting. Registers open descriptors with the
+     * reactor in SelectMode, or a timer in IntervalMode.
+     *
+     * @return was reader started succesfully.
+     */
+    bool startReader();
+
+    void readyRead(int fd, bool error);
+    void timeout();
+
+    /**
+     * Polling rate statistics in IntervalMode. For more details see
+     * #AdaptorReactor::timerRate().
      */
-    void startReader();
+    bool rate(double& requested, double& achieved, quint64& missed) const;
 
 private:
-    bool          running_; /**< should thread be running or not */
-    SysfsAdaptor *parent_;  /**< parent object. */
+    /**
+     * Process sample from given path and rewind it if needed.
+     *
+     * @param index Index of the path.
+     */
+    void readPath(int index);
+
+    QList<int>    registrations_; /**< reactor registration IDs */
+    SysfsAdaptor *parent_;        /**< parent object. */
 };
 
 /**
@@ -150,6 +170,8 @@ public:
 
     virtual bool resume();
 
+    virtual bool pollingRate(double& requested, double& achieved, quint64& missed) const;
+
 protected:
     /**
      * Called when new data is available on some file descriptor.
@@ -192,8 +214,8 @@ protected:
 
     /**
      * Sets the interval for the adaptor. This function is valid for
-     * adaptors using PollMode. It just sets the number of milliseconds
-     * that the adaptor will sleep between reads.
+     * adaptors using PollMode. It just sets the period in milliseconds
+     * at which the adaptor reads its files.
      *
      * For adaptors using SelectMode, reimplementation is a must as this
      * implementatino will have no effect on the behavior.
@@ -229,14 +251,14 @@ private:
     void closeAllFds();
 
     /**
-     * Stop reader thread.
+     * Stop reading. Unregisters the adaptor from #AdaptorReactor.
      */
     void stopReaderThread();
 
     /**
-     * Start reader thread.
+     * Start reading. Registers the adaptor with #AdaptorReactor.
      *
-     * @return was thread started succesfully.
+     * @return was reading started succesfully.
      */
     bool startReaderThread();
 
@@ -245,10 +267,8 @@ private:
      */
     bool checkIntervalUsage() const;
 
-    SysfsAdaptorReader  reader_; /**< reader thread instance */
+    SysfsAdaptorReader  reader_; /**< reactor callbacks */
     PollMode            mode_;   /**< used poll mode */
-    int                 epollDescriptor_;    /**< open epoll descriptors */
-    int                 pipeDescriptors_[2]; /**< open pipe descriptors */
     QStringList         paths_;   /**< added paths. */
     QList<int>          pathIds_; /**< added path IDs. */
     unsigned int interval_; /**< used interval */
@@ -0,0 +1,332 @@
+/**
+   @file xyzkernels.cpp
+   @brief XyzKernels
+
+   <p>
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include "xyzkernels.h"
+#include "logging.h"
+#include <stddef.h>
+
+#if defined(__SSE2__)
+#define XYZKERNELS_X86
+#include <immintrin.h>
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#define XYZKERNELS_NEON
+#include <arm_neon.h>
+#endif
+
+typedef void (*TransformKernel)(const double* m, const char* in, int inStride, char* out, int outStride, unsigned n);
+typedef void (*ScaleKernel)(int factor, int components, const char* in, int inStride, char* out, int outStride, unsigned n);
+
+/**
+ * Kernels of one implementation.
+ */
+struct KernelSet
+{
+    TransformKernel transform; /**< matrix transform, NULL if unavailable */
+    ScaleKernel     scale;     /**< scaling, NULL if unavailable */
+};
+
+static inline const int* record(const char* base, unsigned i, int stride)
+{
+    return (const int*)(base + (size_t)i * stride);
+}
+
+static inline int* record(char* base, unsigned i, int stride)
+{
+    return (int*)(base + (size_t)i * stride);
+}
+
+static void transformScalar(const double* m, const char* in, int inStride, char* out, int outStride, unsigned n)
+{
+    for (unsigned i = 0; i < n; ++i) {
+        const int* s = record(in, i, inStride);
+        int* d = record(out, i, outStride);
+        double x = s[0];
+        double y = s[1];
+        double z = s[2];
+        d[0] = (int)(m[0] * x + m[1] * y + m[2] * z);
+        d[1] = (int)(m[3] * x + m[4] * y + m[5] * z);
+        d[2] = (int)(m[6] * x + m[7] * y + m[8] * z);
+    }
+}
+
+static void scaleScalar(int factor, int components, const char* in, int inStride, char* out, int outStride, unsigned n)
+{
+    for (unsigned i = 0; i < n; ++i) {
+        const int* s = record(in, i, inStride);
+        int* d = record(out, i, outStride);
+        for (int j = 0; j < components; ++j)
+            d[j] = (int)((unsigned)s[j] * (unsigned)factor);
+    }
+}
+
+#ifdef XYZKERNELS_X86
+
+static void transformSse2(const double* m, const char* in, int inStride, char* out, int outStride, unsigned n)
+{
+    const __m128d m0 = _mm_set1_pd(m[0]), m1 = _mm_set1_pd(m[1]), m2 = _mm_set1_pd(m[2]);
+    const __m128d m3 = _mm_set1_pd(m[3]), m4 = _mm_set1_pd(m[4]), m5 = _mm_set1_pd(m[5]);
+    const __m128d m6 = _mm_set1_pd(m[6]), m7 = _mm_set1_pd(m[7]), m8 = _mm_set1_pd(m[8]);
+
+    unsigned i = 0;
+    for (; i + 2 <= n; i += 2) {
+        const int* s0 = record(in, i, inStride);
+        const int* s1 = record(in, i + 1, inStride);
+        __m128d x = _mm_set_pd(s1[0], s0[0]);
+        __m128d y = _mm_set_pd(s1[1], s0[1]);
+        __m128d z = _mm_set_pd(s1[2], s0[2]);
+
+        __m128i rx = _mm_cvttpd_epi32(_mm_add_pd(_mm_add_pd(_mm_mul_pd(m0, x), _mm_mul_pd(m1, y)), _mm_mul_pd(m2, z)));
+        __m128i ry = _mm_cvttpd_epi32(_mm_add_pd(_mm_add_pd(_mm_mul_pd(m3, x), _mm_mul_pd(m4, y)), _mm_mul_pd(m5, z)));
+        __m128i rz = _mm_cvttpd_epi32(_mm_add_pd(_mm_add_pd(_mm_mul_pd(m6, x), _mm_mul_pd(m7, y)), _mm_mul_pd(m8, z)));
+
+        int* d0 = record(out, i, outStride);
+        int* d1 = record(out, i + 1, outStride);
+        d0[0] = _mm_cvtsi128_si32(rx);
+        d0[1] = _mm_cvtsi128_si32(ry);
+        d0[2] = _mm_cvtsi128_si32(rz);
+        d1[0] = _mm_cvtsi128_si32(_mm_srli_si128(rx, 4));
+        d1[1] = _mm_cvtsi128_si32(_mm_srli_si128(ry, 4));
+        d1[2] = _mm_cvtsi128_si32(_mm_srli_si128(rz, 4));
+    }
+    transformScalar(m, in + (size_t)i * inStride, inStride, out + (size_t)i * outStride, outStride, n - i);
+}
+
+/**
+ * Low 32 bits of lane-wise 32-bit products, SSE2 lacks pmulld.
+ */
+static inline __m128i mulloSse2(__m128i a, __m128i b)
+{
+    __m128i even = _mm_mul_epu32(a, b);
+    __m128i odd = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                              _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+static void scaleSse2(int factor, int components, const char* in, int inStride, char* out, int outStride, unsigned n)
+{
+    const __m128i f = _mm_set1_epi32(factor);
+    for (unsigned i = 0; i < n; ++i) {
+        const int* s = record(in, i, inStride);
+        int* d = record(out, i, outStride);
+        int j = 0;
+        for (; j + 4 <= components; j += 4)
+            _mm_storeu_si128((__m128i*)(d + j), mulloSse2(_mm_loadu_si128((const __m128i*)(s + j)), f));
+        for (; j < components; ++j)
+            d[j] = (int)((unsigned)s[j] * (unsigned)factor);
+    }
+}
+
+__attribute__((target("avx")))
+static void transformAvx(const double* m, const char* in, int inStride, char* out, int outStride, unsigned n)
+{
+    const __m256d m0 = _mm256_set1_pd(m[0]), m1 = _mm256_set1_pd(m[1]), m2 = _mm256_set1_pd(m[2]);
+    const __m256d m3 = _mm256_set1_pd(m[3]), m4 = _mm256_set1_pd(m[4]), m5 = _mm256_set1_pd(m[5]);
+    const __m256d m6 = _mm256_set1_pd(m[6]), m7 = _mm256_set1_pd(m[7]), m8 = _mm256_set1_pd(m[8]);
+
+    unsigned i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const int* s0 = record(in, i, inStride);
+        const int* s1 = record(in, i + 1, inStride);
+        const int* s2 = record(in, i + 2, inStride);
+        const int* s3 = record(in, i + 3, inStride);
+        __m256d x = _mm256_cvtepi32_pd(_mm_set_epi32(s3[0], s2[0], s1[0], s0[0]));
+        __m256d y = _mm256_cvtepi32_pd(_mm_set_epi32(s3[1], s2[1], s1[1], s0[1]));
+        __m256d z = _mm256_cvtepi32_pd(_mm_set_epi32(s3[2], s2[2], s1[2], s0[2]));
+
+        int rx[4], ry[4], rz[4];
+        _mm_storeu_si128((__m128i*)rx, _mm256_cvttpd_epi32(_mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(m0, x), _mm256_mul_pd(m1, y)), _mm256_mul_pd(m2, z))));
+        _mm_storeu_si128((__m128i*)ry, _mm256_cvttpd_epi32(_mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(m3, x), _mm256_mul_pd(m4, y)), _mm256_mul_pd(m5, z))));
+        _mm_storeu_si128((__m128i*)rz, _mm256_cvttpd_epi32(_mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(m6, x), _mm256_mul_pd(m7, y)), _mm256_mul_pd(m8, z))));
+
+        for (int k = 0; k < 4; ++k) {
+            int* d = record(out, i + k, outStride);
+            d[0] = rx[k];
+            d[1] = ry[k];
+            d[2] = rz[k];
+        }
+    }
+    transformSse2(m, in + (size_t)i * inStride, inStride, out + (size_t)i * outStride, outStride, n - i);
+}
+
+__attribute__((target("avx")))
+static void scaleAvx(int factor, int components, const char* in, int inStride, char* out, int outStride, unsigned n)
+{
+    const __m128i f = _mm_set1_epi32(factor);
+    for (unsigned i = 0; i < n; ++i) {
+        const int* s = record(in, i, inStride);
+        int* d = record(out, i, outStride);
+        int j = 0;
+        for (; j + 4 <= components; j += 4)
+            _mm_storeu_si128((__m128i*)(d + j), _mm_mullo_epi32(_mm_loadu_si128((const __m128i*)(s + j)), f));
+        for (; j < components; ++j)
+            d[j] = (int)((unsigned)s[j] * (unsigned)factor);
+    }
+}
+
+#endif // XYZKERNELS_X86
+
+#ifdef XYZKERNELS_NEON
+
+static void transformNeon(const double* m, const char* in, int inStride, char* out, int outStride, unsigned n)
+{
+    const float64x2_t m0 = vdupq_n_f64(m[0]), m1 = vdupq_n_f64(m[1]), m2 = vdupq_n_f64(m[2]);
+    const float64x2_t m3 = vdupq_n_f64(m[3]), m4 = vdupq_n_f64(m[4]), m5 = vdupq_n_f64(m[5]);
+    const float64x2_t m6 = vdupq_n_f64(m[6]), m7 = vdupq_n_f64(m[7]), m8 = vdupq_n_f64(m[8]);
+
+    unsigned i = 0;
+    for (; i + 2 <= n; i += 2) {
+        const int* s0 = record(in, i, inStride);
+        const int* s1 = record(in, i + 1, inStride);
+        const double xs[2] = { (double)s0[0], (double)s1[0] };
+        const double ys[2] = { (double)s0[1], (double)s1[1] };
+        const double zs[2] = { (double)s0[2], (double)s1[2] };
+        float64x2_t x = vld1q_f64(xs);
+        float64x2_t y = vld1q_f64(ys);
+        float64x2_t z = vld1q_f64(zs);
+
+        // Separate multiply and add keep results equal to the scalar kernel.
+        int64x2_t rx = vcvtq_s64_f64(vaddq_f64(vaddq_f64(vmulq_f64(m0, x), vmulq_f64(m1, y)), vmulq_f64(m2, z)));
+        int64x2_t ry = vcvtq_s64_f64(vaddq_f64(vaddq_f64(vmulq_f64(m3, x), vmulq_f64(m4, y)), vmulq_f64(m5, z)));
+        int64x2_t rz = vcvtq_s64_f64(vaddq_f64(vaddq_f64(vmulq_f64(m6, x), vmulq_f64(m7, y)), vmulq_f64(m8, z)));
+
+        int* d0 = record(out, i, outStride);
+        int* d1 = record(out, i + 1, outStride);
+        d0[0] = (int)vgetq_lane_s64(rx, 0);
+        d0[1] = (int)vgetq_lane_s64(ry, 0);
+        d0[2] = (int)vgetq_lane_s64(rz, 0);
+        d1[0] = (int)vgetq_lane_s64(rx, 1);
+        d1[1] = (int)vgetq_lane_s64(ry, 1);
+        d1[2] = (int)vgetq_lane_s64(rz, 1);
+    }
+    transformScalar(m, in + (size_t)i * inStride, inStride, out + (size_t)i * outStride, outStride, n - i);
+}
+
+static void scaleNeon(int factor, int components, const char* in, int inStride, char* out, int outStride, unsigned n)
+{
+    const int32x4_t f = vdupq_n_s32(factor);
+    for (unsigned i = 0; i < n; ++i) {
+        const int* s = record(in, i, inStride);
+        int* d = record(out, i, outStride);
+        int j = 0;
+        for (; j + 4 <= components; j += 4)
+            vst1q_s32(d + j, vmulq_s32(vld1q_s32(s + j), f));
+        for (; j < components; ++j)
+            d[j] = (int)((unsigned)s[j] * (unsigned)factor);
+    }
+}
+
+#endif // XYZKERNELS_NEON
+
+static const KernelSet KERNELS[XyzKernels::ImplementationCount] = {
+    { transformScalar, scaleScalar },
+#ifdef XYZKERNELS_X86
+    { transformSse2, scaleSse2 },
+    { transformAvx, scaleAvx },
+#else
+    { NULL, NULL },
+    { NULL, NULL },
+#endif
+#ifdef XYZKERNELS_NEON
+    { transformNeon, scaleNeon },
+#else
+    { NULL, NULL },
+#endif
+};
+
+static const char* const NAMES[XyzKernels::ImplementationCount] = {
+    "scalar",
+    "sse2",
+    "avx",
+    "neon"
+};
+
+static int selectedImplementation = -1;
+
+static const KernelSet& kernels()
+{
+    int impl = __atomic_load_n(&selectedImplementation, __ATOMIC_RELAXED);
+    if (impl < 0) {
+        // Prefer the widest supported implementation. Racing first
+        // callers pick the same one.
+        impl = XyzKernels::Scalar;
+        for (int i = XyzKernels::ImplementationCount - 1; i > XyzKernels::Scalar; --i) {
+            if (XyzKernels::supported((XyzKernels::Implementation)i)) {
+                impl = i;
+                break;
+            }
+        }
+        __atomic_store_n(&selectedImplementation, impl, __ATOMIC_RELAXED);
+        sensordLogD() << "Using" << NAMES[impl] << "XYZ kernels";
+    }
+    return KERNELS[impl];
+}
+
+void XyzKernels::transform(const double matrix[3][3],
+                           const int* in, int inStride,
+                           int* out, int outStride,
+                           unsigned n)
+{
+    kernels().transform(&matrix[0][0], (const char*)in, inStride, (char*)out, outStride, n);
+}
+
+void XyzKernels::scale(int factor, int components,
+                       const int* in, int inStride,
+                       int* out, int outStride,
+                       unsigned n)
+{
+    kernels().scale(factor, components, (const char*)in, inStride, (char*)out, outStride, n);
+}
+
+XyzKernels::Implementation XyzKernels::implementation()
+{
+    kernels();
+    return (Implementation)__atomic_load_n(&selectedImplementation, __ATOMIC_RELAXED);
+}
+
+bool XyzKernels::supported(Implementation impl)
+{
+    if (impl < 0 || impl >= ImplementationCount || !KERNELS[impl].transform)
+        return false;
+#ifdef XYZKERNELS_X86
+    if (impl == Avx) {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx");
+    }
+#endif
+    return true;
+}
+
+bool XyzKernels::setImplementation(Implementation impl)
+{
+    if (!supported(impl))
+        return false;
+    __atomic_store_n(&selectedImplementation, (int)impl, __ATOMIC_RELAXED);
+    return true;
+}
+
+const char* XyzKernels::name(Implementation impl)
+{
+    if (impl < 0 || impl >= ImplementationCount)
+        return "unknown";
+    return NAMES[impl];
+}
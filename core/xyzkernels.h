@@ -0,0 +1,116 @@
+/**
+   @file xyzkernels.h
+   @brief XyzKernels
+
+   <p>
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef XYZKERNELS_H
+#define XYZKERNELS_H
+
+/**
+ * Batch kernels for XYZ sample transformations.
+ *
+ * Kernels work on arrays of structures: each record holds its integer
+ * components next to each other, and records follow each other with a
+ * given stride in bytes. Input and output may be the same array.
+ *
+ * The implementation is selected on first use from the instruction set
+ * extensions supported by the CPU: AVX or SSE2 on x86, NEON on ARM, and
+ * a portable scalar loop otherwise. All implementations produce the same
+ * result as the scalar one.
+ */
+class XyzKernels
+{
+public:
+    /**
+     * Kernel implementations.
+     */
+    enum Implementation
+    {
+        Scalar = 0, /**< portable C++ */
+        Sse2,       /**< x86 SSE2, two records per step */
+        Avx,        /**< x86 AVX, four records per step */
+        Neon,       /**< ARM NEON */
+        ImplementationCount
+    };
+
+    /**
+     * Multiply XYZ vectors by a 3x3 matrix. Products are summed as
+     * doubles in row order and truncated to integers.
+     *
+     * @param matrix Row-major matrix.
+     * @param in First component of the first input record.
+     * @param inStride Distance between input records in bytes.
+     * @param out First component of the first output record.
+     * @param outStride Distance between output records in bytes.
+     * @param n Number of records.
+     */
+    static void transform(const double matrix[3][3],
+                          const int* in, int inStride,
+                          int* out, int outStride,
+                          unsigned n);
+
+    /**
+     * Multiply integer components by a factor.
+     *
+     * @param factor Scale factor.
+     * @param components Number of consecutive components per record.
+     * @param in First component of the first input record.
+     * @param inStride Distance between input records in bytes.
+     * @param out First component of the first output record.
+     * @param outStride Distance between output records in bytes.
+     * @param n Number of records.
+     */
+    static void scale(int factor, int components,
+                      const int* in, int inStride,
+                      int* out, int outStride,
+                      unsigned n);
+
+    /**
+     * Currently used implementation.
+     *
+     * @return implementation.
+     */
+    static Implementation implementation();
+
+    /**
+     * Is implementation available on this build and CPU.
+     *
+     * @param impl Implementation.
+     * @return is it available.
+     */
+    static bool supported(Implementation impl);
+
+    /**
+     * Override the selected implementation, used by benchmarks.
+     *
+     * @param impl Implementation.
+     * @return false if the implementation is not supported.
+     */
+    static bool setImplementation(Implementation impl);
+
+    /**
+     * Name of an implementation.
+     *
+     * @param impl Implementation.
+     * @return name.
+     */
+    static const char* name(Implementation impl);
+};
+
+#endif // XYZKERNELS_H
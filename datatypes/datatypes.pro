@@ -23,7 +23,8 @@ HEADERS += xyz.h \
     posedata.h \
     tapdata.h \
     touchdata.h \
-    proximity.h
+    proximity.h \
+    sessionconfig.h
 
 SOURCES += xyz.cpp \
     orientation.cpp \
@@ -0,0 +1,88 @@
+/**
+   @file sessionconfig.h
+   @brief Datatype containing the client settings of a sensor session.
+
+   <p>
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef SESSIONCONFIG_H
+#define SESSIONCONFIG_H
+
+#include <QDBusArgument>
+#include <QMetaType>
+
+/**
+ * Client settings of a sensor session, applied together with starting
+ * the session. See SensorManagerAdaptor::openAndStart().
+ */
+struct SessionConfig
+{
+    /**
+     * Default constructor, matching the defaults of a new session.
+     */
+    SessionConfig() :
+        sessionId(-1),
+        interval(0),
+        bufferInterval(0),
+        bufferSize(1),
+        standbyOverride(false),
+        downsampling(true)
+    {}
+
+    int sessionId;               /**< existing session, -1 to open a new one */
+    int interval;                /**< interval in milliseconds, 0 for default */
+    unsigned int bufferInterval; /**< buffer interval in milliseconds */
+    unsigned int bufferSize;     /**< buffer size */
+    bool standbyOverride;        /**< keep running when display is off */
+    bool downsampling;           /**< downsampling enabled */
+};
+
+Q_DECLARE_METATYPE( SessionConfig )
+
+/**
+ * Marshall the SessionConfig into a D-Bus argument
+ *
+ * @param argument dbus argument.
+ * @param config data to marshall.
+ * @return dbus argument.
+ */
+inline QDBusArgument &operator<<(QDBusArgument &argument, const SessionConfig &config)
+{
+    argument.beginStructure();
+    argument << config.sessionId << config.interval << config.bufferInterval << config.bufferSize
+             << config.standbyOverride << config.downsampling;
+    argument.endStructure();
+    return argument;
+}
+
+/**
+ * Unmarshall SessionConfig from the D-Bus argument
+ *
+ * @param argument dbus argument.
+ * @param config unmarshalled data.
+ * @return dbus argument.
+ */
+inline const QDBusArgument &operator>>(const QDBusArgument &argument, SessionConfig &config)
+{
+    argument.beginStructure();
+    argument >> config.sessionId >> config.interval >> config.bufferInterval >> config.bufferSize
+             >> config.standbyOverride >> config.downsampling;
+    argument.endStructure();
+    return argument;
+}
+
+#endif // SESSIONCONFIG_H
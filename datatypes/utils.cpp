@@ -39,6 +39,7 @@
 #include "tap.h"
 #include "posedata.h"
 #include "proximity.h"
+#include "sessionconfig.h"
 
 void __attribute__ ((constructor)) datatypes_init(void)
 {
@@ -52,6 +53,7 @@ void __attribute__ ((constructor)) datatypes_init(void)
     qDBusRegisterMetaType<DataRangeList>();
     qDBusRegisterMetaType<IntegerRange>();
     qDBusRegisterMetaType<IntegerRangeList>();
+    qDBusRegisterMetaType<SessionConfig>();
     qRegisterMetaType<TimedUnsigned>();
     qRegisterMetaType<PoseData>();
     qRegisterMetaType<Proximity>();
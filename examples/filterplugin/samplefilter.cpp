@@ -24,24 +24,29 @@
  */
 
 #include "samplefilter.h"
+#include <QVarLengthArray>
 
 SampleFilter::SampleFilter() :
         Filter<TimedUnsigned, SampleFilter, TimedUnsigned>(this, &SampleFilter::filter)
 {
 }
 
-void SampleFilter::filter(unsigned, const TimedUnsigned* data)
+void SampleFilter::filter(unsigned n, const TimedUnsigned* data)
 {
-    TimedUnsigned transformed;
-
-    // Usually you want to keep the timestamp of the original data, as
-    // one is likely to be interested in the time that the action
-    // happened. Apply common sense.
-    transformed.timestamp_ = data->timestamp_;
-
-    // Do something for the value.
-    transformed.value_ = data->value_ * data->value_;
-
-    // Propagate the altered sample to outputs
-    source_.propagate(1, &transformed);
+    // Filters receive samples in batches. Process all of them and
+    // propagate the results together.
+    QVarLengthArray<TimedUnsigned, BATCH_SIZE> transformed(n);
+
+    for (unsigned i = 0; i < n; ++i) {
+        // Usually you want to keep the timestamp of the original data, as
+        // one is likely to be interested in the time that the action
+        // happened. Apply common sense.
+        transformed[i].timestamp_ = data[i].timestamp_;
+
+        // Do something for the value.
+        transformed[i].value_ = data[i].value_ * data[i].value_;
+    }
+
+    // Propagate the altered samples to outputs
+    source_.propagate(n, transformed.constData());
 }
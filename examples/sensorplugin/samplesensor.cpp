@@ -58,7 +58,7 @@ SampleSensorChannel::SampleSensorChannel(const QString& id) :
     marshallingBin_ = new Bin;
     marshallingBin_->add(this, "sensorchannel");
 
-    outputBuffer_->join(this);
+    connectToBuffer(outputBuffer_, this);
 
     // Set MetaData
     setDescription("Funky sample data");
@@ -19,6 +19,7 @@
  */
 
 #include "avgaccfilter.h"
+#include <QVarLengthArray>
 #include <math.h>
 #define FILTER_COUNT 10
 
@@ -29,22 +30,26 @@ AvgAccFilter::AvgAccFilter() :
 {
 }
 
-void AvgAccFilter::interpret(unsigned, const TimedXyzData *data)
+void AvgAccFilter::interpret(unsigned n, const TimedXyzData *data)
 {
-    avgAccdata.x_ = data->x_ * filterFactor + averageX * (1.0f - filterFactor);
-    avgAccdata.y_ = data->y_ * filterFactor + averageY * (1.0f - filterFactor);
-    avgAccdata.z_ = data->z_ * filterFactor + averageZ * (1.0f - filterFactor);
+    QVarLengthArray<TimedXyzData, BATCH_SIZE> filteredData(n);
 
-    TimedXyzData filteredData(data->timestamp_,
-                              avgAccdata.x_,
-                              avgAccdata.y_,
-                              avgAccdata.z_);
+    for (unsigned i = 0; i < n; ++i) {
+        avgAccdata.x_ = data[i].x_ * filterFactor + averageX * (1.0f - filterFactor);
+        avgAccdata.y_ = data[i].y_ * filterFactor + averageY * (1.0f - filterFactor);
+        avgAccdata.z_ = data[i].z_ * filterFactor + averageZ * (1.0f - filterFactor);
 
-    source_.propagate(1, &filteredData);
+        filteredData[i] = TimedXyzData(data[i].timestamp_,
+                                       avgAccdata.x_,
+                                       avgAccdata.y_,
+                                       avgAccdata.z_);
 
-    averageX = avgAccdata.x_;
-    averageY = avgAccdata.y_;
-    averageZ = avgAccdata.z_;
+        averageX = avgAccdata.x_;
+        averageY = avgAccdata.y_;
+        averageZ = avgAccdata.z_;
+    }
+
+    source_.propagate(n, filteredData.constData());
 }
 
 void AvgAccFilter::reset()
@@ -25,21 +25,27 @@
  */
 
 #include "coordinatealignfilter.h"
+#include "xyzkernels.h"
+#include <QVarLengthArray>
 
 CoordinateAlignFilter::CoordinateAlignFilter() :
         Filter<TimedXyzData, CoordinateAlignFilter, TimedXyzData>(this, &CoordinateAlignFilter::filter)
 {
 }
 
-void CoordinateAlignFilter::filter(unsigned, const TimedXyzData* data)
+void CoordinateAlignFilter::filter(unsigned n, const TimedXyzData* data)
 {
-    TimedXyzData transformed;
+    if (!n)
+        return;
 
-    transformed.timestamp_ = data->timestamp_;
+    QVarLengthArray<TimedXyzData, BATCH_SIZE> transformed(n);
+    for (unsigned i = 0; i < n; ++i)
+        transformed[i].timestamp_ = data[i].timestamp_;
 
-    transformed.x_ = matrix_.get(0,0)*data->x_ + matrix_.get(0,1)*data->y_ + matrix_.get(0,2)*data->z_;
-    transformed.y_ = matrix_.get(1,0)*data->x_ + matrix_.get(1,1)*data->y_ + matrix_.get(1,2)*data->z_;
-    transformed.z_ = matrix_.get(2,0)*data->x_ + matrix_.get(2,1)*data->y_ + matrix_.get(2,2)*data->z_;
+    XyzKernels::transform(matrix_.data_,
+                          &data[0].x_, sizeof(TimedXyzData),
+                          &transformed[0].x_, sizeof(TimedXyzData),
+                          n);
 
-    source_.propagate(1, &transformed);
+    source_.propagate(n, transformed.constData());
 }
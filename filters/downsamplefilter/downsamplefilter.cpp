@@ -25,12 +25,14 @@
 
 #include "downsamplefilter.h"
 #include "logging.h"
+#include <QVarLengthArray>
 // averaging filter
 
 DownsampleFilter::DownsampleFilter() :
     Filter<TimedXyzData, DownsampleFilter, TimedXyzData>(this, &DownsampleFilter::filter),
     bufferSize_(1),
-    timeout_(-1)
+    timeout_(-1),
+    buffer_(1)
 {
 }
 
@@ -43,6 +45,7 @@ void DownsampleFilter::setBufferSize(unsigned int size)
 {
     sensordLogD() << "DownsampleFilter buffer size = " << size;
     bufferSize_ = size;
+    buffer_.reserve(size);
 }
 
 int DownsampleFilter::timeout() const
@@ -56,44 +59,34 @@ void DownsampleFilter::setTimeout(int ms)
     sensordLogD() << "DownsampleFilter timeout = " << ms;
 }
 
-void DownsampleFilter::filter(unsigned, const TimedXyzData* data)
+void DownsampleFilter::filter(unsigned n, const TimedXyzData* samples)
 {
-    buffer_.push_back(*data);
+    QVarLengthArray<TimedXyzData, BATCH_SIZE> output;
 
-    for(TimedXyzDownsampleBuffer::iterator it = buffer_.begin(); it != buffer_.end(); ++it)
-    {
-        if(static_cast<unsigned int>(buffer_.size()) > bufferSize_ ||
-           (timeout_ && (data->timestamp_ - it->timestamp_ >
-                         static_cast<unsigned long>(timeout_))))
+    for (unsigned i = 0; i < n; ++i) {
+        const TimedXyzData* data = &samples[i];
+
+        // Make room for the new sample and drop samples that timed out
+        while(buffer_.count() > 0 &&
+              (static_cast<unsigned int>(buffer_.count()) >= bufferSize_ ||
+               (timeout_ && (data->timestamp_ - buffer_.front().timestamp_ >
+                             static_cast<unsigned long>(timeout_)))))
         {
-            it = buffer_.erase(it);
-            if(it == buffer_.end())
-                break;
+            buffer_.popFront();
         }
-        else
-            break;
-    }
+        buffer_.push(*data);
 
-    if(static_cast<unsigned int>(buffer_.size()) < bufferSize_)
-        return;
-
-    long x = 0;
-    long y = 0;
-    long z = 0;
-    foreach(const TimedXyzData& data, buffer_)
-    {
-        x += data.x_;
-        y += data.y_;
-        z += data.z_;
-    }
-    int count = buffer_.count();
-    TimedXyzData downsampled(data->timestamp_,
-                             x / count,
-                             y / count,
-                             z / count);
+        if(static_cast<unsigned int>(buffer_.count()) < bufferSize_)
+            continue;
 
-//    sensordLogT() << "Downsampled: " << downsampled.x_ << ", " << downsampled.y_ << ", " << downsampled.z_;
+        TimedXyzData downsampled(buffer_.average(*data));
+
+//        sensordLogT() << "Downsampled: " << downsampled.x_ << ", " << downsampled.y_ << ", " << downsampled.z_;
+
+        output.append(downsampled);
+        buffer_.clear();
+    }
 
-    source_.propagate(1, &downsampled);
-    buffer_.clear();
+    if (!output.isEmpty())
+        source_.propagate(output.size(), output.constData());
 }
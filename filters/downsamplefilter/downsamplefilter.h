@@ -26,17 +26,18 @@
 #ifndef DOWNSAMPLEFILTER_H
 #define DOWNSAMPLEFILTER_H
 
-#include <QList>
 #include <QObject>
 #include "datatypes/orientationdata.h"
 #include "filter.h"
+#include "samplewindow.h"
 
 /**
  * @brief Downsample filter.
  *
  * Downsamples incoming XYZ data by having defined buffer sizes from where
  * average will be calculated when the buffer is full. Timeout can be used
- * to control how old samples get discarded.
+ * to control how old samples get discarded. Samples are kept in a ring
+ * with a running sum, so each sample is handled in constant time.
  */
 class DownsampleFilter : public QObject, public Filter<TimedXyzData, DownsampleFilter, TimedXyzData>
 {
@@ -95,12 +96,9 @@ private:
      */
     void filter(unsigned, const TimedXyzData*);
 
-    /** Sample buffer type for TimedXyzData downsampling. */
-    typedef QList<TimedXyzData> TimedXyzDownsampleBuffer;
-
     unsigned int bufferSize_; /**< buffer size */
     long timeout_;   /**< timeout in milliseconds */
-    TimedXyzDownsampleBuffer buffer_; /**< downsample buffer */
+    SampleWindow<TimedXyzData> buffer_; /**< downsample buffer */
 };
 
 #endif // DOWNSAMPLEFILTER_H
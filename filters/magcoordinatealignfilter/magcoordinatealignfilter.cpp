@@ -25,27 +25,33 @@
  */
 
 #include "magcoordinatealignfilter.h"
+#include "xyzkernels.h"
+#include <QVarLengthArray>
 
 MagCoordinateAlignFilter::MagCoordinateAlignFilter() :
         Filter<CalibratedMagneticFieldData, MagCoordinateAlignFilter, CalibratedMagneticFieldData>(this, &MagCoordinateAlignFilter::filter)
 {
 }
 
-void MagCoordinateAlignFilter::filter(unsigned, const CalibratedMagneticFieldData* data)
+void MagCoordinateAlignFilter::filter(unsigned n, const CalibratedMagneticFieldData* data)
 {
-    CalibratedMagneticFieldData transformed;
-
-    transformed.timestamp_ = data->timestamp_;
-
-    transformed.x_ = matrix_.get(0,0)*data->x_ + matrix_.get(0,1)*data->y_ + matrix_.get(0,2)*data->z_;
-    transformed.y_ = matrix_.get(1,0)*data->x_ + matrix_.get(1,1)*data->y_ + matrix_.get(1,2)*data->z_;
-    transformed.z_ = matrix_.get(2,0)*data->x_ + matrix_.get(2,1)*data->y_ + matrix_.get(2,2)*data->z_;
-
-    transformed.rx_ = matrix_.get(0,0)*data->rx_ + matrix_.get(0,1)*data->ry_ + matrix_.get(0,2)*data->rz_;
-    transformed.ry_ = matrix_.get(1,0)*data->rx_ + matrix_.get(1,1)*data->ry_ + matrix_.get(1,2)*data->rz_;
-    transformed.rz_ = matrix_.get(2,0)*data->rx_ + matrix_.get(2,1)*data->ry_ + matrix_.get(2,2)*data->rz_;
-
-    transformed.level_ = data->level_;
-
-    source_.propagate(1, &transformed);
+    if (!n)
+        return;
+
+    QVarLengthArray<CalibratedMagneticFieldData, BATCH_SIZE> transformed(n);
+    for (unsigned i = 0; i < n; ++i) {
+        transformed[i].timestamp_ = data[i].timestamp_;
+        transformed[i].level_ = data[i].level_;
+    }
+
+    XyzKernels::transform(matrix_.data_,
+                          &data[0].x_, sizeof(CalibratedMagneticFieldData),
+                          &transformed[0].x_, sizeof(CalibratedMagneticFieldData),
+                          n);
+    XyzKernels::transform(matrix_.data_,
+                          &data[0].rx_, sizeof(CalibratedMagneticFieldData),
+                          &transformed[0].rx_, sizeof(CalibratedMagneticFieldData),
+                          n);
+
+    source_.propagate(n, transformed.constData());
 }
@@ -66,6 +66,10 @@ OrientationInterpreter::OrientationInterpreter() :
     angleThresholdLandscape = Config::configuration()->value("orientation/threshold_landscape",QVariant(THRESHOLD_LANDSCAPE)).toInt();
     discardTime = Config::configuration()->value("orientation/discard_time", QVariant(DISCARD_TIME)).toUInt();
     maxBufferSize = Config::configuration()->value("orientation/buffer_size", QVariant(AVG_BUFFER_MAX_SIZE)).toInt();
+    if (maxBufferSize < 1)
+        maxBufferSize = 1;
+    dataBuffer.reserve(maxBufferSize);
+    precision = OrientationMath::configuredPrecision();
 
     // Open the handle for boosting cpu on changes that affect orientation
     if (cpuBoostFile.exists()) {
@@ -73,49 +77,51 @@ OrientationInterpreter::OrientationInterpreter() :
       }
 }
 
-void OrientationInterpreter::accDataAvailable(unsigned, const AccelerationData* pdata)
+void OrientationInterpreter::accDataAvailable(unsigned n, const AccelerationData* pdata)
 {
-    data = *pdata;
+    PoseBatch topEdges;
+    PoseBatch faces;
+    PoseBatch orientations;
 
-    // Check overflow
-    if (overFlowCheck())
+    for (unsigned i = 0; i < n; ++i)
     {
-        sensordLogT() << "Acc value discarded due to over/underflow";
-        return;
-    }
+        data = pdata[i];
 
-    // Append new value to buffer
-    dataBuffer.append(data);
+        // Check overflow
+        if (overFlowCheck())
+        {
+            sensordLogT() << "Acc value discarded due to over/underflow";
+            continue;
+        }
 
-    // Clear old values from buffer.
-    while (dataBuffer.count() > maxBufferSize || (dataBuffer.count() > 1 && (data.timestamp_ - dataBuffer.first().timestamp_ > discardTime)))
-    {
-        dataBuffer.removeFirst();
-    }
+        // Clear old values from buffer, leaving room for the new value.
+        while (dataBuffer.count() >= maxBufferSize || (dataBuffer.count() > 0 && (data.timestamp_ - dataBuffer.front().timestamp_ > discardTime)))
+        {
+            dataBuffer.popFront();
+        }
 
-    //Calculate average
-    long x = 0;
-    long y = 0;
-    long z = 0;
-    foreach (const AccelerationData& sample, dataBuffer)
-    {
-        x += sample.x_;
-        y += sample.y_;
-        z += sample.z_;
-    }
+        // Append new value to buffer
+        dataBuffer.push(data);
 
-    data.x_ = x / dataBuffer.count();
-    data.y_ = y / dataBuffer.count();
-    data.z_ = z / dataBuffer.count();
+        //Calculate average
+        data = dataBuffer.average(data);
 
-    // calculate topedge
-    processTopEdge();
+        // calculate topedge
+        processTopEdge(topEdges);
 
-    // calculate face
-    processFace();
+        // calculate face
+        processFace(faces);
+
+        // calculate orientation
+        processOrientation(orientations);
+    }
 
-    // calculate orientation
-    processOrientation();
+    if (!topEdges.isEmpty())
+        topEdgeSource.propagate(topEdges.size(), topEdges.constData());
+    if (!faces.isEmpty())
+        faceSource.propagate(faces.size(), faces.constData());
+    if (!orientations.isEmpty())
+        orientationSource.propagate(orientations.size(), orientations.constData());
 }
 
 bool OrientationInterpreter::overFlowCheck()
@@ -127,9 +133,9 @@ bool OrientationInterpreter::overFlowCheck()
 int OrientationInterpreter::orientationCheck(const AccelerationData &data,  OrientationMode mode) const
 {
     if (mode == OrientationInterpreter::Landscape)
-        return round(atan((double)data.x_ / sqrt(data.y_ * data.y_ + data.z_ * data.z_)) * RADIANS_TO_DEGREES);
+        return round(OrientationMath::elevation(data.x_, data.y_, data.z_, precision) * RADIANS_TO_DEGREES);
     else
-        return round(atan((double)data.y_ / sqrt(data.x_ * data.x_ + data.z_ * data.z_)) * RADIANS_TO_DEGREES);
+        return round(OrientationMath::elevation(data.y_, data.x_, data.z_, precision) * RADIANS_TO_DEGREES);
 }
 
 PoseData OrientationInterpreter::rotateToPortrait(int rotation)
@@ -175,7 +181,7 @@ PoseData OrientationInterpreter::orientationRotation (const AccelerationData &da
     return newTopEdge;
 }
 
-void OrientationInterpreter::processTopEdge()
+void OrientationInterpreter::processTopEdge(PoseBatch& topEdges)
 {
     PoseData newTopEdge = PoseData::Undefined;
     ptrFUN rotator;
@@ -212,11 +218,11 @@ void OrientationInterpreter::processTopEdge()
         topEdge.orientation_ = newTopEdge.orientation_;
         sensordLogT() << "new TopEdge value: " << topEdge.orientation_;
         topEdge.timestamp_ = data.timestamp_;
-        topEdgeSource.propagate(1, &topEdge);
+        topEdges.append(topEdge);
     }
 }
 
-void OrientationInterpreter::processFace()
+void OrientationInterpreter::processFace(PoseBatch& faces)
 {
     if (abs(data.z_) >= 300)
     {
@@ -238,12 +244,12 @@ void OrientationInterpreter::processFace()
         {
             previousFace.orientation_ = face.orientation_;
             face.timestamp_ = data.timestamp_;
-            faceSource.propagate(1, &face);
+            faces.append(face);
         }
     }
 }
 
-void OrientationInterpreter::processOrientation()
+void OrientationInterpreter::processOrientation(PoseBatch& orientations)
 {
     PoseData newPose;
 
@@ -257,6 +263,6 @@ void OrientationInterpreter::processOrientation()
         orientationData.orientation_ = newPose.orientation_;
         sensordLogT() << "New orientation value: " << orientationData.orientation_;
         orientationData.timestamp_ = data.timestamp_;
-        orientationSource.propagate(1, &orientationData);
+        orientations.append(orientationData);
     }
 }
@@ -31,7 +31,10 @@
 
 #include <QObject>
 #include <QFile>
+#include <QVarLengthArray>
 #include "filter.h"
+#include "samplewindow.h"
+#include "orientationmath.h"
 #include <datatypes/orientationdata.h>
 #include <datatypes/posedata.h>
 
@@ -54,12 +57,15 @@ private:
     Source<PoseData> faceSource;
     Source<PoseData> orientationSource;
 
+    /** Orientation changes detected within one input batch. */
+    typedef QVarLengthArray<PoseData, BATCH_SIZE> PoseBatch;
+
     void accDataAvailable(unsigned, const AccelerationData*);
 
     bool overFlowCheck();
-    void processTopEdge();
-    void processFace();
-    void processOrientation();
+    void processTopEdge(PoseBatch& topEdges);
+    void processFace(PoseBatch& faces);
+    void processOrientation(PoseBatch& orientations);
 
     OrientationInterpreter();
 
@@ -69,7 +75,7 @@ private:
     bool updatePreviousFace;
 
     AccelerationData data;
-    QList<AccelerationData> dataBuffer;
+    SampleWindow<AccelerationData> dataBuffer;
 
     int minLimit;
     int maxLimit;
@@ -77,6 +83,7 @@ private:
     int angleThresholdLandscape;
     unsigned long discardTime;
     int maxBufferSize;
+    OrientationMath::Precision precision;
 
     PoseData orientationData;
 
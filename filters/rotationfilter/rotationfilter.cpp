@@ -25,46 +25,61 @@
 */
 
 #include "rotationfilter.h"
+#include <QVarLengthArray>
 #include <math.h>
 
 RotationFilter::RotationFilter() :
         accelerometerDataSink_(this, &RotationFilter::interpret),
         compassDataSink_(this, &RotationFilter::updateZvalue),
-        rotation_(0,0,0,0)
+        rotation_(0,0,0,0),
+        precision_(OrientationMath::configuredPrecision())
 {
     addSink(&accelerometerDataSink_, "accelerometersink");
     addSink(&compassDataSink_, "compasssink");
     addSource(&source_, "source");
 }
 
-void RotationFilter::interpret(unsigned, const TimedXyzData* data)
+void RotationFilter::interpret(unsigned n, const TimedXyzData* samples)
 {
     const int RADIANS_TO_DEGREES = 180/M_PI;
-
-    rotation_.timestamp_ = data->timestamp_;
-
-    // X-Rotation
-    rotation_.x_ = round(atan((double)data->y_ / sqrt(data->x_ * data->x_ + data->z_ * data->z_)) * RADIANS_TO_DEGREES);
-    rotation_.x_ = -rotation_.x_;
-
-    // Y-rotation
-    if (data->x_ == 0 && data->y_ == 0 && data->z_ > 0) {
-        rotation_.y_ = 180;
-    } else if (data->x_ == 0 && data->z_  == 0) {
-        rotation_.y_ = 0;
-    } else {
-        rotation_.y_ = round(atan((double)data->x_ / sqrt(data->y_ * data->y_ + data->z_ * data->z_)) * RADIANS_TO_DEGREES);
-
-        qreal theta = atan(sqrt(data->x_ * data->x_ + data->y_ * data->y_) / data->z_) * RADIANS_TO_DEGREES;
-        if (theta > 0) {
-            if (rotation_.y_ >= 0)
-                rotation_.y_ = 180 - rotation_.y_;
+    QVarLengthArray<TimedXyzData, BATCH_SIZE> rotations(n);
+
+    for (unsigned i = 0; i < n; ++i) {
+        const TimedXyzData* data = &samples[i];
+
+        rotation_.timestamp_ = data->timestamp_;
+
+        // X-Rotation
+        rotation_.x_ = round(OrientationMath::elevation(data->y_, data->x_, data->z_, precision_) * RADIANS_TO_DEGREES);
+        rotation_.x_ = -rotation_.x_;
+
+        // Y-rotation
+        if (data->x_ == 0 && data->y_ == 0 && data->z_ > 0) {
+            rotation_.y_ = 180;
+        } else if (data->x_ == 0 && data->z_  == 0) {
+            rotation_.y_ = 0;
+        } else {
+            rotation_.y_ = round(OrientationMath::elevation(data->x_, data->y_, data->z_, precision_) * RADIANS_TO_DEGREES);
+
+            // Tilted past the horizon. The angle is positive exactly when
+            // z is, as x and z are not both zero here.
+            bool flipped;
+            if (precision_ == OrientationMath::Exact)
+                flipped = atan(sqrt(data->x_ * data->x_ + data->y_ * data->y_) / data->z_) > 0;
             else
-                rotation_.y_ = -180 - rotation_.y_;
+                flipped = data->z_ >= 0;
+            if (flipped) {
+                if (rotation_.y_ >= 0)
+                    rotation_.y_ = 180 - rotation_.y_;
+                else
+                    rotation_.y_ = -180 - rotation_.y_;
+            }
         }
+
+        rotations[i] = rotation_;
     }
 
-    source_.propagate(1, &rotation_);
+    source_.propagate(n, rotations.constData());
 }
 
 double RotationFilter::vectorLength(const TimedXyzData& data)
@@ -72,8 +87,13 @@ double RotationFilter::vectorLength(const TimedXyzData& data)
     return sqrt(data.x_ * data.x_ + data.y_ * data.y_ + data.z_ * data.z_);
 }
 
-void RotationFilter::updateZvalue(unsigned, const CompassData* data)
+void RotationFilter::updateZvalue(unsigned n, const CompassData* samples)
 {
+    // Only the latest heading is used.
+    if (!n)
+        return;
+    const CompassData* data = &samples[n - 1];
+
     rotation_.timestamp_ = data->timestamp_;
 
     /// Z-rotation
@@ -30,6 +30,7 @@
 
 #include "orientationdata.h"
 #include "filter.h"
+#include "orientationmath.h"
 
 /**
  * @brief Filter for calculating device axis rotations.
@@ -76,6 +77,7 @@ private:
     }
 
     TimedXyzData rotation_;
+    OrientationMath::Precision precision_;
 };
 
 #endif // ROTATIONFILTER_H
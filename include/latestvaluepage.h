@@ -0,0 +1,269 @@
+/**
+   @file latestvaluepage.h
+   @brief Shared memory latest value page layout
+
+   <p>
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef LATESTVALUEPAGE_H
+#define LATESTVALUEPAGE_H
+
+#include <QtGlobal>
+#include <string.h>
+
+/**
+ * File sensord maps the latest value page from. Clients map it read-only.
+ */
+#define LATEST_VALUE_PAGE_PATH "/var/run/sensord-latest"
+
+/**
+ * Magic number identifying a live latest value page. Cleared when
+ * sensord exits normally. A page left behind by a sensord which was
+ * killed still carries it, so clients also check that the process in
+ * LatestValueHeader::pid is alive and that the file has not been
+ * replaced.
+ */
+const quint32 LATEST_VALUE_PAGE_MAGIC = 0x5346574c;
+
+/**
+ * Number of channel slots in the page.
+ */
+const quint32 LATEST_VALUE_SLOTS = 32;
+
+/**
+ * Maximum length of a channel ID, including terminating zero.
+ */
+const quint32 LATEST_VALUE_NAME = 48;
+
+/**
+ * Maximum size of a sample in the page.
+ */
+const quint32 LATEST_VALUE_PAYLOAD = 112;
+
+/**
+ * Header at the beginning of the page.
+ */
+struct LatestValueHeader
+{
+    quint32 magic;     /**< LATEST_VALUE_PAGE_MAGIC while sensord runs */
+    quint32 slotCount; /**< number of slots following the header */
+    quint32 slotSize;  /**< size of a single slot in bytes */
+    quint32 pid;       /**< process ID of the sensord maintaining the page */
+};
+
+/**
+ * Latest sample of one channel, protected by a sequence lock: #seq is
+ * odd while the sample is being written and zero until the first one.
+ */
+struct LatestValueSlot
+{
+    quint32 used;                          /**< non-zero once name is set */
+    quint32 seq;                           /**< sequence lock */
+    quint32 size;                          /**< payload size */
+    quint32 reserved;                      /**< padding */
+    char    name[LATEST_VALUE_NAME];       /**< channel ID */
+    char    data[LATEST_VALUE_PAYLOAD];    /**< payload */
+};
+
+/**
+ * Size of the whole page in bytes.
+ *
+ * @return page size.
+ */
+inline size_t latestValuePageSize()
+{
+    return sizeof(LatestValueHeader) + LATEST_VALUE_SLOTS * sizeof(LatestValueSlot);
+}
+
+/**
+ * Writer side of the latest value page, used by sensord.
+ */
+class LatestValuePageWriter
+{
+public:
+    /**
+     * Constructor. Initializes the page.
+     *
+     * @param memory Writable mapping of #latestValuePageSize() bytes.
+     * @param pid Process ID of sensord.
+     */
+    LatestValuePageWriter(void* memory, quint32 pid) :
+        header_((LatestValueHeader*)memory),
+        slots_((LatestValueSlot*)(header_ + 1))
+    {
+        memset(memory, 0, latestValuePageSize());
+        header_->slotCount = LATEST_VALUE_SLOTS;
+        header_->slotSize = sizeof(LatestValueSlot);
+        header_->pid = pid;
+        __atomic_store_n(&header_->magic, LATEST_VALUE_PAGE_MAGIC, __ATOMIC_RELEASE);
+    }
+
+    /**
+     * Mark the page stale so that readers stop using it.
+     */
+    void close()
+    {
+        __atomic_store_n(&header_->magic, 0, __ATOMIC_RELEASE);
+    }
+
+    /**
+     * Find or allocate the slot of a channel. Not thread safe, channels
+     * are added from the main thread.
+     *
+     * @param name Channel ID.
+     * @return slot index, -1 if the page is full or name too long.
+     */
+    int addChannel(const char* name)
+    {
+        size_t length = strlen(name);
+        if (length >= LATEST_VALUE_NAME)
+            return -1;
+        for (quint32 i = 0; i < LATEST_VALUE_SLOTS; ++i) {
+            LatestValueSlot* slot = &slots_[i];
+            if (slot->used) {
+                if (!strcmp(slot->name, name))
+                    return i;
+                continue;
+            }
+            memcpy(slot->name, name, length + 1);
+            __atomic_store_n(&slot->used, 1, __ATOMIC_RELEASE);
+            return i;
+        }
+        return -1;
+    }
+
+    /**
+     * Publish latest sample of a channel. Concurrent writers of the
+     * same slot are serialized on the sequence lock.
+     *
+     * @param index Slot index.
+     * @param source Location from where to copy the sample.
+     * @param size Size of the sample.
+     * @return false if the sample does not fit into a slot.
+     */
+    bool write(int index, const void* source, quint32 size)
+    {
+        if (size > LATEST_VALUE_PAYLOAD)
+            return false;
+
+        LatestValueSlot* slot = &slots_[index];
+        quint32 seq = __atomic_load_n(&slot->seq, __ATOMIC_RELAXED);
+        while ((seq & 1) || !__atomic_compare_exchange_n(&slot->seq, &seq, seq + 1, true,
+                                                         __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+            seq = __atomic_load_n(&slot->seq, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        slot->size = size;
+        memcpy(slot->data, source, size);
+        __atomic_store_n(&slot->seq, seq + 2, __ATOMIC_RELEASE);
+        return true;
+    }
+
+private:
+    LatestValueHeader* header_; /**< page header */
+    LatestValueSlot*   slots_;  /**< slot array */
+};
+
+/**
+ * Reader side of the latest value page, used by clients.
+ */
+class LatestValuePageReader
+{
+public:
+    /**
+     * Constructor.
+     *
+     * @param memory Read-only mapping of #latestValuePageSize() bytes.
+     */
+    LatestValuePageReader(const void* memory) :
+        header_((const LatestValueHeader*)memory),
+        slots_((const LatestValueSlot*)(header_ + 1))
+    {
+    }
+
+    /**
+     * Is the page compatible and still maintained by sensord.
+     *
+     * @return is page valid.
+     */
+    bool isValid() const
+    {
+        return __atomic_load_n(&header_->magic, __ATOMIC_ACQUIRE) == LATEST_VALUE_PAGE_MAGIC &&
+               header_->slotCount == LATEST_VALUE_SLOTS &&
+               header_->slotSize == sizeof(LatestValueSlot);
+    }
+
+    /**
+     * Process ID of the sensord maintaining the page.
+     *
+     * @return process ID.
+     */
+    quint32 pid() const
+    {
+        return header_->pid;
+    }
+
+    /**
+     * Find slot of a channel.
+     *
+     * @param name Channel ID.
+     * @return slot index, -1 if channel has no slot yet.
+     */
+    int find(const char* name) const
+    {
+        for (quint32 i = 0; i < LATEST_VALUE_SLOTS; ++i) {
+            const LatestValueSlot* slot = &slots_[i];
+            if (!__atomic_load_n(&slot->used, __ATOMIC_ACQUIRE))
+                break;
+            if (!strncmp(slot->name, name, LATEST_VALUE_NAME))
+                return i;
+        }
+        return -1;
+    }
+
+    /**
+     * Copy latest sample of a channel.
+     *
+     * @param index Slot index.
+     * @param value Location to copy the sample to.
+     * @param size Expected size of the sample.
+     * @return false if no sample of the expected size is available.
+     */
+    bool read(int index, void* value, quint32 size) const
+    {
+        const LatestValueSlot* slot = &slots_[index];
+        for (int attempt = 0; attempt < 1000; ++attempt) {
+            quint32 seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+            if (!seq)
+                return false;
+            if (seq & 1)
+                continue;
+            if (slot->size != size)
+                return false;
+            memcpy(value, slot->data, size);
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            if (__atomic_load_n(&slot->seq, __ATOMIC_RELAXED) == seq)
+                return true;
+        }
+        return false;
+    }
+
+private:
+    const LatestValueHeader* header_; /**< page header */
+    const LatestValueSlot*   slots_;  /**< slot array */
+};
+
+#endif // LATESTVALUEPAGE_H
@@ -0,0 +1,231 @@
+/**
+   @file sharedsamplering.h
+   @brief Shared memory sample ring layout
+
+   <p>
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef SHAREDSAMPLERING_H
+#define SHAREDSAMPLERING_H
+
+#include <QtGlobal>
+#include <QVector>
+#include <string.h>
+
+/**
+ * Magic number identifying a shared sample ring mapping.
+ */
+const quint32 SHARED_SAMPLE_RING_MAGIC = 0x53465752;
+
+/**
+ * Number of slots in a shared sample ring. Must be a power of two.
+ */
+const quint32 SHARED_SAMPLE_RING_SLOTS = 256;
+
+/**
+ * Maximum size of a single sample in a shared sample ring.
+ */
+const quint32 SHARED_SAMPLE_RING_PAYLOAD = 112;
+
+/**
+ * Header at the beginning of the shared mapping.
+ */
+struct SharedSampleRingHeader
+{
+    quint32 magic;     /**< SHARED_SAMPLE_RING_MAGIC */
+    quint32 slotCount; /**< number of slots following the header */
+    quint32 slotSize;  /**< size of a single slot in bytes */
+    quint32 reserved;  /**< padding */
+    quint64 writeSeq;  /**< sequence number of the next sample to write */
+};
+
+/**
+ * Single sample slot. Slot is valid for sequence number #seq as long as
+ * the value does not change while the payload is being copied.
+ */
+struct SharedSampleSlot
+{
+    quint64 seq;                              /**< sequence number of the sample */
+    quint32 size;                             /**< payload size */
+    quint32 reserved;                         /**< padding */
+    char    data[SHARED_SAMPLE_RING_PAYLOAD]; /**< payload */
+};
+
+/**
+ * Size of the whole shared mapping in bytes.
+ *
+ * @return mapping size.
+ */
+inline size_t sharedSampleRingSize()
+{
+    return sizeof(SharedSampleRingHeader) + SHARED_SAMPLE_RING_SLOTS * sizeof(SharedSampleSlot);
+}
+
+/**
+ * Writer side of the shared sample ring. Used by sensord, one writer
+ * per sensor channel.
+ */
+class SharedSampleRingWriter
+{
+public:
+    /**
+     * Constructor. Initializes the mapping.
+     *
+     * @param memory Writable mapping of #sharedSampleRingSize() bytes.
+     */
+    SharedSampleRingWriter(void* memory) :
+        header_((SharedSampleRingHeader*)memory),
+        slots_((SharedSampleSlot*)(header_ + 1))
+    {
+        memset(memory, 0, sharedSampleRingSize());
+        for (quint32 i = 0; i < SHARED_SAMPLE_RING_SLOTS; ++i)
+            slots_[i].seq = ~0ULL;
+        header_->slotCount = SHARED_SAMPLE_RING_SLOTS;
+        header_->slotSize = sizeof(SharedSampleSlot);
+        header_->writeSeq = 0;
+        __atomic_store_n(&header_->magic, SHARED_SAMPLE_RING_MAGIC, __ATOMIC_RELEASE);
+    }
+
+    /**
+     * Publish sample to the ring.
+     *
+     * @param source Location from where to copy the sample.
+     * @param size Size of the sample.
+     * @return false if sample does not fit into a slot.
+     */
+    bool write(const void* source, quint32 size)
+    {
+        if (size > SHARED_SAMPLE_RING_PAYLOAD)
+            return false;
+
+        quint64 seq = header_->writeSeq;
+        SharedSampleSlot* slot = &slots_[seq & (SHARED_SAMPLE_RING_SLOTS - 1)];
+
+        // Invalidate slot before touching the payload so that readers
+        // still copying the previous lap notice the overwrite.
+        __atomic_store_n(&slot->seq, ~0ULL, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        slot->size = size;
+        memcpy(slot->data, source, size);
+        __atomic_store_n(&slot->seq, seq, __ATOMIC_RELEASE);
+        __atomic_store_n(&header_->writeSeq, seq + 1, __ATOMIC_RELEASE);
+        return true;
+    }
+
+private:
+    SharedSampleRingHeader* header_; /**< mapping header */
+    SharedSampleSlot*       slots_;  /**< slot array */
+};
+
+/**
+ * Reader side of the shared sample ring. Used by clients which map the
+ * ring read-only. Reader follows the write cursor and detects samples
+ * overwritten before they could be read.
+ */
+class SharedSampleRingReader
+{
+public:
+    /**
+     * Constructor.
+     *
+     * @param memory Read-only mapping of #sharedSampleRingSize() bytes.
+     */
+    SharedSampleRingReader(const void* memory) :
+        header_((const SharedSampleRingHeader*)memory),
+        slots_((const SharedSampleSlot*)(header_ + 1)),
+        readSeq_(0),
+        lost_(0)
+    {
+        if (isValid())
+            readSeq_ = __atomic_load_n(&header_->writeSeq, __ATOMIC_ACQUIRE);
+    }
+
+    /**
+     * Does the mapping contain a compatible ring.
+     *
+     * @return is mapping valid.
+     */
+    bool isValid() const
+    {
+        return __atomic_load_n(&header_->magic, __ATOMIC_ACQUIRE) == SHARED_SAMPLE_RING_MAGIC &&
+               header_->slotCount == SHARED_SAMPLE_RING_SLOTS &&
+               header_->slotSize == sizeof(SharedSampleSlot);
+    }
+
+    /**
+     * Are there unread samples in the ring.
+     *
+     * @return are samples available.
+     */
+    bool hasData() const
+    {
+        return __atomic_load_n(&header_->writeSeq, __ATOMIC_ACQUIRE) != readSeq_;
+    }
+
+    /**
+     * Number of samples overwritten before this reader got to them.
+     *
+     * @return lost sample count.
+     */
+    quint64 lost() const
+    {
+        return lost_;
+    }
+
+    /**
+     * Append all unread samples to given vector.
+     *
+     * @tparam T Sample type.
+     * @param values Vector to append to.
+     * @return true if at least one sample was read.
+     */
+    template<typename T>
+    bool read(QVector<T>& values)
+    {
+        quint64 writeSeq = __atomic_load_n(&header_->writeSeq, __ATOMIC_ACQUIRE);
+        if (writeSeq - readSeq_ > SHARED_SAMPLE_RING_SLOTS) {
+            lost_ += writeSeq - SHARED_SAMPLE_RING_SLOTS - readSeq_;
+            readSeq_ = writeSeq - SHARED_SAMPLE_RING_SLOTS;
+        }
+
+        int oldSize = values.size();
+        for (; readSeq_ != writeSeq; ++readSeq_) {
+            const SharedSampleSlot* slot = &slots_[readSeq_ & (SHARED_SAMPLE_RING_SLOTS - 1)];
+            if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != readSeq_ || slot->size != sizeof(T)) {
+                ++lost_;
+                continue;
+            }
+            T value;
+            memcpy(&value, slot->data, sizeof(T));
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            if (__atomic_load_n(&slot->seq, __ATOMIC_RELAXED) != readSeq_) {
+                ++lost_;
+                continue;
+            }
+            values.append(value);
+        }
+        return values.size() > oldSize;
+    }
+
+private:
+    const SharedSampleRingHeader* header_;  /**< mapping header */
+    const SharedSampleSlot*       slots_;   /**< slot array */
+    quint64                       readSeq_; /**< next sequence number to read */
+    quint64                       lost_;    /**< overwritten sample count */
+};
+
+#endif // SHAREDSAMPLERING_H
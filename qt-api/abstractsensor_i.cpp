@@ -28,10 +28,139 @@
 
 #include "sensormanagerinterface.h"
 #include "abstractsensor_i.h"
+#include "latestvaluepage.h"
 #ifdef SENSORFW_MCE_WATCHER
 #include "mcewatcher.h"
 #endif
 
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <signal.h>
+#include <errno.h>
+#include <time.h>
+
+namespace {
+
+/**
+ * How often the latest value page is checked for having been left
+ * behind by a sensord which died or was restarted, in milliseconds.
+ */
+const qint64 LATEST_VALUE_CHECK_MS = 250;
+
+/**
+ * Process wide read-only mapping of the latest value page. The page is
+ * mapped again when sensord has restarted and replaced it, and dropped
+ * when the sensord which created it is gone.
+ */
+class LatestValueMapping
+{
+public:
+    LatestValueMapping() :
+        memory_(MAP_FAILED), reader_(NULL), generation_(0), device_(0), inode_(0), nextCheck_(0) {}
+
+    ~LatestValueMapping()
+    {
+        unmap();
+    }
+
+    bool read(const QByteArray& name, int& slot, unsigned int& generation, void* value, int size)
+    {
+        QMutexLocker locker(&mutex_);
+        if (reader_ && (!reader_->isValid() || isStale()))
+            unmap();
+        if (!reader_ && !map())
+            return false;
+        if (generation != generation_ || slot < 0) {
+            slot = reader_->find(name.constData());
+            generation = generation_;
+        }
+        return slot >= 0 && reader_->read(slot, value, size);
+    }
+
+private:
+    static qint64 monotonicMs()
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+        return (qint64)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+    }
+
+    static bool isAlive(quint32 pid)
+    {
+        return pid && (kill(pid, 0) == 0 || errno != ESRCH);
+    }
+
+    /**
+     * Has the page been replaced by a restarted sensord, or has the
+     * sensord maintaining it died without clearing it. Checked at most
+     * every LATEST_VALUE_CHECK_MS.
+     */
+    bool isStale()
+    {
+        qint64 now = monotonicMs();
+        if (now < nextCheck_)
+            return false;
+        nextCheck_ = now + LATEST_VALUE_CHECK_MS;
+        struct stat st;
+        if (stat(LATEST_VALUE_PAGE_PATH, &st) == -1 || st.st_dev != device_ || st.st_ino != inode_)
+            return true;
+        return !isAlive(reader_->pid());
+    }
+
+    bool map()
+    {
+        int fd = open(LATEST_VALUE_PAGE_PATH, O_RDONLY | O_CLOEXEC);
+        if (fd == -1)
+            return false;
+        struct stat st;
+        if (fstat(fd, &st) == -1 || (size_t)st.st_size < latestValuePageSize()) {
+            close(fd);
+            return false;
+        }
+        memory_ = mmap(NULL, latestValuePageSize(), PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (memory_ == MAP_FAILED)
+            return false;
+        reader_ = new LatestValuePageReader(memory_);
+        if (!reader_->isValid() || !isAlive(reader_->pid())) {
+            unmap();
+            return false;
+        }
+        device_ = st.st_dev;
+        inode_ = st.st_ino;
+        nextCheck_ = monotonicMs() + LATEST_VALUE_CHECK_MS;
+        ++generation_;
+        return true;
+    }
+
+    void unmap()
+    {
+        delete reader_;
+        reader_ = NULL;
+        if (memory_ != MAP_FAILED)
+            munmap(memory_, latestValuePageSize());
+        memory_ = MAP_FAILED;
+    }
+
+    QMutex                 mutex_;
+    void*                  memory_;
+    LatestValuePageReader* reader_;
+    unsigned int           generation_;
+    dev_t                  device_;
+    ino_t                  inode_;
+    qint64                 nextCheck_;
+};
+
+LatestValueMapping& latestValueMapping()
+{
+    static LatestValueMapping mapping;
+    return mapping;
+}
+
+}
+
 struct AbstractSensorChannelInterface::AbstractSensorChannelInterfaceImpl : public QDBusAbstractInterface
 {
     AbstractSensorChannelInterfaceImpl(QObject* parent, int sessionId, const QString& path, const char* interfaceName);
@@ -51,6 +180,10 @@ struct AbstractSensorChannelInterface::AbstractSensorChannelInterfaceImpl : publ
     bool running_;
     bool standbyOverride_;
     bool downsampling_;
+    bool sharedTransport_;
+    QByteArray latestName_;
+    int latestSlot_;
+    unsigned int latestGeneration_;
 };
 
 AbstractSensorChannelInterface::AbstractSensorChannelInterfaceImpl::AbstractSensorChannelInterfaceImpl(QObject* parent, int sessionId, const QString& path, const char* interfaceName) :
@@ -64,8 +197,14 @@ AbstractSensorChannelInterface::AbstractSensorChannelInterfaceImpl::AbstractSens
     socketReader_(parent),
     running_(false),
     standbyOverride_(false),
-    downsampling_(true)
+    downsampling_(true),
+    sharedTransport_(false),
+    latestName_(path.section('/', -1).toLatin1()),
+    latestSlot_(-1),
+    latestGeneration_(0)
 {
+    QByteArray shared(qgetenv("SENSORFW_SHARED_TRANSPORT"));
+    sharedTransport_ = !shared.isEmpty() && shared != "0";
 }
 
 AbstractSensorChannelInterface::AbstractSensorChannelInterface(const QString& path, const char* interfaceName, int sessionId) :
@@ -96,6 +235,12 @@ SocketReader& AbstractSensorChannelInterface::getSocketReader() const
     return pimpl_->socketReader_;
 }
 
+bool AbstractSensorChannelInterface::readLatestValue(void* value, int size)
+{
+    return latestValueMapping().read(pimpl_->latestName_, pimpl_->latestSlot_,
+                                     pimpl_->latestGeneration_, value, size);
+}
+
 bool AbstractSensorChannelInterface::release()
 {
     return true;
@@ -126,33 +271,51 @@ QDBusReply<void> AbstractSensorChannelInterface::start(int sessionId)
     }
     pimpl_->running_ = true;
 
-    connect(pimpl_->socketReader_.socket(), SIGNAL(readyRead()), this, SLOT(dataReceived()));
-
-    QList<QVariant> argumentList;
-    argumentList << qVariantFromValue(sessionId);
+    // Shared memory transport carries the full channel output, so it is
+    // used only when the session does not need socket side buffering.
+    if (pimpl_->sharedTransport_ && pimpl_->bufferSize_ <= 1 && pimpl_->bufferInterval_ == 0 &&
+        (pimpl_->connection().connectionCapabilities() & QDBusConnection::UnixFileDescriptorPassing)) {
+        QDBusPendingReply<QDBusUnixFileDescriptor, QDBusUnixFileDescriptor> reply =
+            pimpl_->call(QDBus::Block, QLatin1String("requestSharedTransport"), qVariantFromValue(sessionId));
+        if (reply.isValid() && reply.argumentAt<0>().isValid() && reply.argumentAt<1>().isValid() &&
+            !pimpl_->socketReader_.attachSharedRing(reply.argumentAt<0>().fileDescriptor(),
+                                                    reply.argumentAt<1>().fileDescriptor()))
+            setError(SClientSocketError, "Shared memory transport setup failed.");
+    }
 
-    QDBusPendingReply <void> returnValue = pimpl_->asyncCallWithArgumentList(QLatin1String("start"), argumentList);
+    if (pimpl_->socketReader_.isShared())
+        connect(&pimpl_->socketReader_, SIGNAL(sharedDataAvailable()), this, SLOT(dataReceived()));
+    else
+        connect(pimpl_->socketReader_.socket(), SIGNAL(readyRead()), this, SLOT(dataReceived()));
+
+    // Settings and start travel in one call, so the session starts
+    // with its final configuration.
+    SessionConfig config;
+    config.sessionId = sessionId;
+    config.interval = pimpl_->interval_;
+    config.bufferInterval = pimpl_->bufferInterval_;
+    config.bufferSize = pimpl_->bufferSize_;
+    config.standbyOverride = pimpl_->standbyOverride_;
+    config.downsampling = pimpl_->downsampling_;
+
+    QDBusPendingReply <int> returnValue = SensorManagerInterface::instance().openAndStart(pimpl_->path().section('/', -1), config);
     QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(returnValue, this);
     connect(watcher, SIGNAL(finished(QDBusPendingCallWatcher*)),
             SLOT(startFinished(QDBusPendingCallWatcher*)));
 
-    setStandbyOverride(sessionId, pimpl_->standbyOverride_);
-    setInterval(sessionId, pimpl_->interval_);
-    setBufferInterval(sessionId, pimpl_->bufferInterval_);
-    setBufferSize(sessionId, pimpl_->bufferSize_);
-    setDownsampling(pimpl_->sessionId_, pimpl_->downsampling_);
-
     return returnValue;
 }
 
 void AbstractSensorChannelInterface::startFinished(QDBusPendingCallWatcher *watch)
 {
     watch->deleteLater();
-    QDBusPendingReply<void> reply = *watch;
+    QDBusPendingReply<int> reply = *watch;
 
     if(reply.isError()) {
         qDebug() << reply.error().message();
         setError(SHwSensorStartFailed, reply.error().message());
+    } else if(reply.value() < 0) {
+        setError(SHwSensorStartFailed, "Sensor session could not be started.");
     }
  }
 
@@ -165,6 +328,8 @@ QDBusReply<void> AbstractSensorChannelInterface::stop(int sessionId)
     pimpl_->running_ = false ;
 
     disconnect(pimpl_->socketReader_.socket(), SIGNAL(readyRead()), this, SLOT(dataReceived()));
+    disconnect(&pimpl_->socketReader_, SIGNAL(sharedDataAvailable()), this, SLOT(dataReceived()));
+    pimpl_->socketReader_.detachSharedRing();
 
     QList<QVariant> argumentList;
     argumentList << qVariantFromValue(sessionId);
@@ -327,6 +492,17 @@ bool AbstractSensorChannelInterface::hwBuffering()
     return getAccessor<bool>("hwBuffering");
 }
 
+quint64 AbstractSensorChannelInterface::droppedSamples()
+{
+    QDBusReply<quint64> reply(call(QDBus::Block, QLatin1String("droppedSamples"), qVariantFromValue(pimpl_->sessionId_)));
+    if(!reply.isValid())
+    {
+        qDebug() << "Failed to get 'droppedSamples' from sensord: " << reply.error().message();
+        return 0;
+    }
+    return reply.value();
+}
+
 int AbstractSensorChannelInterface::sessionId() const
 {
     return pimpl_->sessionId_;
@@ -429,7 +605,7 @@ void AbstractSensorChannelInterface::dataReceived()
     {
         if(!dataReceivedImpl())
             return;
-    } while(pimpl_->socketReader_.socket()->bytesAvailable());
+    } while(pimpl_->socketReader_.hasPendingData());
 }
 
 bool AbstractSensorChannelInterface::read(void* buffer, int size)
@@ -225,6 +225,11 @@ public:
      * Start sensor. This will cause necessary resources to be
      * acquired so the sensor readings can be received.
      *
+     * If \c SENSORFW_SHARED_TRANSPORT environment variable is set and
+     * no buffering is requested, samples are read from a shared memory
+     * ring instead of the socket. Shared transport delivers every
+     * sample the sensor channel produces.
+     *
      * @return object from which the success of call can be seen.
      */
     virtual QDBusReply<void> start();
@@ -286,6 +291,14 @@ public:
      */
     bool hwBuffering();
 
+    /**
+     * Number of samples the daemon dropped for this session because
+     * they were not read from the socket in time.
+     *
+     * @return dropped samples.
+     */
+    quint64 droppedSamples();
+
     /**
      * Does the current instance have valid connection established
      * to sensor daemon.
@@ -313,6 +326,15 @@ private:
      */
     SocketReader& getSocketReader() const;
 
+    /**
+     * Copy latest sample of the sensor from the latest value page.
+     *
+     * @param value Location to copy the sample to.
+     * @param size Size of the sample.
+     * @return was a sample available.
+     */
+    bool readLatestValue(void* value, int size);
+
 private Q_SLOTS: // METHODS
 
     void displayStateChanged(bool displayState);
@@ -411,6 +433,18 @@ protected:
     template<typename T>
     bool read(QVector<T>& values);
 
+    /**
+     * Read latest sample published by sensord without calling it over
+     * DBus. Fails if sensord does not provide the latest value page or
+     * the sensor has not produced any data yet.
+     *
+     * @tparam Type of the sample in the data stream.
+     * @param value Location for the sample.
+     * @return was a sample available.
+     */
+    template<typename T>
+    bool latestValue(T& value);
+
     /**
      * Callback for subclasses in which they must read their expected data
      * from socket.
@@ -495,6 +529,12 @@ bool AbstractSensorChannelInterface::read(QVector<T>& values)
     return getSocketReader().read(values);
 }
 
+template<typename T>
+bool AbstractSensorChannelInterface::latestValue(T& value)
+{
+    return readLatestValue(&value, sizeof(T));
+}
+
 template<typename T>
 T AbstractSensorChannelInterface::getAccessor(const char* name)
 {
@@ -83,6 +83,9 @@ bool AccelerometerSensorChannelInterface::dataReceivedImpl()
 
 XYZ AccelerometerSensorChannelInterface::get()
 {
+    AccelerationData data;
+    if (latestValue(data))
+        return XYZ(data);
     return getAccessor<XYZ>("xyz");
 }
 
@@ -74,5 +74,8 @@ bool ALSSensorChannelInterface::dataReceivedImpl()
 
 Unsigned ALSSensorChannelInterface::lux()
 {
+    TimedUnsigned data;
+    if (latestValue(data))
+        return Unsigned(data);
     return getAccessor<Unsigned>("lux");
 }
@@ -72,6 +72,9 @@ bool CompassSensorChannelInterface::dataReceivedImpl()
 
 Compass CompassSensorChannelInterface::get()
 {
+    CompassData data;
+    if (latestValue(data))
+        return Compass(data, useDeclination_);
     return Compass(getAccessor<Compass>("value").data(), useDeclination_);
 }
 
@@ -104,5 +104,8 @@ void GyroscopeSensorChannelInterface::connectNotify(const QMetaMethod &signal)
 
 XYZ GyroscopeSensorChannelInterface::get()
 {
+    TimedXyzData data;
+    if (latestValue(data))
+        return XYZ(data);
     return getAccessor<XYZ>("value");
 }
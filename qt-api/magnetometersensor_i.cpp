@@ -106,5 +106,8 @@ QDBusReply<void> MagnetometerSensorChannelInterface::reset()
 
 MagneticField MagnetometerSensorChannelInterface::magneticField()
 {
+    CalibratedMagneticFieldData data;
+    if (latestValue(data))
+        return MagneticField(data);
     return getAccessor<MagneticField>("magneticField");
 }
@@ -72,6 +72,9 @@ bool OrientationSensorChannelInterface::dataReceivedImpl()
 
 Unsigned OrientationSensorChannelInterface::orientation()
 {
+    TimedUnsigned data;
+    if (latestValue(data))
+        return Unsigned(data);
     return getAccessor<Unsigned>("orientation");
 }
 
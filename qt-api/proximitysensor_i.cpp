@@ -77,10 +77,16 @@ bool ProximitySensorChannelInterface::dataReceivedImpl()
 
 Unsigned ProximitySensorChannelInterface::proximity()
 {
+    ProximityData data;
+    if (latestValue(data))
+        return Unsigned(data);
     return getAccessor<Unsigned>("proximity");
 }
 
 Proximity ProximitySensorChannelInterface::proximityReflectance()
 {
+    ProximityData data;
+    if (latestValue(data))
+        return Proximity(data);
     return getAccessor<Proximity>("proximityReflectance");
 }
@@ -84,6 +84,9 @@ bool RotationSensorChannelInterface::dataReceivedImpl()
 
 XYZ RotationSensorChannelInterface::rotation()
 {
+    TimedXyzData data;
+    if (latestValue(data))
+        return XYZ(data);
     return getAccessor<XYZ>("rotation");
 }
 
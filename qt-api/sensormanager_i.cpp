@@ -120,6 +120,14 @@ void LocalSensorManagerInterface::requestSensorFinished(QDBusPendingCallWatcher
     Q_EMIT requestSensorFinished();
 }
 
+QDBusPendingReply<int> LocalSensorManagerInterface::openAndStart(const QString& id, const SessionConfig& config)
+{
+    qint64 pid = QCoreApplication::applicationPid();
+    QList<QVariant> argumentList;
+    argumentList << qVariantFromValue(id) << qVariantFromValue(pid) << qVariantFromValue(config);
+    return asyncCallWithArgumentList(QLatin1String("openAndStart"), argumentList);
+}
+
 QDBusReply<bool> LocalSensorManagerInterface::releaseSensor(const QString& id, int sessionId)
 {
     qint64 pid = QCoreApplication::applicationPid();
@@ -33,6 +33,7 @@
 #include <QtDBus/QtDBus>
 #include <QString>
 #include "sfwerror.h"
+#include "datatypes/sessionconfig.h"
 
 /**
  * DBus interface to SensorManager instance.
@@ -97,6 +98,17 @@ public Q_SLOTS:
      */
     QDBusReply<int> requestSensor(const QString& id);
 
+    /**
+     * Request sensor daemon to apply session settings and start the
+     * session with a single call. A new session is opened if
+     * config.sessionId is negative.
+     *
+     * @param id sensor ID.
+     * @param config session settings.
+     * @return DBus reply carrying the session ID.
+     */
+    QDBusPendingReply<int> openAndStart(const QString& id, const SessionConfig& config);
+
     /**
      * Request sensor deamon to release existing session.
      *
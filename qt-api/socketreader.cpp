@@ -25,14 +25,23 @@
  */
 
 #include "socketreader.h"
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <string.h>
 
 const char* SocketReader::channelIDString = "_SENSORCHANNEL_";
 
 SocketReader::SocketReader(QObject* parent) :
     QObject(parent),
     socket_(NULL),
-    tagRead_(false)
+    tagRead_(false),
+    bufferOffset_(0),
+    sharedMemory_(MAP_FAILED),
+    sharedReader_(NULL),
+    sharedEventFd_(-1),
+    sharedNotifier_(NULL)
 {
+    buffer_.reserve(4096);
 }
 
 SocketReader::~SocketReader()
@@ -50,6 +59,7 @@ bool SocketReader::initiateConnection(int sessionId)
     }
 
     socket_ = new QLocalSocket(this);
+    socket_->setReadBufferSize(MAX_BUFFERED_BYTES);
     socket_->connectToServer("/var/run/sensord.sock", QIODevice::ReadWrite);
 
     if (!(socket_->serverName().size())) {
@@ -71,6 +81,7 @@ bool SocketReader::dropConnection()
     if (!socket_)
         return false;
 
+    detachSharedRing();
     socket_->disconnectFromServer();
     if(socket_->state() != QLocalSocket::UnconnectedState)
         socket_->waitForDisconnected();
@@ -78,6 +89,8 @@ bool SocketReader::dropConnection()
     socket_ = NULL;
 
     tagRead_ = false;
+    buffer_.resize(0);
+    bufferOffset_ = 0;
 
     return true;
 }
@@ -89,38 +102,137 @@ QLocalSocket* SocketReader::socket()
 
 bool SocketReader::readSocketTag()
 {
-    char foo;
-    socket_->waitForReadyRead();
-    tagRead_ = read(&foo, 1);
-    return true;
+    // Tag is skipped by fillBuffer() once it arrives, no need to wait.
+    fillBuffer();
+    return tagRead_;
 }
 
 bool SocketReader::read(void* buffer, int size)
 {
-    int bytesRead = 0;
-    int retry = 100;
-    while(bytesRead < size)
-    {
-        int bytes = socket_->read((char *)buffer + bytesRead, size);
-        if(bytes == 0)
-        {
-            if(!retry)
-                return false;
-            struct timespec ts;
-            ts.tv_sec = 0;
-            ts.tv_nsec = 100000000;
-            nanosleep( &ts, NULL );
-            --retry;
-            continue;
-        }
-        if(bytes < 1)
-            return false;
-        bytesRead += bytes;
+    if (!socket_)
+        return false;
+
+    fillBuffer();
+    if (buffered() < size)
+        return false;
+    memcpy(buffer, buffer_.constData() + bufferOffset_, size);
+    consume(size);
+    return true;
+}
+
+void SocketReader::fillBuffer()
+{
+    qint64 room = MAX_BUFFERED_BYTES - buffered();
+    qint64 available = qMin(socket_->bytesAvailable(), room);
+    if (available <= 0)
+        return;
+
+    if (bufferOffset_) {
+        buffer_.remove(0, bufferOffset_);
+        bufferOffset_ = 0;
+    }
+    int oldSize = buffer_.size();
+    buffer_.resize(oldSize + available);
+    qint64 bytes = socket_->read(buffer_.data() + oldSize, available);
+    buffer_.resize(oldSize + qMax(bytes, (qint64)0));
+
+    if (!tagRead_ && buffered() > 0) {
+        consume(1);
+        tagRead_ = true;
+    }
+}
+
+int SocketReader::buffered() const
+{
+    return buffer_.size() - bufferOffset_;
+}
+
+void SocketReader::consume(int size)
+{
+    bufferOffset_ += size;
+    if (bufferOffset_ == buffer_.size()) {
+        buffer_.resize(0);
+        bufferOffset_ = 0;
     }
-    return (bytesRead > 0);
+}
+
+void SocketReader::resetBuffer()
+{
+    buffer_.resize(0);
+    bufferOffset_ = 0;
+    socket_->readAll();
 }
 
 bool SocketReader::isConnected()
 {
     return (socket_ && socket_->isValid() && socket_->state() == QLocalSocket::ConnectedState);
 }
+
+bool SocketReader::attachSharedRing(int ringFd, int notifyFd)
+{
+    if (sharedReader_)
+        return true;
+
+    sharedMemory_ = mmap(NULL, sharedSampleRingSize(), PROT_READ, MAP_SHARED, ringFd, 0);
+    if (sharedMemory_ == MAP_FAILED) {
+        qWarning() << "[SOCKETREADER]: Failed to map shared sample ring: " << strerror(errno);
+        return false;
+    }
+
+    sharedReader_ = new SharedSampleRingReader(sharedMemory_);
+    if (!sharedReader_->isValid()) {
+        qWarning() << "[SOCKETREADER]: Incompatible shared sample ring";
+        detachSharedRing();
+        return false;
+    }
+
+    // The eventfd belongs to this session only and is nonblocking.
+    sharedEventFd_ = fcntl(notifyFd, F_DUPFD_CLOEXEC, 0);
+    if (sharedEventFd_ == -1) {
+        qWarning() << "[SOCKETREADER]: Failed to watch shared sample eventfd: " << strerror(errno);
+        detachSharedRing();
+        return false;
+    }
+
+    sharedNotifier_ = new QSocketNotifier(sharedEventFd_, QSocketNotifier::Read, this);
+    connect(sharedNotifier_, SIGNAL(activated(int)), this, SLOT(sharedEventReceived()));
+    return true;
+}
+
+void SocketReader::detachSharedRing()
+{
+    delete sharedNotifier_;
+    sharedNotifier_ = NULL;
+    delete sharedReader_;
+    sharedReader_ = NULL;
+    if (sharedMemory_ != MAP_FAILED) {
+        munmap(sharedMemory_, sharedSampleRingSize());
+        sharedMemory_ = MAP_FAILED;
+    }
+    if (sharedEventFd_ != -1) {
+        close(sharedEventFd_);
+        sharedEventFd_ = -1;
+    }
+}
+
+bool SocketReader::isShared() const
+{
+    return sharedReader_ != NULL;
+}
+
+bool SocketReader::hasPendingData() const
+{
+    if (sharedReader_)
+        return sharedReader_->hasData();
+    return buffered() > 0 || (socket_ && socket_->bytesAvailable());
+}
+
+void SocketReader::sharedEventReceived()
+{
+    // Reset the counter before the ring is read, so that a sample
+    // published meanwhile activates the notifier again.
+    quint64 value;
+    while (::read(sharedEventFd_, &value, sizeof(value)) == -1 && errno == EINTR)
+        ;
+    emit sharedDataAvailable();
+}
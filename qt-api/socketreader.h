@@ -30,6 +30,14 @@
 #include <QObject>
 #include <QLocalSocket>
 #include <QVector>
+#include <QByteArray>
+#include <QtDebug>
+#include <QSocketNotifier>
+#include <errno.h>
+#include <unistd.h>
+#include <string.h>
+
+#include "sharedsamplering.h"
 
 /**
  * @brief Helper class for reading socket datachannel from sensord
@@ -80,10 +88,9 @@ public:
     QLocalSocket* socket();
 
     /**
-     * Attempt to read given number of bytes from the socket. As
-     * QLocalSocket is used, we are guaranteed that any number of bytes
-     * written in single operation are available for immediate reading
-     * with a single operation.
+     * Read given number of bytes from the received data. Never blocks:
+     * if fewer bytes have arrived so far, nothing is consumed and the
+     * call can be repeated on next readyRead().
      *
      * @param size Number of bytes to read.
      * @param buffer Location for storing the data.
@@ -92,12 +99,13 @@ public:
     bool read(void* buffer, int size);
 
     /**
-     * Attempt to read objects from the sockets. The call blocks until
-     * there are minimum amount of expected bytes availabled in the socket.
+     * Read next complete <tt>[count][T * count]</tt> frame from the
+     * received data. Never blocks: partial frames are kept in the
+     * reassembly buffer until the rest arrives.
      *
      * @param values Vector to which objects will be appended.
      * @tparam T type of expected object in the stream.
-     * @return true if atleast one object was read.
+     * @return true if a complete frame was read.
      */
     template<typename T>
     bool read(QVector<T>& values);
@@ -109,6 +117,50 @@ public:
      */
     bool isConnected();
 
+    /**
+     * Map shared sample ring sensord returned from the
+     * requestSharedTransport call and switch reading to shared memory.
+     * Descriptors are duplicated, the caller keeps ownership.
+     *
+     * @param ringFd Sealed descriptor of the shared ring.
+     * @param notifyFd Eventfd of the session sensord signals for new
+     *                 samples.
+     * @return was shared memory transport taken into use.
+     */
+    bool attachSharedRing(int ringFd, int notifyFd);
+
+    /**
+     * Stop using shared memory transport and release its resources.
+     */
+    void detachSharedRing();
+
+    /**
+     * Is shared memory transport in use.
+     *
+     * @return is shared transport in use.
+     */
+    bool isShared() const;
+
+    /**
+     * Is there unread data available.
+     *
+     * @return is data available.
+     */
+    bool hasPendingData() const;
+
+Q_SIGNALS:
+    /**
+     * Emitted when sensord has published new samples into the shared
+     * sample ring.
+     */
+    void sharedDataAvailable();
+
+private Q_SLOTS:
+    /**
+     * Wakeup descriptor was signalled.
+     */
+    void sharedEventReceived();
+
 private:
     /**
      * Prefix text needed to be written to the sensor daemon socket connection
@@ -117,40 +169,87 @@ private:
     static const char* channelIDString;
 
     /**
-     * Reads initial magic byte from the fresh connection.
+     * Upper bound for received but unparsed data, and thus for a
+     * single frame. QLocalSocket read buffer is capped to the same size
+     * so that a slow client leaves data in the kernel socket buffer
+     * instead of growing without bounds.
+     */
+    static const int MAX_BUFFERED_BYTES = 262144;
+
+    /**
+     * Skip initial magic byte of the fresh connection if it has arrived.
+     * Never blocks, a later #fillBuffer() skips it otherwise.
+     *
+     * @return was the tag skipped.
      */
     bool readSocketTag();
 
+    /**
+     * Move available socket data into the reassembly buffer, as much
+     * as fits under #MAX_BUFFERED_BYTES.
+     */
+    void fillBuffer();
+
+    /**
+     * Number of unparsed bytes in the reassembly buffer.
+     *
+     * @return buffered byte count.
+     */
+    int buffered() const;
+
+    /**
+     * Drop given number of parsed bytes from the reassembly buffer.
+     *
+     * @param size Number of bytes.
+     */
+    void consume(int size);
+
+    /**
+     * Discard all buffered and pending data after a framing error.
+     */
+    void resetBuffer();
+
     QLocalSocket* socket_; /**< socket data connection to sensord */
     bool tagRead_; /**< is initial magic byte read from the socket */
+    QByteArray buffer_; /**< reassembly buffer for partially received frames */
+    int bufferOffset_; /**< offset of first unparsed byte in buffer_ */
+    void* sharedMemory_; /**< read-only mapping of shared sample ring */
+    SharedSampleRingReader* sharedReader_; /**< reader for shared sample ring */
+    int sharedEventFd_; /**< eventfd of this session sensord signals new samples through */
+    QSocketNotifier* sharedNotifier_; /**< notifier for sharedEventFd_ */
 };
 
 template<typename T>
 bool SocketReader::read(QVector<T>& values)
 {
+    if (sharedReader_)
+        return sharedReader_->read(values);
+
     if (!socket_) {
         return false;
     }
 
+    fillBuffer();
+
     unsigned int count;
-    if(!read((void*)&count, sizeof(unsigned int)))
-    {
-        socket_->readAll();
+    if (buffered() < (int)sizeof(count))
         return false;
-    }
-    if(count > 1000)
+    memcpy(&count, buffer_.constData() + bufferOffset_, sizeof(count));
+
+    qint64 frameSize = sizeof(count) + (qint64)count * sizeof(T);
+    if (frameSize > MAX_BUFFERED_BYTES)
     {
-        qWarning() << "Too many samples waiting in socket. Flushing it to empty";
-        socket_->readAll();
+        qWarning() << "Invalid frame of" << count << "samples in socket. Flushing it to empty";
+        resetBuffer();
         return false;
     }
-    values.resize(values.size() + count);
-    if(!read((void*)values.data(), sizeof(T) * count))
-    {
-        qWarning() << "Error occured while reading data from socket: " << socket_->errorString();
-        socket_->readAll();
+    if (buffered() < frameSize)
         return false;
-    }
+
+    int oldSize = values.size();
+    values.resize(oldSize + count);
+    memcpy((void*)(values.data() + oldSize), buffer_.constData() + bufferOffset_ + sizeof(count), sizeof(T) * count);
+    consume(frameSize);
     return true;
 }
 
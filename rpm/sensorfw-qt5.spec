@@ -162,6 +162,7 @@ systemctl daemon-reload || :
 %attr(755,root,root)%{_bindir}/sensorapi-test
 %attr(755,root,root)%{_bindir}/sensorbenchmark-test
 %attr(755,root,root)%{_bindir}/sensorchains-test
+%attr(755,root,root)%{_bindir}/sensorcorebenchmark-test
 %attr(755,root,root)%{_bindir}/sensordataflow-test
 %attr(755,root,root)%{_bindir}/sensord-deadclient
 %attr(755,root,root)%{_bindir}/sensordiverter.sh
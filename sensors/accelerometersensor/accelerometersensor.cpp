@@ -45,9 +45,9 @@ AccelerometerSensorChannel::AccelerometerSensorChannel(const QString& id) :
     }
     setValid(accelerometerChain_->isValid());
 
-    accelerometerReader_ = new BufferReader<AccelerationData>(1);
+    accelerometerReader_ = new BufferReader<AccelerationData>(16);
 
-    outputBuffer_ = new RingBuffer<AccelerationData>(1);
+    outputBuffer_ = new RingBuffer<AccelerationData>(16);
 
     // Create buffers for filter chain
     filterBin_ = new Bin;
@@ -63,7 +63,7 @@ AccelerometerSensorChannel::AccelerometerSensorChannel(const QString& id) :
     marshallingBin_ = new Bin;
     marshallingBin_->add(this, "sensorchannel");
 
-    outputBuffer_->join(this);
+    connectToBuffer(outputBuffer_, this);
 
     // Set MetaData
     setDescription("x, y, and z axes accelerations in mG");
@@ -52,9 +52,9 @@ ALSSensorChannel::ALSSensorChannel(const QString& id) :
         return;
     }
 
-    alsReader_ = new BufferReader<TimedUnsigned>(1);
+    alsReader_ = new BufferReader<TimedUnsigned>(16);
 
-    outputBuffer_ = new RingBuffer<TimedUnsigned>(1);
+    outputBuffer_ = new RingBuffer<TimedUnsigned>(16);
 
     // Create buffers for filter chain
     filterBin_ = new Bin;
@@ -70,7 +70,7 @@ ALSSensorChannel::ALSSensorChannel(const QString& id) :
     marshallingBin_ = new Bin;
     marshallingBin_->add(this, "sensorchannel");
 
-    outputBuffer_->join(this);
+    connectToBuffer(outputBuffer_, this);
 
 #ifdef PROVIDE_CONTEXT_INFO
     // Start listening to context clients. When a client comes, we
@@ -44,9 +44,9 @@ CompassSensorChannel::CompassSensorChannel(const QString& id) :
     }
     setValid(compassChain_->isValid());
 
-    inputReader_ = new BufferReader<CompassData>(1);
+    inputReader_ = new BufferReader<CompassData>(16);
 
-    outputBuffer_ = new RingBuffer<CompassData>(1);
+    outputBuffer_ = new RingBuffer<CompassData>(16);
 
     // Create buffers for filter chain
     filterBin_ = new Bin;
@@ -62,7 +62,7 @@ CompassSensorChannel::CompassSensorChannel(const QString& id) :
     marshallingBin_ = new Bin;
     marshallingBin_->add(this, "sensorchannel");
 
-    outputBuffer_->join(this);
+    connectToBuffer(outputBuffer_, this);
 
     setDescription("compass north in degrees");
     addStandbyOverrideSource(compassChain_);
@@ -119,5 +119,21 @@ bool CompassSensorChannel::stop()
 void CompassSensorChannel::emitData(const CompassData& value)
 {
     compassData = value;
-    writeToClients((const void*)(&value), sizeof(CompassData));
+    downsampleAndPropagate(value, downsampleBuffer_);
+}
+
+void CompassSensorChannel::removeSession(int sessionId)
+{
+    downsampleBuffer_.remove(sessionId);
+    AbstractSensorChannel::removeSession(sessionId);
+}
+
+bool CompassSensorChannel::downsamplingSupported() const
+{
+    return true;
+}
+
+bool CompassSensorChannel::downsamplingDefault() const
+{
+    return false;
 }
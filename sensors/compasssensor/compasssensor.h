@@ -68,6 +68,16 @@ public:
 
     Compass get() const { return compassData; }
 
+    virtual void removeSession(int sessionId);
+
+    virtual bool downsamplingSupported() const;
+
+    /**
+     * Downsampling was added after the channel shipped, so it stays off
+     * until a session enables it.
+     */
+    virtual bool downsamplingDefault() const;
+
 public Q_SLOTS:
     bool start();
     bool stop();
@@ -88,6 +98,7 @@ private:
     AbstractChain* compassChain_;
     BufferReader<CompassData>* inputReader_;
     RingBuffer<CompassData>* outputBuffer_;
+    CompassDownsampleBuffer downsampleBuffer_;
 
     void emitData(const CompassData& value);
 };
@@ -24,6 +24,7 @@
 
 #include "avgvarfilter.h"
 #include <QMutexLocker>
+#include <QVarLengthArray>
 #include <math.h>
 
 AvgVarFilter::AvgVarFilter(int size) :
@@ -33,45 +34,51 @@ AvgVarFilter::AvgVarFilter(int size) :
 {
 }
 
-void AvgVarFilter::interpret(unsigned, const double* data)
+void AvgVarFilter::interpret(unsigned n, const double* input)
 {
-    double avg,var;
+    QVarLengthArray<QPair<double, double>, BATCH_SIZE> pairs;
     {
         QMutexLocker locker(&mutex);
 
-        // Ramp-up-phase:
-        if (samplesReceived < size) {
-            samples[samplesReceived] = *data;
-            samplesSquared[samplesReceived] = (*data)*(*data);
-            sampleSum += *data;
-            sampleSquareSum += (*data)*(*data);
-            ++samplesReceived;
-            return;
-        }
+        for (unsigned i = 0; i < n; ++i) {
+            const double* data = &input[i];
 
-        //qDebug() << "Data received on AvgVarFilter:" << *data;
-        //qDebug() << "Cur data:" << samples;
+            // Ramp-up-phase:
+            if (samplesReceived < size) {
+                samples[samplesReceived] = *data;
+                samplesSquared[samplesReceived] = (*data)*(*data);
+                sampleSum += *data;
+                sampleSquareSum += (*data)*(*data);
+                ++samplesReceived;
+                continue;
+            }
 
-        // Moving average & variance computations:
-        // Remove the oldest sample, replace with the new sample
-        sampleSum = sampleSum - samples[current] + *data;
-        sampleSquareSum = sampleSquareSum - samples[current] * samples[current] + (*data) * (*data);
+            //qDebug() << "Data received on AvgVarFilter:" << *data;
+            //qDebug() << "Cur data:" << samples;
 
-        // Take the new value in
-        samples[current] = *data;
-        ++current;
-        if (current >= size) {
-            current = 0;
-        }
+            // Moving average & variance computations:
+            // Remove the oldest sample, replace with the new sample
+            sampleSum = sampleSum - samples[current] + *data;
+            sampleSquareSum = sampleSquareSum - samples[current] * samples[current] + (*data) * (*data);
 
-        avg = sampleSum / size;
-        var = (size * sampleSquareSum - (sampleSum * sampleSum)) / (size * (size - 1));
-    }
+            // Take the new value in
+            samples[current] = *data;
+            ++current;
+            if (current >= size) {
+                current = 0;
+            }
+
+            double avg = sampleSum / size;
+            double var = (size * sampleSquareSum - (sampleSum * sampleSum)) / (size * (size - 1));
 
-    //qDebug() << "Avg and var" << avg << var;
+            //qDebug() << "Avg and var" << avg << var;
+
+            pairs.append(QPair<double, double>(avg, var));
+        }
+    }
 
-    QPair<double, double> pair(avg, var);
-    source_.propagate(1, &pair);
+    if (!pairs.isEmpty())
+        source_.propagate(pairs.size(), pairs.constData());
 }
 
 // Start the ramp-up again
@@ -23,6 +23,7 @@
 */
 
 #include "cutterfilter.h"
+#include <QVarLengthArray>
 
 CutterFilter::CutterFilter(double divider) :
     Filter<double, CutterFilter, double>(this, &CutterFilter::interpret),
@@ -31,8 +32,10 @@ CutterFilter::CutterFilter(double divider) :
     //qDebug() << "Creating the CutterFilter";
 }
 
-void CutterFilter::interpret(unsigned, const double* data)
+void CutterFilter::interpret(unsigned n, const double* data)
 {
-    double n = *data / divider;
-    source_.propagate(1, &n);
+    QVarLengthArray<double, BATCH_SIZE> cut(n);
+    for (unsigned i = 0; i < n; ++i)
+        cut[i] = data[i] / divider;
+    source_.propagate(n, cut.constData());
 }
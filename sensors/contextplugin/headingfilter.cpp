@@ -30,8 +30,10 @@ HeadingFilter::HeadingFilter(Property* headingProperty) :
 {
 }
 
-void HeadingFilter::interpret(unsigned, const CompassData* data)
+void HeadingFilter::interpret(unsigned n, const CompassData* data)
 {
-    headingProperty->setValue(data->degrees_);
-    source_.propagate(1, data);
+    if (!n)
+        return;
+    headingProperty->setValue(data[n - 1].degrees_);
+    source_.propagate(n, data);
 }
@@ -25,6 +25,7 @@
 #include "normalizerfilter.h"
 #include "genericdata.h"
 #include "logging.h"
+#include <QVarLengthArray>
 #include <math.h>
 
 NormalizerFilter::NormalizerFilter() :
@@ -32,15 +33,22 @@ NormalizerFilter::NormalizerFilter() :
         prevTime(0)
 {}
 
-void NormalizerFilter::interpret(unsigned, const TimedXyzData* data)
+void NormalizerFilter::interpret(unsigned count, const TimedXyzData* samples)
 {
-    // Subsample to 1hz rate.
-    if (data->timestamp_ - prevTime > 1000000 || prevTime == 0)
+    QVarLengthArray<double, BATCH_SIZE> norms;
+    for (unsigned i = 0; i < count; ++i)
     {
-        double n = sqrt(data->x_ * data->x_ + data->y_ * data->y_ + data->z_ * data-> z_);
-        source_.propagate(1, &n);
-        prevTime = data->timestamp_;
-    } else {
-        sensordLogT() << "Discarded sample from normalizer due to too short time delta.";
+        const TimedXyzData* data = &samples[i];
+        // Subsample to 1hz rate.
+        if (data->timestamp_ - prevTime > 1000000 || prevTime == 0)
+        {
+            double n = sqrt(data->x_ * data->x_ + data->y_ * data->y_ + data->z_ * data-> z_);
+            norms.append(n);
+            prevTime = data->timestamp_;
+        } else {
+            sensordLogT() << "Discarded sample from normalizer due to too short time delta.";
+        }
     }
+    if (!norms.isEmpty())
+        source_.propagate(norms.size(), norms.constData());
 }
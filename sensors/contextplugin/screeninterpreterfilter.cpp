@@ -50,11 +50,13 @@ ScreenInterpreterFilter::ScreenInterpreterFilter(
     offset = Config::configuration()->value("context/orientation_offset", QVariant(0)).toInt();
 }
 
-void ScreenInterpreterFilter::interpret(unsigned, const PoseData* data)
+void ScreenInterpreterFilter::interpret(unsigned n, const PoseData* data)
 {
-    sensordLogT() << "Data received on ScreenInterpreter... " << data->timestamp_;
-    provideScreenData(data->orientation_);
-    source_.propagate(1, data);
+    for (unsigned i = 0; i < n; ++i) {
+        sensordLogT() << "Data received on ScreenInterpreter... " << data[i].timestamp_;
+        provideScreenData(data[i].orientation_);
+    }
+    source_.propagate(n, data);
 }
 
 void ScreenInterpreterFilter::provideScreenData(PoseData::Orientation orientation)
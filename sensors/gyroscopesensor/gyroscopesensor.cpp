@@ -43,9 +43,9 @@ GyroscopeSensorChannel::GyroscopeSensorChannel(const QString& id) :
         return;
     }
 
-    gyroscopeReader_ = new BufferReader<TimedXyzData>(1);
+    gyroscopeReader_ = new BufferReader<TimedXyzData>(16);
 
-    outputBuffer_ = new RingBuffer<TimedXyzData>(1);
+    outputBuffer_ = new RingBuffer<TimedXyzData>(16);
 
     // Create buffers for filter chain
     filterBin_ = new Bin;
@@ -60,7 +60,7 @@ GyroscopeSensorChannel::GyroscopeSensorChannel(const QString& id) :
     marshallingBin_ = new Bin;
     marshallingBin_->add(this, "sensorchannel");
 
-    outputBuffer_->join(this);
+    connectToBuffer(outputBuffer_, this);
 
     // Set MetaData
     setDescription("x, y, and z axes angular velocity in mdps");
@@ -114,5 +114,21 @@ bool GyroscopeSensorChannel::stop()
 void GyroscopeSensorChannel::emitData(const TimedXyzData& value)
 {
     previousSample_ = value;
-    writeToClients((const void*)(&value), sizeof(TimedXyzData));
+    downsampleAndPropagate(value, downsampleBuffer_);
+}
+
+void GyroscopeSensorChannel::removeSession(int sessionId)
+{
+    downsampleBuffer_.remove(sessionId);
+    AbstractSensorChannel::removeSession(sessionId);
+}
+
+bool GyroscopeSensorChannel::downsamplingSupported() const
+{
+    return true;
+}
+
+bool GyroscopeSensorChannel::downsamplingDefault() const
+{
+    return false;
 }
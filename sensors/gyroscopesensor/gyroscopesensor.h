@@ -62,6 +62,16 @@ public:
 
     XYZ get() const { return previousSample_; }
 
+    virtual void removeSession(int sessionId);
+
+    virtual bool downsamplingSupported() const;
+
+    /**
+     * Downsampling was added after the channel shipped, so it stays off
+     * until a session enables it.
+     */
+    virtual bool downsamplingDefault() const;
+
 public Q_SLOTS:
     bool start();
     bool stop();
@@ -82,6 +92,7 @@ private:
     RingBuffer<TimedXyzData>*   outputBuffer_;
 
     TimedXyzData                previousSample_;
+    TimedXyzDownsampleBuffer    downsampleBuffer_;
 
     void emitData(const TimedXyzData& value);
 
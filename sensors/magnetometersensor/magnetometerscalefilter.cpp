@@ -26,6 +26,8 @@
 
 #include "magnetometerscalefilter.h"
 #include "config.h"
+#include "xyzkernels.h"
+#include <QVarLengthArray>
 
 MagnetometerScaleFilter::MagnetometerScaleFilter() :
         Filter<CalibratedMagneticFieldData, MagnetometerScaleFilter, CalibratedMagneticFieldData>(this, &MagnetometerScaleFilter::filter)
@@ -33,18 +35,22 @@ MagnetometerScaleFilter::MagnetometerScaleFilter() :
     factor = Config::configuration()->value("magnetometer/scale_coefficient", QVariant(1)).toInt();
 }
 
-void MagnetometerScaleFilter::filter(unsigned, const CalibratedMagneticFieldData* data)
+void MagnetometerScaleFilter::filter(unsigned n, const CalibratedMagneticFieldData* data)
 {
-    CalibratedMagneticFieldData transformed;
-
-    transformed.timestamp_ = data->timestamp_;
-    transformed.level_ = data->level_;
-    transformed.x_ = data->x_ * factor;
-    transformed.y_ = data->y_ * factor;
-    transformed.z_ = data->z_ * factor;
-    transformed.rx_ = data->rx_ * factor;
-    transformed.ry_ = data->ry_ * factor;
-    transformed.rz_ = data->rz_ * factor;
-
-    source_.propagate(1, &transformed);
+    if (!n)
+        return;
+
+    QVarLengthArray<CalibratedMagneticFieldData, BATCH_SIZE> transformed(n);
+    for (unsigned i = 0; i < n; ++i) {
+        transformed[i].timestamp_ = data[i].timestamp_;
+        transformed[i].level_ = data[i].level_;
+    }
+
+    // x, y, z, rx, ry and rz are consecutive
+    XyzKernels::scale(factor, 6,
+                      &data[0].x_, sizeof(CalibratedMagneticFieldData),
+                      &transformed[0].x_, sizeof(CalibratedMagneticFieldData),
+                      n);
+
+    source_.propagate(n, transformed.constData());
 }
@@ -47,7 +47,7 @@ MagnetometerSensorChannel::MagnetometerSensorChannel(const QString& id) :
     }
     setValid(magChain_->isValid());
 
-    magnetometerReader_ = new BufferReader<CalibratedMagneticFieldData>(1);
+    magnetometerReader_ = new BufferReader<CalibratedMagneticFieldData>(16);
 
     scaleCoefficient_ = Config::configuration()->value("magnetometer/scale_coefficient", QVariant(300)).toInt();
 
@@ -60,7 +60,7 @@ MagnetometerSensorChannel::MagnetometerSensorChannel(const QString& id) :
         }
     }
 
-    outputBuffer_ = new RingBuffer<CalibratedMagneticFieldData>(1);
+    outputBuffer_ = new RingBuffer<CalibratedMagneticFieldData>(16);
 
     // Create buffers for filter chain
     filterBin_ = new Bin;
@@ -90,7 +90,7 @@ MagnetometerSensorChannel::MagnetometerSensorChannel(const QString& id) :
     marshallingBin_ = new Bin;
     marshallingBin_->add(this, "sensorchannel");
 
-    outputBuffer_->join(this);
+    connectToBuffer(outputBuffer_, this);
 
     // AK897X requires scaling, which affects available ranges
     if (scaleFilter_)
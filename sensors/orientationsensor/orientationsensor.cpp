@@ -44,9 +44,9 @@ OrientationSensorChannel::OrientationSensorChannel(const QString& id) :
     }
     setValid(orientationChain_->isValid());
 
-    orientationReader_ = new BufferReader<PoseData>(1);
+    orientationReader_ = new BufferReader<PoseData>(16);
 
-    outputBuffer_ = new RingBuffer<PoseData>(1);
+    outputBuffer_ = new RingBuffer<PoseData>(16);
 
     // Create buffers for filter chain
     filterBin_ = new Bin;
@@ -63,7 +63,7 @@ OrientationSensorChannel::OrientationSensorChannel(const QString& id) :
     marshallingBin_ = new Bin;
     marshallingBin_->add(this, "sensorchannel");
 
-    outputBuffer_->join(this);
+    connectToBuffer(outputBuffer_, this);
 
     setDescription("orientation of the device screen as 6 pre-defined positions");
     setRangeSource(orientationChain_);
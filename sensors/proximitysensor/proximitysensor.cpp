@@ -43,9 +43,9 @@ ProximitySensorChannel::ProximitySensorChannel(const QString& id) :
         return;
     }
 
-    proximityReader_ = new BufferReader<ProximityData>(1);
+    proximityReader_ = new BufferReader<ProximityData>(16);
 
-    outputBuffer_ = new RingBuffer<ProximityData>(1);
+    outputBuffer_ = new RingBuffer<ProximityData>(16);
 
     // Create buffers for filter chain
     filterBin_ = new Bin;
@@ -61,7 +61,7 @@ ProximitySensorChannel::ProximitySensorChannel(const QString& id) :
     marshallingBin_ = new Bin;
     marshallingBin_->add(this, "sensorchannel");
 
-    outputBuffer_->join(this);
+    connectToBuffer(outputBuffer_, this);
 
     setValid(true);
 
@@ -45,11 +45,11 @@ RotationSensorChannel::RotationSensorChannel(const QString& id) :
         return;
     }
 
-    accelerometerReader_ = new BufferReader<AccelerationData>(1);
+    accelerometerReader_ = new BufferReader<AccelerationData>(16);
 
     compassChain_ = sm.requestChain("compasschain");
     if (compassChain_ && compassChain_->isValid()) {
-        compassReader_ = new BufferReader<CompassData>(1);
+        compassReader_ = new BufferReader<CompassData>(16);
     } else {
         sensordLogW() << "Unable to use compass for z-axis rotation.";
     }
@@ -61,7 +61,7 @@ RotationSensorChannel::RotationSensorChannel(const QString& id) :
     }
     setValid(true);
 
-    outputBuffer_ = new RingBuffer<TimedXyzData>(1);
+    outputBuffer_ = new RingBuffer<TimedXyzData>(16);
 
     // Create buffers for filter chain
     filterBin_ = new Bin;
@@ -90,7 +90,7 @@ RotationSensorChannel::RotationSensorChannel(const QString& id) :
     marshallingBin_ = new Bin;
     marshallingBin_->add(this, "sensorchannel");
 
-    outputBuffer_->join(this);
+    connectToBuffer(outputBuffer_, this);
 
     setDescription("x, y, and z axes rotation in degrees");
     introduceAvailableDataRange(DataRange(-179, 180, 1));
@@ -42,9 +42,9 @@ TapSensorChannel::TapSensorChannel(const QString& id) :
         return;
     }
 
-    tapReader_ = new BufferReader<TapData>(1);
+    tapReader_ = new BufferReader<TapData>(16);
 
-    outputBuffer_ = new RingBuffer<TapData>(1);
+    outputBuffer_ = new RingBuffer<TapData>(16);
 
     // Create buffers for filter chain
     filterBin_ = new Bin;
@@ -60,7 +60,7 @@ TapSensorChannel::TapSensorChannel(const QString& id) :
     marshallingBin_ = new Bin;
     marshallingBin_->add(this, "sensorchannel");
 
-    outputBuffer_->join(this);
+    connectToBuffer(outputBuffer_, this);
 
     setValid(true);
 
@@ -28,6 +28,13 @@
 #include <QtDebug>
 #include <QTest>
 #include <QVariant>
+#include <QDir>
+#include <QFile>
+#include <QMutex>
+
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 #include "adaptortest.h"
 
@@ -39,9 +46,98 @@
 #include "kbslideradaptor.h"
 #include "proximityadaptor.h"
 #include "gyroscopeadaptor.h"
+#include "iioadaptor.h"
+#include "datatypes/genericdata.h"
 
 #include "config.h"
 
+/**
+ * IIO adaptor decoding accelerometer scans into TimedXyzData.
+ */
+class TestIioAdaptor : public IioAdaptor
+{
+public:
+    TestIioAdaptor(const QString& id) :
+        IioAdaptor(id), x_(-1), y_(-1), z_(-1)
+    {
+        // Smaller than a full read, readers must be woken up in between.
+        buffer_ = new DeviceAdaptorRingBuffer<TimedXyzData>(16);
+        setAdaptedSensor("iiotest", "IIO test accelerometer", buffer_);
+    }
+
+    ~TestIioAdaptor()
+    {
+        delete buffer_;
+    }
+
+    void init()
+    {
+        IioAdaptor::init();
+        x_ = channel("accel_x");
+        y_ = channel("accel_y");
+        z_ = channel("accel_z");
+    }
+
+protected:
+    void processScans(const char* scans, unsigned count)
+    {
+        decodeXyz(scans, count, x_, y_, z_, buffer_);
+    }
+
+private:
+    DeviceAdaptorRingBuffer<TimedXyzData>* buffer_;
+    int x_;
+    int y_;
+    int z_;
+};
+
+/**
+ * Reader collecting samples from the IIO test adaptor.
+ */
+class IioTestReader : public RingBufferReader<TimedXyzData>
+{
+public:
+    void pushNewData()
+    {
+        TimedXyzData values[32];
+        unsigned n;
+        while ((n = read(32, values))) {
+            QMutexLocker locker(&mutex);
+            for (unsigned i = 0; i < n; ++i)
+                samples.append(values[i]);
+        }
+    }
+
+    int count()
+    {
+        QMutexLocker locker(&mutex);
+        return samples.size();
+    }
+
+    QMutex mutex;
+    QVector<TimedXyzData> samples;
+};
+
+static void writeTestFile(const QString& path, const QByteArray& content)
+{
+    QFile file(path);
+    file.open(QIODevice::WriteOnly | QIODevice::Truncate);
+    file.write(content);
+}
+
+static QByteArray readTestFile(const QString& path)
+{
+    QFile file(path);
+    file.open(QIODevice::ReadOnly);
+    return file.readAll().trimmed();
+}
+
+static void putLe(char* out, quint64 value, int bytes)
+{
+    for (int i = 0; i < bytes; ++i)
+        out[i] = (char)(value >> (8 * i));
+}
+
 void AdaptorTest::initTestCase()
 {
     Config::loadConfig("/etc/sensorfw/sensord.conf", "/etc/sensorfw/sensord.conf.d");
@@ -156,5 +252,124 @@ void AdaptorTest::testGyroscopeAdaptor()
     adaptor->stopAdaptor();
 }
 
+void AdaptorTest::testIioAdaptor()
+{
+    IioChannel channel;
+    QVERIFY(IioAdaptor::parseType("be:u10/16>>2", channel));
+    QVERIFY(channel.bigEndian);
+    QVERIFY(!channel.isSigned);
+    QCOMPARE(channel.bits, 10);
+    QCOMPARE(channel.storageBits, 16);
+    QCOMPARE(channel.shift, 2);
+    const char bigEndian[2] = { (char)0xab, (char)0xcd };
+    QCOMPARE(IioAdaptor::decode(bigEndian, channel), (qint64)((0xabcd >> 2) & 0x3ff));
+    QVERIFY(IioAdaptor::parseType("le:s12/16>>4", channel));
+    const char negative[2] = { (char)0xf0, (char)0xff };
+    QCOMPARE(IioAdaptor::decode(negative, channel), (qint64)-1);
+    QVERIFY(!IioAdaptor::parseType("le:s12/12>>0", channel));
+    QVERIFY(!IioAdaptor::parseType("le:s16/16>>4", channel));
+
+    // Fake device: three 16 bit axes and a 64 bit timestamp give
+    // 16 byte scans, accel_temp is present but not enabled.
+    QString root = QDir::tempPath() + QString("/sensorfw-iiotest-%1").arg(getpid());
+    QString device = root + "/iio:device0";
+    QDir().mkpath(device + "/scan_elements");
+    QDir().mkpath(device + "/buffer");
+    QDir().mkpath(device + "/trigger");
+    const char* names[] = { "accel_x", "accel_y", "accel_z", "timestamp", "accel_temp" };
+    const char* types[] = { "le:s12/16>>4", "le:s12/16>>4", "le:s12/16>>4", "le:s64/64>>0", "le:s16/16>>0" };
+    for (int i = 0; i < 5; ++i) {
+        QString prefix = device + "/scan_elements/in_" + names[i];
+        writeTestFile(prefix + "_en", "0");
+        writeTestFile(prefix + "_index", QByteArray::number(i));
+        writeTestFile(prefix + "_type", types[i]);
+    }
+    writeTestFile(device + "/buffer/enable", "0");
+    writeTestFile(device + "/buffer/length", "0");
+    writeTestFile(device + "/trigger/current_trigger", "");
+    writeTestFile(device + "/sampling_frequency", "100");
+    writeTestFile(device + "/current_timestamp_clock", "realtime\n");
+
+    QString chardev = root + "/chardev";
+    QCOMPARE(mkfifo(chardev.toLocal8Bit().constData(), 0600), 0);
+    int fd = open(chardev.toLocal8Bit().constData(), O_RDWR);
+    QVERIFY(fd != -1);
+
+    writeTestFile(root + "/iio.conf",
+                  "[iiotestadaptor]\n"
+                  "iio_device = " + device.toLocal8Bit() + "\n"
+                  "iio_chardev = " + chardev.toLocal8Bit() + "\n"
+                  "iio_channels = \"accel_x,accel_y,accel_z,timestamp\"\n"
+                  "iio_trigger = test-trigger\n"
+                  "iio_buffer_length = 64\n");
+    Config::loadConfig(root + "/iio.conf", "");
+
+    TestIioAdaptor* adaptor = new TestIioAdaptor("iiotestadaptor");
+    adaptor->init();
+    QVERIFY(adaptor->isValid());
+    QCOMPARE(adaptor->getInterval(), 10u);
+
+    IioTestReader reader;
+    RingBufferBase* buffer = adaptor->findBuffer("iiotest");
+    QVERIFY(buffer);
+    QVERIFY(buffer->join(&reader));
+
+    QVERIFY(adaptor->startAdaptor());
+    QVERIFY(adaptor->startSensor());
+    QCOMPARE(readTestFile(device + "/buffer/enable"), QByteArray("1"));
+    QCOMPARE(readTestFile(device + "/buffer/length"), QByteArray("64"));
+    QCOMPARE(readTestFile(device + "/trigger/current_trigger"), QByteArray("test-trigger"));
+    QCOMPARE(readTestFile(device + "/scan_elements/in_accel_x_en"), QByteArray("1"));
+    QCOMPARE(readTestFile(device + "/scan_elements/in_timestamp_en"), QByteArray("1"));
+    QCOMPARE(readTestFile(device + "/scan_elements/in_accel_temp_en"), QByteArray("0"));
+    QCOMPARE(readTestFile(device + "/current_timestamp_clock"), QByteArray("monotonic"));
+
+    const int scans = 64;
+    QByteArray data(scans * 16, 0);
+    for (int i = 0; i < scans; ++i) {
+        char* scan = data.data() + i * 16;
+        putLe(scan, (quint64)(i * 16), 2);
+        putLe(scan + 2, (quint64)(-i * 16), 2);
+        putLe(scan + 4, (quint64)(2 * i * 16), 2);
+        putLe(scan + 8, (quint64)i * 1000000, 8);
+    }
+    QCOMPARE(write(fd, data.constData(), data.size()), (ssize_t)data.size());
+
+    for (int wait = 0; wait < 200 && reader.count() < scans; ++wait)
+        QTest::qWait(10);
+    QCOMPARE(reader.count(), scans);
+    for (int i = 0; i < scans; ++i) {
+        const TimedXyzData& sample = reader.samples.at(i);
+        QCOMPARE(sample.x_, i);
+        QCOMPARE(sample.y_, -i);
+        QCOMPARE(sample.z_, 2 * i);
+        QCOMPARE(sample.timestamp_, (quint64)i * 1000);
+    }
+
+    quint64 reads, received;
+    adaptor->statistics(reads, received);
+    QCOMPARE(received, (quint64)scans);
+    QVERIFY(reads < received);
+
+    adaptor->stopSensor();
+    adaptor->stopAdaptor();
+    QCOMPARE(readTestFile(device + "/buffer/enable"), QByteArray("0"));
+
+    buffer->unjoin(&reader);
+    delete adaptor;
+    close(fd);
+    QFile::remove(chardev);
+    QFile::remove(root + "/iio.conf");
+    foreach (const QString& dir, QStringList() << "scan_elements" << "buffer" << "trigger") {
+        QDir sub(device + "/" + dir);
+        foreach (const QString& file, sub.entryList(QDir::Files))
+            sub.remove(file);
+        QDir(device).rmdir(dir);
+    }
+    QFile::remove(device + "/sampling_frequency");
+    QFile::remove(device + "/current_timestamp_clock");
+    QDir(root).rmdir("iio:device0");
+    QDir().rmdir(root);
+}
 
 QTEST_MAIN(AdaptorTest)
@@ -1,2 +1,2 @@
 TEMPLATE = subdirs
-SUBDIRS = benchmarktest fakeadaptor dummyclient
+SUBDIRS = benchmarktest corebenchmark fakeadaptor replayadaptor loadadaptor dummyclient loadgenerator
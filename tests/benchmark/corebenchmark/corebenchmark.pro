@@ -0,0 +1,50 @@
+QT += testlib \
+      dbus \
+      network
+QT -= gui
+
+include(../../common-install.pri)
+
+CONFIG += debug
+TEMPLATE = app
+TARGET = sensorcorebenchmark-test
+HEADERS += corebenchmarktests.h \
+    ../../../filters/coordinatealignfilter/coordinatealignfilter.h \
+    ../../../filters/downsamplefilter/downsamplefilter.h \
+    ../../../filters/avgaccfilter/avgaccfilter.h \
+    ../../../filters/rotationfilter/rotationfilter.h \
+    ../../../filters/orientationinterpreter/orientationinterpreter.h \
+    ../../../chains/compasschain/compassfilter.h \
+    ../../../chains/magcalibrationchain/calibrationfilter.h
+
+SOURCES += corebenchmarktests.cpp \
+    ../../../filters/coordinatealignfilter/coordinatealignfilter.cpp \
+    ../../../filters/downsamplefilter/downsamplefilter.cpp \
+    ../../../filters/avgaccfilter/avgaccfilter.cpp \
+    ../../../filters/rotationfilter/rotationfilter.cpp \
+    ../../../filters/orientationinterpreter/orientationinterpreter.cpp \
+    ../../../chains/compasschain/compassfilter.cpp \
+    ../../../chains/magcalibrationchain/calibrationfilter.cpp
+
+SENSORFW_INCLUDEPATHS = ../../../include \
+                        ../../../filters \
+                        ../../../filters/coordinatealignfilter \
+                        ../../../filters/downsamplefilter \
+                        ../../../filters/avgaccfilter \
+                        ../../../filters/rotationfilter \
+                        ../../../filters/orientationinterpreter \
+                        ../../../chains/compasschain \
+                        ../../../chains/magcalibrationchain \
+                        ../../../datatypes \
+                        ../../../core \
+                        ../../..
+
+DEPENDPATH += $$SENSORFW_INCLUDEPATHS
+INCLUDEPATH += $$SENSORFW_INCLUDEPATHS
+
+QMAKE_LIBDIR_FLAGS += -L../../../datatypes \
+                      -L../../../core
+
+equals(QT_MAJOR_VERSION, 5):{
+    QMAKE_LIBDIR_FLAGS += -lsensordatatypes-qt5 -lsensorfw-qt5
+}
@@ -0,0 +1,1070 @@
+/**
+   @file corebenchmarktests.cpp
+   @brief In-process benchmarks for sensord core
+
+   <p>
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+*/
+
+#include <QElapsedTimer>
+#include <QSet>
+#include <QFile>
+#include <QDir>
+#include <QTextStream>
+#include <QVector>
+#include <QVariant>
+#include <QtDebug>
+#include <QThread>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+
+#include "samplering.h"
+#include "ringbuffer.h"
+#include "deviceadaptorringbuffer.h"
+#include "bufferreader.h"
+#include "bin.h"
+#include "config.h"
+#include "genericdata.h"
+#include "orientationdata.h"
+#include "timedunsigned.h"
+#include "coordinatealignfilter.h"
+#include "downsamplefilter.h"
+#include "avgaccfilter.h"
+#include "rotationfilter.h"
+#include "orientationinterpreter.h"
+#include "compassfilter.h"
+#include "calibrationfilter.h"
+#include "xyzkernels.h"
+#include "orientationmath.h"
+#include "samplerecorder.h"
+#include "latestvaluepage.h"
+#include "corebenchmarktests.h"
+
+/** Allocations made while #countAllocations is set. */
+static long allocations = 0;
+
+/** Are allocations counted. */
+static bool countAllocations = false;
+
+extern "C" {
+
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t n, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+
+/*
+ * Allocation counting wrappers interposing the glibc allocator for the
+ * whole benchmark process. Operator new goes through malloc.
+ */
+void* malloc(size_t size) __THROW
+{
+    if (__atomic_load_n(&countAllocations, __ATOMIC_RELAXED))
+        __atomic_fetch_add(&allocations, 1, __ATOMIC_RELAXED);
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t n, size_t size) __THROW
+{
+    if (__atomic_load_n(&countAllocations, __ATOMIC_RELAXED))
+        __atomic_fetch_add(&allocations, 1, __ATOMIC_RELAXED);
+    return __libc_calloc(n, size);
+}
+
+void* realloc(void* ptr, size_t size) __THROW
+{
+    if (__atomic_load_n(&countAllocations, __ATOMIC_RELAXED))
+        __atomic_fetch_add(&allocations, 1, __ATOMIC_RELAXED);
+    return __libc_realloc(ptr, size);
+}
+
+}
+
+/** Read chunk used by ring buffer readers, same as typical BufferReader. */
+static const unsigned CHUNK = 16;
+
+/**
+ * Reader state for #LegacyRingBuffer.
+ */
+struct LegacyReader
+{
+    LegacyReader() : readCount(0), samples(0) {}
+
+    unsigned     readCount;
+    TimedXyzData chunk[CHUNK];
+    long         samples;
+};
+
+/**
+ * Data path of RingBuffer before power-of-two masking and span copies:
+ * modulo per element, element-wise copy, QSet of readers.
+ */
+class LegacyRingBuffer
+{
+public:
+    LegacyRingBuffer(unsigned size) : bufferSize_(size), buffer_(new TimedXyzData[size]), writeCount_(0) {}
+    ~LegacyRingBuffer() { delete[] buffer_; }
+
+    void join(LegacyReader* reader) { readers_.insert(reader); }
+
+    void write(unsigned n, const TimedXyzData* values)
+    {
+        while (n) {
+            buffer_[writeCount_ % bufferSize_] = *values++;
+            ++writeCount_;
+            --n;
+        }
+        LegacyReader* reader;
+        foreach (reader, readers_) {
+            unsigned read;
+            while ((read = this->read(CHUNK, reader->chunk, *reader)))
+                reader->samples += read;
+        }
+    }
+
+private:
+    unsigned read(unsigned n, TimedXyzData* values, LegacyReader& reader) const
+    {
+        unsigned itemsRead = 0;
+        while (itemsRead < n && reader.readCount != writeCount_) {
+            *values++ = buffer_[reader.readCount++ % bufferSize_];
+            ++itemsRead;
+        }
+        return itemsRead;
+    }
+
+    unsigned             bufferSize_;
+    TimedXyzData*        buffer_;
+    unsigned             writeCount_;
+    QSet<LegacyReader*>  readers_;
+};
+
+/**
+ * RingBuffer with public write access for benchmarking.
+ */
+class BenchRingBuffer : public RingBuffer<TimedXyzData>
+{
+public:
+    BenchRingBuffer(unsigned size) : RingBuffer<TimedXyzData>(size) {}
+
+    using RingBuffer<TimedXyzData>::write;
+};
+
+/**
+ * RingBuffer reader draining the buffer in chunks on every wakeup.
+ */
+class BenchReader : public RingBufferReader<TimedXyzData>
+{
+public:
+    BenchReader() : samples(0) {}
+
+    void pushNewData()
+    {
+        unsigned n;
+        while ((n = read(CHUNK, chunk)))
+            samples += n;
+    }
+
+    TimedXyzData chunk[CHUNK];
+    long         samples;
+};
+
+/**
+ * Thread publishing XYZ samples with y = -x and z = 2x into a latest
+ * value page slot, so that torn reads can be detected.
+ */
+class LatestValuePublisherThread : public QThread
+{
+public:
+    LatestValuePublisherThread(LatestValuePageWriter& writer, int slot) :
+        writer_(writer), slot_(slot), stop_(0), published_(0) {}
+
+    void stop() { __atomic_store_n(&stop_, 1, __ATOMIC_RELEASE); }
+    long published() const { return published_; }
+
+protected:
+    void run()
+    {
+        while (!__atomic_load_n(&stop_, __ATOMIC_ACQUIRE)) {
+            int x = ++published_ & 0xffffff;
+            TimedXyzData sample(published_, x, -x, 2 * x);
+            writer_.write(slot_, &sample, sizeof(sample));
+        }
+    }
+
+private:
+    LatestValuePageWriter& writer_;
+    int                    slot_;
+    int                    stop_;
+    long                   published_;
+};
+
+/**
+ * Hardware cache miss counter of the calling thread. Reports -1 when
+ * performance counters are not available.
+ */
+class CacheMissCounter
+{
+public:
+    CacheMissCounter()
+    {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd_ = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+
+    ~CacheMissCounter()
+    {
+        if (fd_ != -1)
+            close(fd_);
+    }
+
+    void start()
+    {
+        if (fd_ != -1) {
+            ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+
+    qint64 stop()
+    {
+        quint64 value;
+        if (fd_ == -1)
+            return -1;
+        ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+        if (::read(fd_, &value, sizeof(value)) != sizeof(value))
+            return -1;
+        return value;
+    }
+
+private:
+    int fd_;
+};
+
+/**
+ * Pipeline input fed by the benchmark driver.
+ */
+class BenchFeed
+{
+public:
+    virtual ~BenchFeed() {}
+
+    /**
+     * Commit samples to the input buffer and wake up its readers.
+     *
+     * @param seq sequence number of the first sample.
+     * @param n number of samples.
+     * @param timestamp timestamp of the first sample.
+     * @param period sample period in microseconds.
+     */
+    virtual void push(unsigned seq, unsigned n, quint64 timestamp, quint64 period) = 0;
+};
+
+/**
+ * Adaptor ring buffer replaying a precomputed sample pattern with
+ * fresh timestamps.
+ */
+template <class TYPE>
+class BenchInput : public BenchFeed
+{
+public:
+    BenchInput(const QVector<TYPE>& pattern) : buffer(256), pattern_(pattern) {}
+
+    void push(unsigned seq, unsigned n, quint64 timestamp, quint64 period)
+    {
+        for (unsigned i = 0; i < n; ++i) {
+            TYPE* slot = buffer.nextSlot();
+            *slot = pattern_.at((seq + i) % pattern_.size());
+            slot->timestamp_ = timestamp + i * period;
+            buffer.commit();
+        }
+        buffer.wakeUpReaders();
+    }
+
+    DeviceAdaptorRingBuffer<TYPE> buffer;
+
+private:
+    QVector<TYPE> pattern_;
+};
+
+/**
+ * Pipeline output counting received samples.
+ */
+template <class TYPE>
+class BenchOutput : public RingBufferReader<TYPE>
+{
+public:
+    BenchOutput() : samples(0) {}
+
+    void pushNewData()
+    {
+        unsigned n;
+        while ((n = this->read(CHUNK, chunk)))
+            samples += n;
+    }
+
+    TYPE chunk[CHUNK];
+    long samples;
+};
+
+/**
+ * Accelerometer pattern: device slowly rotating through all axes
+ * with some noise, in mG.
+ */
+static QVector<TimedXyzData> accelerometerPattern()
+{
+    QVector<TimedXyzData> pattern;
+    for (int i = 0; i < 1024; ++i) {
+        double a = i * 2 * M_PI / 1024;
+        pattern.append(TimedXyzData(0,
+                                    (int)(981 * sin(a)) + (i * 7) % 13 - 6,
+                                    (int)(981 * cos(a) * sin(3 * a)) + (i * 5) % 11 - 5,
+                                    (int)(981 * cos(a) * cos(3 * a)) + (i * 3) % 7 - 3));
+    }
+    return pattern;
+}
+
+/**
+ * Magnetometer pattern: field vector turning around the vertical axis.
+ */
+static QVector<CalibratedMagneticFieldData> magnetometerPattern()
+{
+    QVector<CalibratedMagneticFieldData> pattern;
+    for (int i = 0; i < 1024; ++i) {
+        double a = i * 2 * M_PI / 1024;
+        int x = (int)(300 * cos(a));
+        int y = (int)(300 * sin(a));
+        int z = -400 + (i * 7) % 13;
+        pattern.append(CalibratedMagneticFieldData(0, x, y, z, x + 20, y - 35, z + 10, 3));
+    }
+    return pattern;
+}
+
+/**
+ * Read positive integer from environment.
+ *
+ * @param name variable name.
+ * @param defaultValue value used when not set.
+ * @return value.
+ */
+static unsigned envValue(const char* name, unsigned defaultValue)
+{
+    bool ok;
+    unsigned value = qgetenv(name).toUInt(&ok);
+    return ok ? value : defaultValue;
+}
+
+/**
+ * Push samples through a pipeline and report per sample cost. Feeds
+ * are served round-robin, one batch each per period.
+ *
+ * Controlled from the environment:
+ *   SENSORFW_BENCH_SAMPLES  samples per feed, default 100000.
+ *   SENSORFW_BENCH_RATE     feed rate in Hz, 0 (default) is unpaced.
+ *   SENSORFW_BENCH_BATCH    samples committed per wakeup, default 1.
+ *   SENSORFW_BENCH_BASELINE file of "name ns/sample" lines. Runs over
+ *                           125% of the baseline fail.
+ *
+ * @param name pipeline name.
+ * @param feeds pipeline inputs.
+ * @param output pipeline output sample counter.
+ */
+static void runPipeline(const QString& name, const QList<BenchFeed*>& feeds, const long& output)
+{
+    const unsigned samples = envValue("SENSORFW_BENCH_SAMPLES", 100000);
+    const unsigned rate = envValue("SENSORFW_BENCH_RATE", 0);
+    const unsigned batch = qMax(envValue("SENSORFW_BENCH_BATCH", 1), 1u);
+    const quint64 period = rate ? 1000000 / rate : 10000;
+
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    quint64 timestamp = 1000000;
+    qint64 busyNs = 0;
+
+    CacheMissCounter cacheMisses;
+    allocations = 0;
+    __atomic_store_n(&countAllocations, true, __ATOMIC_RELAXED);
+    cacheMisses.start();
+    QElapsedTimer timer;
+    for (unsigned seq = 0; seq < samples; seq += batch) {
+        if (rate) {
+            deadline.tv_nsec += batch * (1000000000 / rate);
+            while (deadline.tv_nsec >= 1000000000) {
+                deadline.tv_nsec -= 1000000000;
+                ++deadline.tv_sec;
+            }
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL);
+        }
+        timer.start();
+        foreach (BenchFeed* feed, feeds)
+            feed->push(seq, batch, timestamp, period);
+        busyNs += timer.nsecsElapsed();
+        timestamp += batch * period;
+    }
+    qint64 misses = cacheMisses.stop();
+    __atomic_store_n(&countAllocations, false, __ATOMIC_RELAXED);
+
+    double total = (double)samples * feeds.size();
+    double nsPerSample = busyNs / total;
+    qDebug() << QString("[%1]:").arg(name, -11).toLocal8Bit().constData()
+             << nsPerSample
+             << allocations / total
+             << (misses < 0 ? -1.0 : misses / total)
+             << output;
+
+    QVERIFY2(output > 0, "Pipeline produced no output");
+
+    QFile baseline(qgetenv("SENSORFW_BENCH_BASELINE"));
+    if (!baseline.fileName().isEmpty() && baseline.open(QIODevice::ReadOnly)) {
+        QTextStream stream(&baseline);
+        while (!stream.atEnd()) {
+            QStringList fields = stream.readLine().split(' ', QString::SkipEmptyParts);
+            if (fields.size() == 2 && fields.at(0) == name) {
+                double limit = fields.at(1).toDouble() * 1.25;
+                QVERIFY2(nsPerSample <= limit,
+                         QString("%1: %2 ns/sample exceeds limit %3").arg(name).arg(nsPerSample).arg(limit).toLocal8Bit().constData());
+            }
+        }
+    }
+}
+
+/**
+ * Run a pipeline of a single TimedXyzData filter between a buffer
+ * reader and an output buffer, the way chains wire their filters.
+ *
+ * @tparam OUT output data type.
+ * @param name pipeline name.
+ * @param filter filter to benchmark. Deleted when done.
+ * @param sinkName name of the filter sink.
+ * @param sourceName name of the filter source.
+ */
+template <class OUT>
+static void runXyzFilter(const QString& name, FilterBase* filter, const QString& sinkName, const QString& sourceName)
+{
+    BenchInput<TimedXyzData> input(accelerometerPattern());
+    BufferReader<TimedXyzData> reader(CHUNK);
+    RingBuffer<OUT> outputBuffer(256);
+    BenchOutput<OUT> output;
+
+    Bin bin;
+    bin.add(&reader, "reader");
+    bin.add(filter, "filter");
+    bin.add(&outputBuffer, "buffer");
+    QVERIFY(bin.join("reader", "source", "filter", sinkName));
+    QVERIFY(bin.join("filter", sourceName, "buffer", "sink"));
+    QVERIFY(input.buffer.join(&reader));
+    QVERIFY(outputBuffer.join(&output));
+
+    QList<BenchFeed*> feeds;
+    feeds << &input;
+    runPipeline(name, feeds, output.samples);
+
+    delete filter;
+}
+
+void CoreBenchmarkTest::initTestCase()
+{
+    // Filters read their tunables from the configuration, run with the
+    // installed one or with defaults when there is none.
+    Config::loadConfig("/etc/sensorfw/sensord.conf", "/etc/sensorfw/sensord.conf.d/");
+}
+
+void CoreBenchmarkTest::init()
+{
+}
+
+void CoreBenchmarkTest::cleanup()
+{
+}
+
+void CoreBenchmarkTest::cleanupTestCase()
+{
+}
+
+void CoreBenchmarkTest::testSampleHandoff()
+{
+    // Burst models accelerometer + gyroscope + magnetometer with two
+    // clients each producing samples between two main loop iterations.
+    const int SAMPLES = 60000;
+    const int BURST = 6;
+
+    TimedXyzData sample(0, 1, 2, 3);
+
+    /// Legacy path: malloc + pipe write per sample, one read per wakeup.
+    typedef struct {
+        int id;
+        int size;
+        void* buffer;
+    } PipeData;
+
+    int pipefds[2];
+    QVERIFY(pipe(pipefds) == 0);
+
+    long pipeSyscalls = 0;
+    long pipeWakeups = 0;
+    long pipeAllocs = 0;
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < SAMPLES; i += BURST) {
+        for (int j = 0; j < BURST; ++j) {
+            PipeData pipeData;
+            pipeData.id = j;
+            pipeData.size = sizeof(sample);
+            pipeData.buffer = malloc(sizeof(sample));
+            ++pipeAllocs;
+            memcpy(pipeData.buffer, &sample, sizeof(sample));
+            QVERIFY(write(pipefds[1], &pipeData, sizeof(pipeData)) == sizeof(pipeData));
+            ++pipeSyscalls;
+        }
+        for (int j = 0; j < BURST; ++j) {
+            PipeData pipeData;
+            ++pipeWakeups;
+            QVERIFY(read(pipefds[0], &pipeData, sizeof(pipeData)) == sizeof(pipeData));
+            ++pipeSyscalls;
+            free(pipeData.buffer);
+        }
+    }
+    qint64 pipeNs = timer.nsecsElapsed();
+    close(pipefds[0]);
+    close(pipefds[1]);
+
+    /// Ring path: push into SPSC ring, coalesced eventfd, drain per wakeup.
+    int efd = eventfd(0, EFD_NONBLOCK);
+    QVERIFY(efd != -1);
+    SampleRing ring(65536);
+    QAtomicInt pending(0);
+
+    long ringSyscalls = 0;
+    long ringWakeups = 0;
+    long drained = 0;
+    timer.restart();
+    for (int i = 0; i < SAMPLES; i += BURST) {
+        for (int j = 0; j < BURST; ++j) {
+            QVERIFY(ring.push(j, &sample, sizeof(sample)));
+            if (pending.fetchAndStoreOrdered(1) == 0) {
+                quint64 value = 1;
+                QVERIFY(write(efd, &value, sizeof(value)) == sizeof(value));
+                ++ringSyscalls;
+            }
+        }
+        quint64 value;
+        ++ringWakeups;
+        QVERIFY(read(efd, &value, sizeof(value)) == sizeof(value));
+        ++ringSyscalls;
+        pending.fetchAndStoreOrdered(0);
+
+        const int* ids;
+        int count;
+        int size;
+        const void* data;
+        while (ring.front(ids, count, data, size)) {
+            QCOMPARE(size, (int)sizeof(sample));
+            ring.pop();
+            drained += count;
+        }
+    }
+    qint64 ringNs = timer.nsecsElapsed();
+    close(efd);
+
+    QCOMPARE(drained, (long)SAMPLES);
+
+    qDebug() << "[Handoff    ]: syscalls/sample wakeups/sample allocs/sample ns/sample";
+    qDebug() << "[  malloc+pipe]:" << pipeSyscalls * 1.0 / SAMPLES
+             << pipeWakeups * 1.0 / SAMPLES
+             << pipeAllocs * 1.0 / SAMPLES
+             << pipeNs * 1.0 / SAMPLES;
+    qDebug() << "[ring+eventfd]:" << ringSyscalls * 1.0 / SAMPLES
+             << ringWakeups * 1.0 / SAMPLES
+             << 0.0
+             << ringNs * 1.0 / SAMPLES;
+
+    QVERIFY(ringSyscalls < pipeSyscalls);
+
+    /// Fan-out: one sample for all sessions as one record vs a record per session.
+    SampleRing fanOutRing(65536);
+    int sessions[BURST];
+    for (int j = 0; j < BURST; ++j)
+        sessions[j] = j;
+
+    long perSessionBytes = 0;
+    timer.restart();
+    for (int i = 0; i < SAMPLES; i += BURST) {
+        for (int j = 0; j < BURST; ++j) {
+            QVERIFY(fanOutRing.push(sessions[j], &sample, sizeof(sample)));
+            perSessionBytes += sizeof(sample);
+        }
+        const int* ids;
+        int count;
+        int size;
+        const void* data;
+        while (fanOutRing.front(ids, count, data, size))
+            fanOutRing.pop();
+    }
+    qint64 perSessionNs = timer.nsecsElapsed();
+
+    long sharedBytes = 0;
+    drained = 0;
+    timer.restart();
+    for (int i = 0; i < SAMPLES; i += BURST) {
+        QVERIFY(fanOutRing.push(sessions, BURST, &sample, sizeof(sample)));
+        sharedBytes += sizeof(sample);
+        const int* ids;
+        int count;
+        int size;
+        const void* data;
+        while (fanOutRing.front(ids, count, data, size)) {
+            QCOMPARE(count, BURST);
+            QCOMPARE(ids[BURST - 1], BURST - 1);
+            QCOMPARE(memcmp(data, &sample, sizeof(sample)), 0);
+            fanOutRing.pop();
+            drained += count;
+        }
+    }
+    qint64 sharedNs = timer.nsecsElapsed();
+
+    QCOMPARE(drained, (long)SAMPLES);
+
+    qDebug() << "[Fan-out    ]: sessions bytes copied/sample ns/sample";
+    qDebug() << "[per-session]:" << BURST << perSessionBytes * 1.0 / SAMPLES << perSessionNs * 1.0 / SAMPLES;
+    qDebug() << "[     shared]:" << BURST << sharedBytes * 1.0 / SAMPLES << sharedNs * 1.0 / SAMPLES;
+
+    QVERIFY(sharedBytes < perSessionBytes);
+}
+
+void CoreBenchmarkTest::testRingBuffer()
+{
+    const int SAMPLES = 1 << 20;
+    const unsigned SIZE = 100;
+    const unsigned BATCHES[] = { 1, 16, 64 };
+
+    TimedXyzData input[64];
+    for (int i = 0; i < 64; ++i)
+        input[i] = TimedXyzData(i, i, i + 1, i + 2);
+
+    qDebug() << "[RingBuffer ]: batch legacy ns/sample masked ns/sample";
+    for (unsigned b = 0; b < sizeof(BATCHES) / sizeof(BATCHES[0]); ++b) {
+        unsigned batch = BATCHES[b];
+
+        LegacyRingBuffer legacy(SIZE);
+        LegacyReader legacyReaders[2];
+        legacy.join(&legacyReaders[0]);
+        legacy.join(&legacyReaders[1]);
+
+        QElapsedTimer timer;
+        timer.start();
+        for (int i = 0; i < SAMPLES; i += batch)
+            legacy.write(batch, input);
+        qint64 legacyNs = timer.nsecsElapsed();
+
+        BenchRingBuffer masked(SIZE);
+        BenchReader maskedReaders[2];
+        QVERIFY(masked.join(&maskedReaders[0]));
+        QVERIFY(masked.join(&maskedReaders[1]));
+
+        timer.restart();
+        for (int i = 0; i < SAMPLES; i += batch)
+            masked.write(batch, input);
+        qint64 maskedNs = timer.nsecsElapsed();
+
+        QCOMPARE(maskedReaders[0].samples, legacyReaders[0].samples);
+        QCOMPARE(maskedReaders[1].samples, legacyReaders[1].samples);
+        QCOMPARE(maskedReaders[0].chunk[0].z_, legacyReaders[0].chunk[0].z_);
+
+        qDebug() << "[            ]:" << batch
+                 << legacyNs * 1.0 / SAMPLES
+                 << maskedNs * 1.0 / SAMPLES;
+    }
+}
+
+void CoreBenchmarkTest::testFilterPipelines()
+{
+    qDebug() << "[Pipeline   ]: ns/sample allocs/sample cache-misses/sample output-samples";
+
+    double matrix[3][3] = {
+        { 0, -1, 0 },
+        { 1, 0, 0 },
+        { 0, 0, -1 }
+    };
+    FilterBase* coordinateAlign = CoordinateAlignFilter::factoryMethod();
+    ((CoordinateAlignFilter*)coordinateAlign)->setProperty("transMatrix", QVariant::fromValue(TMatrix(matrix)));
+    runXyzFilter<TimedXyzData>("coordalign", coordinateAlign, "sink", "source");
+
+    FilterBase* downsample = DownsampleFilter::factoryMethod();
+    ((DownsampleFilter*)downsample)->setBufferSize(8);
+    ((DownsampleFilter*)downsample)->setTimeout(1000);
+    runXyzFilter<TimedXyzData>("downsample", downsample, "sink", "source");
+
+    runXyzFilter<TimedXyzData>("avgacc", AvgAccFilter::factoryMethod(), "sink", "source");
+    runXyzFilter<TimedXyzData>("rotation", RotationFilter::factoryMethod(), "accelerometersink", "source");
+    runXyzFilter<PoseData>("orientation", OrientationInterpreter::factoryMethod(), "accsink", "orientation");
+
+    // Calibration: magnetometer data through the calibration filter.
+    {
+        BenchInput<CalibratedMagneticFieldData> input(magnetometerPattern());
+        BufferReader<CalibratedMagneticFieldData> reader(CHUNK);
+        FilterBase* calibration = CalibrationFilter::factoryMethod();
+        RingBuffer<CalibratedMagneticFieldData> outputBuffer(256);
+        BenchOutput<CalibratedMagneticFieldData> output;
+
+        Bin bin;
+        bin.add(&reader, "reader");
+        bin.add(calibration, "calibration");
+        bin.add(&outputBuffer, "buffer");
+        QVERIFY(bin.join("reader", "source", "calibration", "magsink"));
+        QVERIFY(bin.join("calibration", "calibratedmagneticfield", "buffer", "sink"));
+        QVERIFY(input.buffer.join(&reader));
+        QVERIFY(outputBuffer.join(&output));
+
+        QList<BenchFeed*> feeds;
+        feeds << &input;
+        runPipeline("calibration", feeds, output.samples);
+        delete calibration;
+    }
+
+    // Compass chain: accelerometer through averaging and downsampling,
+    // magnetometer through calibration, both into the compass filter.
+    {
+        BenchInput<TimedXyzData> accInput(accelerometerPattern());
+        BenchInput<CalibratedMagneticFieldData> magInput(magnetometerPattern());
+        BufferReader<TimedXyzData> accReader(CHUNK);
+        BufferReader<CalibratedMagneticFieldData> magReader(CHUNK);
+        FilterBase* avgAcc = AvgAccFilter::factoryMethod();
+        FilterBase* downsample = DownsampleFilter::factoryMethod();
+        FilterBase* calibration = CalibrationFilter::factoryMethod();
+        FilterBase* compass = CompassFilter::factoryMethod();
+        RingBuffer<CompassData> outputBuffer(256);
+        BenchOutput<CompassData> output;
+
+        Bin bin;
+        bin.add(&accReader, "accelerometer");
+        bin.add(&magReader, "magnetometer");
+        bin.add(avgAcc, "avgaccelerometer");
+        bin.add(downsample, "downsamplefilter");
+        bin.add(calibration, "calibration");
+        bin.add(compass, "compassfilter");
+        bin.add(&outputBuffer, "buffer");
+        QVERIFY(bin.join("accelerometer", "source", "avgaccelerometer", "sink"));
+        QVERIFY(bin.join("avgaccelerometer", "source", "downsamplefilter", "sink"));
+        QVERIFY(bin.join("downsamplefilter", "source", "compassfilter", "accsink"));
+        QVERIFY(bin.join("magnetometer", "source", "calibration", "magsink"));
+        QVERIFY(bin.join("calibration", "calibratedmagneticfield", "compassfilter", "magsink"));
+        QVERIFY(bin.join("compassfilter", "magnorthangle", "buffer", "sink"));
+        QVERIFY(accInput.buffer.join(&accReader));
+        QVERIFY(magInput.buffer.join(&magReader));
+        QVERIFY(outputBuffer.join(&output));
+
+        QList<BenchFeed*> feeds;
+        feeds << &magInput << &accInput;
+        runPipeline("compass", feeds, output.samples);
+        delete avgAcc;
+        delete downsample;
+        delete calibration;
+        delete compass;
+    }
+}
+
+void CoreBenchmarkTest::testXyzKernels()
+{
+    const int SAMPLES = 1 << 20;
+    const unsigned BATCHES[] = { 1, 8, 64 };
+    const double matrix[3][3] = { { 0, -1, 0 }, { 1, 0, 0 }, { 0.5, 0, -0.25 } };
+
+    CalibratedMagneticFieldData input[64];
+    for (int i = 0; i < 64; ++i)
+        input[i] = CalibratedMagneticFieldData(i, i * 37 - 1000, 500 - i * 13, i * i,
+                                               -i * 7, i * 11, 3 - i, 2);
+
+    CalibratedMagneticFieldData expected[64];
+    CalibratedMagneticFieldData expectedScaled[64];
+    XyzKernels::Implementation selected = XyzKernels::implementation();
+    QVERIFY(XyzKernels::setImplementation(XyzKernels::Scalar));
+    XyzKernels::transform(matrix, &input[0].x_, sizeof(CalibratedMagneticFieldData),
+                          &expected[0].x_, sizeof(CalibratedMagneticFieldData), 64);
+    XyzKernels::scale(3, 6, &input[0].x_, sizeof(CalibratedMagneticFieldData),
+                      &expectedScaled[0].x_, sizeof(CalibratedMagneticFieldData), 64);
+
+    qDebug() << "[XyzKernels ]: implementation batch transform ns/sample scale ns/sample";
+    for (int impl = 0; impl < XyzKernels::ImplementationCount; ++impl) {
+        if (!XyzKernels::setImplementation((XyzKernels::Implementation)impl))
+            continue;
+
+        for (unsigned b = 0; b < sizeof(BATCHES) / sizeof(BATCHES[0]); ++b) {
+            unsigned batch = BATCHES[b];
+            CalibratedMagneticFieldData output[64];
+
+            QElapsedTimer timer;
+            timer.start();
+            for (int i = 0; i < SAMPLES; i += batch)
+                XyzKernels::transform(matrix, &input[0].x_, sizeof(CalibratedMagneticFieldData),
+                                      &output[0].x_, sizeof(CalibratedMagneticFieldData), batch);
+            qint64 transformNs = timer.nsecsElapsed();
+
+            for (unsigned i = 0; i < batch; ++i) {
+                QCOMPARE(output[i].x_, expected[i].x_);
+                QCOMPARE(output[i].y_, expected[i].y_);
+                QCOMPARE(output[i].z_, expected[i].z_);
+            }
+
+            timer.restart();
+            for (int i = 0; i < SAMPLES; i += batch)
+                XyzKernels::scale(3, 6, &input[0].x_, sizeof(CalibratedMagneticFieldData),
+                                  &output[0].x_, sizeof(CalibratedMagneticFieldData), batch);
+            qint64 scaleNs = timer.nsecsElapsed();
+
+            for (unsigned i = 0; i < batch; ++i) {
+                QCOMPARE(output[i].x_, expectedScaled[i].x_);
+                QCOMPARE(output[i].rz_, expectedScaled[i].rz_);
+            }
+
+            qDebug() << "[            ]:" << XyzKernels::name((XyzKernels::Implementation)impl)
+                     << batch
+                     << transformNs * 1.0 / SAMPLES
+                     << scaleNs * 1.0 / SAMPLES;
+        }
+    }
+    XyzKernels::setImplementation(selected);
+}
+
+void CoreBenchmarkTest::testHeadingEngine()
+{
+    const int SAMPLES = 1 << 16;
+    const int ROUNDS = 16;
+    const double RAD_TO_DEG = 180 / M_PI;
+
+    // Trace of a device slowly turning around all axes in a field with
+    // 60 degree inclination, with sensor noise, in accelerometer mg.
+    QVector<TimedXyzData> acc(SAMPLES);
+    QVector<TimedXyzData> mag(SAMPLES);
+    unsigned seed = 1;
+    for (int i = 0; i < SAMPLES; ++i) {
+        double yaw = i * 2 * M_PI / 4096;
+        double pitch = 1.2 * sin(i * 2 * M_PI / 1500);
+        double roll = 1.2 * sin(i * 2 * M_PI / 2300);
+        double cy = cos(yaw), sy = sin(yaw);
+        double cp = cos(pitch), sp = sin(pitch);
+        double cr = cos(roll), sr = sin(roll);
+        double g[3] = { -sp, cp * sr, cp * cr };
+        double m[3] = { 0.5 * cy * cp + 0.866 * -sp,
+                        0.5 * (cy * sp * sr - sy * cr) + 0.866 * cp * sr,
+                        0.5 * (cy * sp * cr + sy * sr) + 0.866 * cp * cr };
+        int noise[6];
+        for (int k = 0; k < 6; ++k) {
+            seed = seed * 1103515245 + 12345;
+            noise[k] = (int)((seed >> 16) % 21) - 10;
+        }
+        acc[i] = TimedXyzData(i * 10000, g[0] * 1000 + noise[0], g[1] * 1000 + noise[1], g[2] * 1000 + noise[2]);
+        mag[i] = TimedXyzData(i * 10000, m[0] * 1000 + noise[3], m[1] * 1000 + noise[4], m[2] * 1000 + noise[5]);
+    }
+
+    QVector<double> exactHeading(SAMPLES);
+    QVector<int> exactElevation(SAMPLES);
+    for (int i = 0; i < SAMPLES; ++i) {
+        exactHeading[i] = OrientationMath::heading(acc[i].x_, acc[i].y_, acc[i].z_,
+                                                   mag[i].x_, mag[i].y_, mag[i].z_,
+                                                   OrientationMath::Exact);
+        exactElevation[i] = round(OrientationMath::elevation(acc[i].x_, acc[i].y_, acc[i].z_,
+                                                             OrientationMath::Exact) * RAD_TO_DEG);
+    }
+
+    qDebug() << "[Heading    ]: precision heading ns/sample max error deg"
+             << "elevation ns/sample rounded mismatches";
+    for (int p = OrientationMath::Exact; p <= OrientationMath::Coarse; ++p) {
+        OrientationMath::Precision precision = (OrientationMath::Precision)p;
+        double maxError = 0;
+        int mismatches = 0;
+        volatile double sink = 0;
+
+        QElapsedTimer timer;
+        timer.start();
+        for (int r = 0; r < ROUNDS; ++r) {
+            for (int i = 0; i < SAMPLES; ++i)
+                sink = OrientationMath::heading(acc[i].x_, acc[i].y_, acc[i].z_,
+                                                mag[i].x_, mag[i].y_, mag[i].z_,
+                                                precision);
+        }
+        qint64 headingNs = timer.nsecsElapsed();
+
+        timer.restart();
+        for (int r = 0; r < ROUNDS; ++r) {
+            for (int i = 0; i < SAMPLES; ++i)
+                sink = OrientationMath::elevation(acc[i].x_, acc[i].y_, acc[i].z_, precision);
+        }
+        qint64 elevationNs = timer.nsecsElapsed();
+        Q_UNUSED(sink);
+
+        for (int i = 0; i < SAMPLES; ++i) {
+            double heading = OrientationMath::heading(acc[i].x_, acc[i].y_, acc[i].z_,
+                                                      mag[i].x_, mag[i].y_, mag[i].z_,
+                                                      precision);
+            double error = fabs(remainder(heading - exactHeading[i], 2 * M_PI)) * RAD_TO_DEG;
+            maxError = qMax(maxError, error);
+            int elevation = round(OrientationMath::elevation(acc[i].x_, acc[i].y_, acc[i].z_,
+                                                            precision) * RAD_TO_DEG);
+            if (elevation != exactElevation[i])
+                ++mismatches;
+        }
+
+        qDebug() << "[            ]:" << OrientationMath::name(precision)
+                 << headingNs * 1.0 / (SAMPLES * ROUNDS) << maxError
+                 << elevationNs * 1.0 / (SAMPLES * ROUNDS) << mismatches;
+
+        QVERIFY(maxError < ((precision == OrientationMath::Coarse) ? 0.1 : 0.001));
+    }
+}
+
+void CoreBenchmarkTest::testSampleRecording()
+{
+    const int SAMPLES = 1 << 16;
+
+    // Recording is configured once per process, before the first stream
+    QString confPath = QDir::tempPath() + "/corebenchmark-recorder.conf";
+    QString recordingPath = QDir::tempPath() + "/corebenchmark-recording.bin";
+    QFile conf(confPath);
+    QVERIFY(conf.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    QTextStream(&conf) << "[recorder]\nfile = " << recordingPath << "\nmax_size = 16777216\n";
+    conf.close();
+    Config::loadConfig(confPath, "");
+    recordingPath = Config::configuration()->value<QString>("recorder/file", "");
+
+    DeviceAdaptorRingBuffer<TimedXyzData> plain(64);
+    DeviceAdaptorRingBuffer<TimedXyzData> recorded(64);
+    DeviceAdaptorRingBuffer<TimedUnsigned> recordedUnsigned(64);
+    recorded.enableRecording("benchadaptor/accelerometer");
+    recordedUnsigned.enableRecording("benchalsadaptor/als");
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < SAMPLES; ++i) {
+        *plain.nextSlot() = TimedXyzData(i, i, -i, 2 * i);
+        plain.commit();
+    }
+    qint64 plainNs = timer.nsecsElapsed();
+
+    timer.restart();
+    for (int i = 0; i < SAMPLES; ++i) {
+        *recorded.nextSlot() = TimedXyzData(i, i, -i, 2 * i);
+        recorded.commit();
+    }
+    qint64 recordedNs = timer.nsecsElapsed();
+
+    TimedUnsigned lux;
+    lux.timestamp_ = 7;
+    lux.value_ = 42;
+    *recordedUnsigned.nextSlot() = lux;
+    recordedUnsigned.commit();
+
+    qDebug() << "[Recording  ]: plain ns/sample recorded ns/sample dropped";
+    qDebug() << "[            ]:" << plainNs * 1.0 / SAMPLES << recordedNs * 1.0 / SAMPLES
+             << SampleRecorder::dropped();
+
+    SampleRecording recording;
+    QVERIFY(recording.open(recordingPath));
+    int xyzStream = recording.findStream("benchadaptor/accelerometer");
+    int alsStream = recording.findStream("benchalsadaptor/als");
+    QVERIFY(xyzStream >= 0);
+    QVERIFY(alsStream >= 0);
+    QCOMPARE(recording.streams().at(xyzStream).type, (int)SampleRecorder::TimedXyzSample);
+    QCOMPARE(recording.streams().at(xyzStream).sampleSize, (int)sizeof(TimedXyzData));
+    QCOMPARE(recording.streams().at(alsStream).type, (int)SampleRecorder::TimedUnsignedSample);
+
+    SampleRecording::Record record;
+    quint64 previous = 0;
+    int xyzSamples = 0;
+    int alsSamples = 0;
+    while (recording.next(record)) {
+        QVERIFY(record.timestamp >= previous);
+        previous = record.timestamp;
+        if (record.stream == xyzStream) {
+            TimedXyzData sample;
+            memcpy(&sample, record.data, sizeof(sample));
+            QCOMPARE(sample.x_, xyzSamples);
+            QCOMPARE(sample.z_, 2 * xyzSamples);
+            ++xyzSamples;
+        } else if (record.stream == alsStream) {
+            TimedUnsigned sample;
+            memcpy(&sample, record.data, sizeof(sample));
+            QCOMPARE(sample.value_, 42u);
+            ++alsSamples;
+        }
+    }
+    QCOMPARE(xyzSamples, SAMPLES);
+    QCOMPARE(alsSamples, 1);
+}
+
+void CoreBenchmarkTest::testLatestValuePage()
+{
+    const int READS = 1 << 20;
+
+    QByteArray memory(latestValuePageSize(), 0);
+    LatestValuePageWriter writer(memory.data(), getpid());
+    LatestValuePageReader reader(memory.constData());
+    QVERIFY(reader.isValid());
+    QCOMPARE(reader.pid(), (quint32)getpid());
+
+    int slot = writer.addChannel("accelerometersensor");
+    QVERIFY(slot >= 0);
+    QCOMPARE(writer.addChannel("accelerometersensor"), slot);
+    QCOMPARE(reader.find("accelerometersensor"), slot);
+    QCOMPARE(reader.find("gyroscopesensor"), -1);
+
+    TimedXyzData sample;
+    QVERIFY(!reader.read(slot, &sample, sizeof(sample)));
+
+    LatestValuePublisherThread publisher(writer, slot);
+    publisher.start();
+    while (!reader.read(slot, &sample, sizeof(sample)))
+        ;
+
+    int misses = 0;
+    int torn = 0;
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < READS; ++i) {
+        if (!reader.read(slot, &sample, sizeof(sample))) {
+            ++misses;
+            continue;
+        }
+        if (sample.y_ != -sample.x_ || sample.z_ != 2 * sample.x_ || (sample.timestamp_ & 0xffffff) != (quint64)sample.x_)
+            ++torn;
+    }
+    qint64 readNs = timer.nsecsElapsed();
+    publisher.stop();
+    publisher.wait();
+
+    qDebug() << "[LatestValue]: ns/read published retries-exhausted torn";
+    qDebug() << "[            ]:" << readNs * 1.0 / READS << publisher.published() << misses << torn;
+
+    QCOMPARE(torn, 0);
+    QVERIFY(!reader.read(slot, &sample, sizeof(TimedUnsigned)));
+
+    writer.close();
+    QVERIFY(!reader.isValid());
+}
+
+QTEST_MAIN(CoreBenchmarkTest)
@@ -0,0 +1,48 @@
+/**
+   @file corebenchmarktests.h
+   @brief In-process benchmarks for sensord core
+
+   <p>
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+*/
+
+#ifndef CORE_BENCHMARK_TEST_H
+#define CORE_BENCHMARK_TEST_H
+
+#include <QTest>
+
+class CoreBenchmarkTest : public QObject
+{
+     Q_OBJECT
+
+private slots:
+    // Setup tests
+    void initTestCase();
+    void init();
+    void cleanup();
+    void cleanupTestCase();
+
+    // Tests
+    void testSampleHandoff();
+    void testRingBuffer();
+    void testFilterPipelines();
+    void testXyzKernels();
+    void testHeadingEngine();
+    void testSampleRecording();
+    void testLatestValuePage();
+};
+
+#endif // CORE_BENCHMARK_TEST_H
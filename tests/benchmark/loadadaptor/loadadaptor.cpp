@@ -0,0 +1,230 @@
+/**
+   @file loadadaptor.cpp
+   @brief Adaptor generating synthetic sensor load
+
+   <p>
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include "loadadaptor.h"
+#include "config.h"
+#include "logging.h"
+#include "datatypes/orientationdata.h"
+#include "datatypes/timedunsigned.h"
+#include "datatypes/tapdata.h"
+#include "datatypes/touchdata.h"
+#include "datatypes/utils.h"
+#include <QHash>
+#include <stdlib.h>
+#include <errno.h>
+#include <time.h>
+
+/** Size of generated ring buffers. */
+static const unsigned BUFFER_SIZE = 1024;
+
+/** Triangle wave in [-1000, 1000] with a period of 4000 samples. */
+static inline int wave(unsigned sequence)
+{
+    int phase = sequence % 4000;
+    return (phase < 2000) ? phase - 1000 : 3000 - phase;
+}
+
+static void fill(TimedXyzData& sample, unsigned sequence)
+{
+    sample.x_ = wave(sequence);
+    sample.y_ = wave(sequence + 1000);
+    sample.z_ = wave(sequence + 2000);
+}
+
+static void fill(TimedUnsigned& sample, unsigned sequence)
+{
+    sample.value_ = wave(sequence) + 1000;
+}
+
+static void fill(CalibratedMagneticFieldData& sample, unsigned sequence)
+{
+    sample.x_ = sample.rx_ = wave(sequence);
+    sample.y_ = sample.ry_ = wave(sequence + 1000);
+    sample.z_ = sample.rz_ = wave(sequence + 2000);
+    sample.level_ = 3;
+}
+
+static void fill(CompassData& sample, unsigned sequence)
+{
+    sample.degrees_ = sample.rawDegrees_ = sample.correctedDegrees_ = sequence % 360;
+    sample.level_ = 3;
+}
+
+static void fill(ProximityData& sample, unsigned sequence)
+{
+    sample.value_ = wave(sequence) + 1000;
+    sample.withinProximity_ = sample.value_ > 1000;
+}
+
+static void fill(TapData& sample, unsigned sequence)
+{
+    sample.direction_ = (TapData::Direction)(sequence % 3);
+    sample.type_ = (sequence & 1) ? TapData::DoubleTap : TapData::SingleTap;
+}
+
+static void fill(TouchData& sample, unsigned sequence)
+{
+    fill(static_cast<TimedXyzData&>(sample), sequence);
+    sample.object_ = 1;
+    sample.state_ = TouchData::FingerStateAccurate;
+}
+
+template <class TYPE>
+class TypedLoadStream : public LoadStream
+{
+public:
+    TypedLoadStream() : buffer_(BUFFER_SIZE) {}
+
+    RingBufferBase* buffer() { return &buffer_; }
+
+    void push(unsigned count, quint64 timestamp, unsigned& sequence)
+    {
+        for (unsigned i = 0; i < count; ++i) {
+            TYPE* sample = buffer_.nextSlot();
+            *sample = TYPE();
+            sample->timestamp_ = timestamp;
+            fill(*sample, sequence++);
+            buffer_.commit();
+        }
+        buffer_.wakeUpReaders();
+    }
+
+private:
+    DeviceAdaptorRingBuffer<TYPE> buffer_;
+};
+
+static LoadStream* createStream(const QString& type)
+{
+    if (type == "xyz")
+        return new TypedLoadStream<TimedXyzData>;
+    if (type == "unsigned")
+        return new TypedLoadStream<TimedUnsigned>;
+    if (type == "magneticfield")
+        return new TypedLoadStream<CalibratedMagneticFieldData>;
+    if (type == "compass")
+        return new TypedLoadStream<CompassData>;
+    if (type == "proximity")
+        return new TypedLoadStream<ProximityData>;
+    if (type == "tap")
+        return new TypedLoadStream<TapData>;
+    if (type == "touch")
+        return new TypedLoadStream<TouchData>;
+    return NULL;
+}
+
+LoadAdaptor::LoadAdaptor(const QString& id) :
+    DeviceAdaptor(id),
+    stream_(NULL),
+    sequence_(0)
+{
+    t = new LoadAdaptorThread(this);
+
+    QString group = "load_" + id + "/";
+    QString defaultSensor = id.endsWith("adaptor") ? id.left(id.size() - 7) : id;
+    QString sensor = Config::configuration()->value<QString>(group + "sensor", defaultSensor);
+    QString type = Config::configuration()->value<QString>(group + "type", "xyz");
+    rate_ = Config::configuration()->value<unsigned>(group + "rate", 100);
+    burst_ = qMax(Config::configuration()->value<unsigned>(group + "burst", 1), 1u);
+    jitter_ = Config::configuration()->value<unsigned>(group + "jitter", 0);
+    seed_ = qHash(id);
+
+    stream_ = createStream(type);
+    if (!stream_ || !rate_) {
+        sensordLogW() << "Invalid load settings for " << id << ": type " << type << ", rate " << rate_;
+        setValid(false);
+        return;
+    }
+
+    setAdaptedSensor(sensor, "Synthetic " + type + " load", stream_->buffer());
+    sensordLogD() << "Load adaptor " << id << ": " << type << " at " << rate_ << " Hz, bursts of "
+                  << burst_ << ", jitter " << jitter_ << " us";
+}
+
+LoadAdaptor::~LoadAdaptor()
+{
+    stopSensor();
+    delete t;
+    delete stream_;
+}
+
+bool LoadAdaptor::startAdaptor()
+{
+    return isValid();
+}
+
+void LoadAdaptor::stopAdaptor()
+{
+}
+
+bool LoadAdaptor::startSensor()
+{
+    if (!stream_)
+        return false;
+    if (t->isRunning())
+        return true;
+    t->running = true;
+    t->start();
+    return true;
+}
+
+void LoadAdaptor::stopSensor()
+{
+    t->running = false;
+    t->wait();
+}
+
+void LoadAdaptor::init()
+{
+}
+
+void LoadAdaptor::generate(volatile bool& running)
+{
+    const quint64 NSEC = 1000000000ULL;
+    const quint64 period = burst_ * NSEC / rate_;
+
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    quint64 deadline = now.tv_sec * NSEC + now.tv_nsec;
+
+    while (running) {
+        deadline += period;
+        quint64 wakeup = deadline;
+        if (jitter_)
+            wakeup += (quint64)(rand_r(&seed_) % (jitter_ + 1)) * 1000;
+
+        timespec at;
+        at.tv_sec = wakeup / NSEC;
+        at.tv_nsec = wakeup % NSEC;
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &at, NULL) == EINTR)
+            ;
+
+        stream_->push(burst_, Utils::getTimeStamp(), sequence_);
+    }
+}
+
+LoadAdaptorThread::LoadAdaptorThread(LoadAdaptor *parent) : running(false), parent_(parent)
+{
+}
+
+void LoadAdaptorThread::run()
+{
+    parent_->generate(running);
+}
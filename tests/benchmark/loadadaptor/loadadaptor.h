@@ -0,0 +1,125 @@
+/**
+   @file loadadaptor.h
+   @brief Adaptor generating synthetic sensor load
+
+   <p>
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef LOADADAPTOR_H
+#define LOADADAPTOR_H
+
+#include "deviceadaptor.h"
+#include "deviceadaptorringbuffer.h"
+#include <QThread>
+
+class LoadAdaptor;
+
+class LoadAdaptorThread : public QThread
+{
+    Q_OBJECT;
+public:
+    LoadAdaptorThread(LoadAdaptor *parent);
+    void run();
+    volatile bool running;
+
+private:
+    LoadAdaptor *parent_;
+};
+
+/**
+ * Ring buffer of generated samples of one type.
+ */
+class LoadStream
+{
+public:
+    virtual ~LoadStream() {}
+
+    /**
+     * Buffer exposed as adapted sensor.
+     *
+     * @return buffer.
+     */
+    virtual RingBufferBase* buffer() = 0;
+
+    /**
+     * Commit a burst of samples and wake up readers.
+     *
+     * @param count Number of samples.
+     * @param timestamp Timestamp of the samples.
+     * @param sequence Sequence number of the first sample, advanced by count.
+     */
+    virtual void push(unsigned count, quint64 timestamp, unsigned& sequence) = 0;
+};
+
+/**
+ * @brief Adaptor generating synthetic samples at a configurable rate.
+ *
+ * Instances are registered for every adaptor name listed in
+ * \c loadadaptor/adaptors. Each instance reads its settings from the
+ * group \c load_<adaptor name>:
+ *  - \c sensor: name of the adapted sensor, defaults to the adaptor
+ *    name without its "adaptor" suffix.
+ *  - \c type: sample type, one of xyz, unsigned, magneticfield,
+ *    compass, proximity, tap or touch. Defaults to xyz.
+ *  - \c rate: samples per second, default 100.
+ *  - \c burst: samples committed back to back per wakeup, default 1.
+ *  - \c jitter: maximum random delay of a burst in microseconds,
+ *    default 0.
+ *
+ * Bursts are scheduled on absolute deadlines, so jitter and scheduling
+ * delays do not accumulate into rate drift.
+ */
+class LoadAdaptor : public DeviceAdaptor
+{
+    Q_OBJECT;
+public:
+    static DeviceAdaptor* factoryMethod(const QString& id)
+    {
+        return new LoadAdaptor(id);
+    }
+
+    ~LoadAdaptor();
+
+    bool startAdaptor();
+    void stopAdaptor();
+
+    bool startSensor();
+    void stopSensor();
+
+    void init();
+
+    /**
+     * Generate samples until stopped.
+     *
+     * @param running Cleared to stop generating.
+     */
+    void generate(volatile bool& running);
+
+protected:
+    LoadAdaptor(const QString& id);
+
+private:
+    LoadAdaptorThread* t;
+    LoadStream* stream_;
+    unsigned rate_;
+    unsigned burst_;
+    unsigned jitter_;
+    unsigned seed_;
+    unsigned sequence_;
+};
+
+#endif
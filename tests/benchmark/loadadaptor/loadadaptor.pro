@@ -0,0 +1,26 @@
+TEMPLATE     = lib
+CONFIG      += plugin
+
+TARGET       = loadadaptor
+
+include( ../../../common-config.pri )
+
+HEADERS += loadadaptor.h \
+           loadadaptorplugin.h
+
+SOURCES += loadadaptor.cpp \
+           loadadaptorplugin.cpp
+
+SENSORFW_INCLUDEPATHS = ../../../include \
+                        ../../../core \
+                        ../../../datatypes \
+                        ../../../filters \
+                        ../../..
+
+DEPENDPATH  += $$SENSORFW_INCLUDEPATHS
+INCLUDEPATH += $$SENSORFW_INCLUDEPATHS
+
+include(../../../common-install.pri)
+target.path = $$PLUGINPATH/testing
+
+INSTALLS += target
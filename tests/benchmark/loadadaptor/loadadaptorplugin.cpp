@@ -0,0 +1,43 @@
+/**
+   @file loadadaptorplugin.cpp
+   @brief Plugin for LoadAdaptor
+
+   <p>
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include "loadadaptorplugin.h"
+#include "loadadaptor.h"
+#include "sensormanager.h"
+#include "config.h"
+#include "logging.h"
+#include <QStringList>
+
+void LoadAdaptorPlugin::Register(class Loader&)
+{
+    QStringList adaptors = Config::configuration()->value("loadadaptor/adaptors").toStringList();
+    if (adaptors.isEmpty())
+        sensordLogW() << "No adaptors listed in loadadaptor/adaptors";
+
+    foreach (const QString& adaptor, adaptors) {
+        sensordLogD() << "registering load adaptor " << adaptor;
+        SensorManager::instance().registerDeviceAdaptor<LoadAdaptor>(adaptor.trimmed());
+    }
+}
+
+#if QT_VERSION < QT_VERSION_CHECK(5, 0, 0)
+Q_EXPORT_PLUGIN2(loadadaptor, LoadAdaptorPlugin)
+#endif
@@ -0,0 +1,43 @@
+/**
+   @file loadadaptorplugin.h
+   @brief Plugin for LoadAdaptor
+
+   <p>
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef LOADADAPTORPLUGIN_H
+#define LOADADAPTORPLUGIN_H
+
+#include "plugin.h"
+
+/**
+ * Registers a #LoadAdaptor for every adaptor name listed in
+ * \c loadadaptor/adaptors. Map those adaptor names to this plugin in the
+ * configuration, for example \c plugins/accelerometeradaptor =
+ * \c loadadaptor.
+ */
+class LoadAdaptorPlugin : public Plugin
+{
+    Q_OBJECT
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+    Q_PLUGIN_METADATA(IID "com.nokia.SensorService.Plugin/1.0")
+#endif
+private:
+    void Register(class Loader& l);
+};
+
+#endif
@@ -0,0 +1,465 @@
+/**
+   @file loadgenerator.cpp
+   @brief Multi-session client load generator
+
+   <p>
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include <QCoreApplication>
+#include <QStringList>
+#include <QTextStream>
+#include <QTimer>
+#include <QFile>
+#include <QProcess>
+#include <QMetaObject>
+#include <unistd.h>
+#include <time.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "sensormanagerinterface.h"
+#include "accelerometersensor_i.h"
+#include "alssensor_i.h"
+#include "compasssensor_i.h"
+#include "gyroscopesensor_i.h"
+#include "magnetometersensor_i.h"
+#include "orientationsensor_i.h"
+#include "proximitysensor_i.h"
+#include "rotationsensor_i.h"
+#include "loadgenerator.h"
+
+static QTextStream out(stdout);
+
+static quint64 monotonicTime()
+{
+    timespec stamp;
+    clock_gettime(CLOCK_MONOTONIC, &stamp);
+    return (quint64)stamp.tv_sec * 1000000 + stamp.tv_nsec / 1000;
+}
+
+static bool registerInterface(const QString& sensor)
+{
+    SensorManagerInterface& sm = SensorManagerInterface::instance();
+    if (!sm.loadPlugin(sensor)) {
+        out << "Failed to load " << sensor << ": " << sm.errorString() << "\n";
+        return false;
+    }
+
+    if (sensor == "accelerometersensor")
+        sm.registerSensorInterface<AccelerometerSensorChannelInterface>(sensor);
+    else if (sensor == "alssensor")
+        sm.registerSensorInterface<ALSSensorChannelInterface>(sensor);
+    else if (sensor == "compasssensor")
+        sm.registerSensorInterface<CompassSensorChannelInterface>(sensor);
+    else if (sensor == "gyroscopesensor")
+        sm.registerSensorInterface<GyroscopeSensorChannelInterface>(sensor);
+    else if (sensor == "magnetometersensor")
+        sm.registerSensorInterface<MagnetometerSensorChannelInterface>(sensor);
+    else if (sensor == "orientationsensor")
+        sm.registerSensorInterface<OrientationSensorChannelInterface>(sensor);
+    else if (sensor == "proximitysensor")
+        sm.registerSensorInterface<ProximitySensorChannelInterface>(sensor);
+    else if (sensor == "rotationsensor")
+        sm.registerSensorInterface<RotationSensorChannelInterface>(sensor);
+    else {
+        out << "Unsupported sensor " << sensor << "\n";
+        return false;
+    }
+    return true;
+}
+
+LoadConfiguration::LoadConfiguration() :
+    sessions(1),
+    interval(0),
+    bufferSize(0),
+    bufferInterval(0),
+    downsampling(false)
+{
+}
+
+bool LoadConfiguration::parse(const QString& text)
+{
+    QStringList parts = text.split(':');
+    spec = text;
+    sensor = parts.takeFirst();
+    if (sensor.isEmpty())
+        return false;
+
+    foreach (const QString& part, parts) {
+        QString key = part.section('=', 0, 0);
+        bool ok = false;
+        int value = part.section('=', 1).toInt(&ok);
+        if (!ok || value < 0)
+            return false;
+        if (key == "sessions")
+            sessions = value;
+        else if (key == "interval")
+            interval = value;
+        else if (key == "buffersize")
+            bufferSize = value;
+        else if (key == "bufferinterval")
+            bufferInterval = value;
+        else if (key == "downsampling")
+            downsampling = value;
+        else
+            return false;
+    }
+    return sessions > 0;
+}
+
+LoadSession::LoadSession(AbstractSensorChannelInterface* sensor, QObject* parent) :
+    QObject(parent),
+    samples(0),
+    intervals(0),
+    intervalSum(0),
+    intervalSquareSum(0),
+    sensor_(sensor),
+    previousArrival_(0)
+{
+}
+
+LoadSession::~LoadSession()
+{
+    delete sensor_;
+}
+
+bool LoadSession::connectIfPresent(const char* signal, const char* slot)
+{
+    // SIGNAL() and SLOT() prefix the signature with a type code
+    QByteArray signature = QMetaObject::normalizedSignature(signal + 1);
+    if (sensor_->metaObject()->indexOfSignal(signature.constData()) < 0)
+        return false;
+    return connect(sensor_, signal, this, slot);
+}
+
+bool LoadSession::start(const LoadConfiguration& configuration)
+{
+    bool connected = false;
+    connected |= connectIfPresent(SIGNAL(dataAvailable(const XYZ&)), SLOT(xyzAvailable(const XYZ&)));
+    connected |= connectIfPresent(SIGNAL(dataAvailable(const MagneticField&)), SLOT(magneticFieldAvailable(const MagneticField&)));
+    connected |= connectIfPresent(SIGNAL(dataAvailable(const Compass&)), SLOT(compassAvailable(const Compass&)));
+    connected |= connectIfPresent(SIGNAL(dataAvailable(const Unsigned&)), SLOT(unsignedAvailable(const Unsigned&)));
+    connected |= connectIfPresent(SIGNAL(ALSChanged(const Unsigned&)), SLOT(unsignedAvailable(const Unsigned&)));
+    connected |= connectIfPresent(SIGNAL(orientationChanged(const Unsigned&)), SLOT(unsignedAvailable(const Unsigned&)));
+    if (configuration.bufferSize > 1) {
+        connectIfPresent(SIGNAL(frameAvailable(const QVector<XYZ>&)), SLOT(xyzFrameAvailable(const QVector<XYZ>&)));
+        connectIfPresent(SIGNAL(frameAvailable(const QVector<MagneticField>&)), SLOT(magneticFieldFrameAvailable(const QVector<MagneticField>&)));
+    }
+    if (!connected) {
+        out << "No supported data signal on " << configuration.sensor << "\n";
+        return false;
+    }
+
+    if (configuration.interval)
+        sensor_->setInterval(configuration.interval);
+    if (configuration.bufferSize)
+        sensor_->setBufferSize(configuration.bufferSize);
+    if (configuration.bufferInterval)
+        sensor_->setBufferInterval(configuration.bufferInterval);
+    if (configuration.downsampling)
+        sensor_->setDownsampling(true);
+
+    QDBusReply<void> reply = sensor_->start();
+    return reply.isValid();
+}
+
+void LoadSession::stop()
+{
+    sensor_->stop();
+}
+
+void LoadSession::received(quint64 timestamp)
+{
+    quint64 now = monotonicTime();
+    ++samples;
+    latencies.append(now > timestamp ? now - timestamp : 0);
+
+    // Samples of one frame arrive together, count the frame once
+    if (previousArrival_ && now != previousArrival_) {
+        double interval = now - previousArrival_;
+        ++intervals;
+        intervalSum += interval;
+        intervalSquareSum += interval * interval;
+    }
+    previousArrival_ = now;
+}
+
+void LoadSession::xyzAvailable(const XYZ& data)
+{
+    received(data.XYZData().timestamp_);
+}
+
+void LoadSession::xyzFrameAvailable(const QVector<XYZ>& frame)
+{
+    foreach (const XYZ& data, frame)
+        received(data.XYZData().timestamp_);
+}
+
+void LoadSession::magneticFieldAvailable(const MagneticField& data)
+{
+    received(data.timestamp());
+}
+
+void LoadSession::magneticFieldFrameAvailable(const QVector<MagneticField>& frame)
+{
+    foreach (const MagneticField& data, frame)
+        received(data.timestamp());
+}
+
+void LoadSession::compassAvailable(const Compass& data)
+{
+    received(data.data().timestamp_);
+}
+
+void LoadSession::unsignedAvailable(const Unsigned& data)
+{
+    received(data.UnsignedData().timestamp_);
+}
+
+ProcessUsage::ProcessUsage(int pid) :
+    pid_(pid),
+    startTicks_(0)
+{
+}
+
+qint64 ProcessUsage::cpuTicks() const
+{
+    QFile file(QString("/proc/%1/stat").arg(pid_));
+    if (!file.open(QIODevice::ReadOnly))
+        return -1;
+
+    // Fields after the command name, which may contain spaces
+    QByteArray line = file.readLine();
+    QList<QByteArray> fields = line.mid(line.lastIndexOf(')') + 2).split(' ');
+    if (fields.size() < 13)
+        return -1;
+    return fields.at(11).toLongLong() + fields.at(12).toLongLong();
+}
+
+void ProcessUsage::start()
+{
+    startTicks_ = cpuTicks();
+    timer_.start();
+}
+
+double ProcessUsage::cpu() const
+{
+    qint64 ticks = cpuTicks();
+    qint64 elapsed = timer_.elapsed();
+    if (ticks < 0 || startTicks_ < 0 || elapsed <= 0)
+        return -1;
+    return (ticks - startTicks_) * 100000.0 / sysconf(_SC_CLK_TCK) / elapsed;
+}
+
+int ProcessUsage::rss(bool peak) const
+{
+    QFile file(QString("/proc/%1/status").arg(pid_));
+    if (!file.open(QIODevice::ReadOnly))
+        return -1;
+
+    const char* key = peak ? "VmHWM:" : "VmRSS:";
+    QByteArray line;
+    while (!(line = file.readLine()).isEmpty()) {
+        if (line.startsWith(key))
+            return line.mid(strlen(key)).simplified().split(' ').at(0).toInt();
+    }
+    return -1;
+}
+
+LoadGenerator::LoadGenerator(const QList<LoadConfiguration>& configurations, int duration, int pid, bool concurrent) :
+    configurations_(configurations),
+    duration_(duration),
+    concurrent_(concurrent),
+    next_(0),
+    daemon_(pid)
+{
+}
+
+bool LoadGenerator::open(const LoadConfiguration& configuration)
+{
+    SensorManagerInterface& sm = SensorManagerInterface::instance();
+    QList<LoadSession*> sessions;
+
+    for (int i = 0; i < configuration.sessions; ++i) {
+        AbstractSensorChannelInterface* sensor = sm.interface(configuration.sensor);
+        if (!sensor || !sensor->isValid()) {
+            out << "Failed to open session " << i << " of " << configuration.spec << ": " << sm.errorString() << "\n";
+            delete sensor;
+            break;
+        }
+        LoadSession* session = new LoadSession(sensor, this);
+        sessions.append(session);
+        if (!session->start(configuration))
+            break;
+    }
+
+    running_.append(configuration);
+    sessions_.append(sessions);
+    return sessions.size() == configuration.sessions;
+}
+
+void LoadGenerator::run()
+{
+    if (next_ >= configurations_.size()) {
+        emit finished();
+        return;
+    }
+
+    if (concurrent_) {
+        while (next_ < configurations_.size())
+            open(configurations_.at(next_++));
+    } else {
+        open(configurations_.at(next_++));
+    }
+
+    daemon_.start();
+    QTimer::singleShot(duration_ * 1000, this, SLOT(measured()));
+}
+
+void LoadGenerator::measured()
+{
+    for (int i = 0; i < sessions_.size(); ++i) {
+        foreach (LoadSession* session, sessions_.at(i))
+            session->stop();
+    }
+
+    report();
+
+    for (int i = 0; i < sessions_.size(); ++i)
+        qDeleteAll(sessions_.at(i));
+    sessions_.clear();
+    running_.clear();
+
+    QTimer::singleShot(0, this, SLOT(run()));
+}
+
+void LoadGenerator::report()
+{
+    double cpu = daemon_.cpu();
+    int rss = daemon_.rss();
+    int peakRss = daemon_.rss(true);
+
+    for (int i = 0; i < running_.size(); ++i) {
+        const QList<LoadSession*>& sessions = sessions_.at(i);
+        QVector<quint32> latencies;
+        quint64 samples = 0;
+        quint64 intervals = 0;
+        double intervalSum = 0;
+        double intervalSquareSum = 0;
+        foreach (LoadSession* session, sessions) {
+            latencies += session->latencies;
+            samples += session->samples;
+            intervals += session->intervals;
+            intervalSum += session->intervalSum;
+            intervalSquareSum += session->intervalSquareSum;
+        }
+        qSort(latencies);
+
+        double rate = samples / (double)duration_;
+        double jitter = 0;
+        if (intervals > 1) {
+            double mean = intervalSum / intervals;
+            jitter = sqrt(qMax(0.0, intervalSquareSum / intervals - mean * mean));
+        }
+
+        out << "[" << running_.at(i).spec << "]\n";
+        out << "  sessions:     " << sessions.size() << "/" << running_.at(i).sessions << "\n";
+        out << "  rate:         " << rate << " samples/s total, "
+            << (sessions.isEmpty() ? 0 : rate / sessions.size()) << " per session\n";
+        if (!latencies.isEmpty()) {
+            int last = latencies.size() - 1;
+            out << "  latency (us): p50 " << latencies.at(last * 50 / 100)
+                << " p90 " << latencies.at(last * 90 / 100)
+                << " p99 " << latencies.at(last * 99 / 100)
+                << " max " << latencies.at(last) << "\n";
+        }
+        out << "  jitter (us):  " << jitter << "\n";
+    }
+    out << "  daemon:       cpu " << cpu << " %, rss " << rss << " kB, peak rss " << peakRss << " kB\n";
+    out.flush();
+}
+
+static int daemonPid()
+{
+    QProcess process;
+    process.start("pidof sensord");
+    process.waitForFinished(1000);
+    return atoi(process.readAllStandardOutput().constData());
+}
+
+static void usage()
+{
+    out << "Usage: sensorloadgenerator [-d seconds] [-p pid] [-c] configuration...\n"
+        << "  configuration: sensor[:sessions=N][:interval=ms][:buffersize=N]\n"
+        << "                 [:bufferinterval=ms][:downsampling=0|1]\n"
+        << "  -d  measurement time per run, default 10 s\n"
+        << "  -p  daemon PID, default from pidof sensord\n"
+        << "  -c  run all configurations concurrently instead of one by one\n";
+}
+
+int main(int argc, char** argv)
+{
+    QCoreApplication app(argc, argv);
+    QStringList args = app.arguments();
+    args.removeFirst();
+
+    int duration = 10;
+    int pid = 0;
+    bool concurrent = false;
+    QList<LoadConfiguration> configurations;
+    QStringList sensors;
+
+    while (!args.isEmpty()) {
+        QString arg = args.takeFirst();
+        if (arg == "-d" && !args.isEmpty()) {
+            duration = args.takeFirst().toInt();
+        } else if (arg == "-p" && !args.isEmpty()) {
+            pid = args.takeFirst().toInt();
+        } else if (arg == "-c") {
+            concurrent = true;
+        } else {
+            LoadConfiguration configuration;
+            if (!configuration.parse(arg)) {
+                usage();
+                return 1;
+            }
+            configurations.append(configuration);
+            if (!sensors.contains(configuration.sensor))
+                sensors.append(configuration.sensor);
+        }
+    }
+    if (configurations.isEmpty() || duration <= 0) {
+        usage();
+        return 1;
+    }
+
+    foreach (const QString& sensor, sensors) {
+        if (!registerInterface(sensor))
+            return 1;
+    }
+
+    if (!pid)
+        pid = daemonPid();
+    out << "Measuring sensord PID " << pid << " for " << duration << " s per run\n";
+
+    LoadGenerator generator(configurations, duration, pid, concurrent);
+    QObject::connect(&generator, SIGNAL(finished()), &app, SLOT(quit()));
+    QTimer::singleShot(0, &generator, SLOT(run()));
+
+    return app.exec();
+}
@@ -0,0 +1,174 @@
+/**
+   @file loadgenerator.h
+   @brief Multi-session client load generator
+
+   <p>
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef LOADGENERATOR_H
+#define LOADGENERATOR_H
+
+#include <QObject>
+#include <QList>
+#include <QVector>
+#include <QElapsedTimer>
+#include "abstractsensor_i.h"
+#include "datatypes/xyz.h"
+#include "datatypes/unsigned.h"
+#include "datatypes/magneticfield.h"
+#include "datatypes/compass.h"
+
+/**
+ * Sessions of one sensor sharing the same settings.
+ */
+struct LoadConfiguration
+{
+    LoadConfiguration();
+
+    /**
+     * Parse configuration of the form
+     * sensor[:sessions=N][:interval=ms][:buffersize=N][:bufferinterval=ms][:downsampling=0|1].
+     *
+     * @param spec Configuration string.
+     * @return was the string valid.
+     */
+    bool parse(const QString& spec);
+
+    QString      spec;           /**< configuration as given */
+    QString      sensor;         /**< sensor name */
+    int          sessions;       /**< number of sessions */
+    int          interval;       /**< interval in ms, 0 for default */
+    unsigned int bufferSize;     /**< buffer size, 0 for default */
+    unsigned int bufferInterval; /**< buffer interval in ms, 0 for default */
+    bool         downsampling;   /**< downsampling enabled */
+};
+
+/**
+ * One client session collecting delivery statistics.
+ */
+class LoadSession : public QObject
+{
+    Q_OBJECT;
+public:
+    LoadSession(AbstractSensorChannelInterface* sensor, QObject* parent = 0);
+    ~LoadSession();
+
+    /**
+     * Apply settings and start the session.
+     *
+     * @param configuration Session settings.
+     * @return was the session started.
+     */
+    bool start(const LoadConfiguration& configuration);
+
+    /**
+     * Stop the session.
+     */
+    void stop();
+
+    QVector<quint32> latencies; /**< end-to-end latencies in microseconds */
+    quint64 samples;            /**< delivered samples */
+    quint64 intervals;          /**< number of arrival intervals */
+    double intervalSum;         /**< sum of arrival intervals in microseconds */
+    double intervalSquareSum;   /**< sum of squared arrival intervals */
+
+public Q_SLOTS:
+    void xyzAvailable(const XYZ& data);
+    void xyzFrameAvailable(const QVector<XYZ>& frame);
+    void magneticFieldAvailable(const MagneticField& data);
+    void magneticFieldFrameAvailable(const QVector<MagneticField>& frame);
+    void compassAvailable(const Compass& data);
+    void unsignedAvailable(const Unsigned& data);
+
+private:
+    bool connectIfPresent(const char* signal, const char* slot);
+    void received(quint64 timestamp);
+
+    AbstractSensorChannelInterface* sensor_;
+    quint64 previousArrival_;
+};
+
+/**
+ * CPU and memory use of a process, from /proc.
+ */
+class ProcessUsage
+{
+public:
+    ProcessUsage(int pid);
+
+    /**
+     * Start a CPU measurement period.
+     */
+    void start();
+
+    /**
+     * CPU use since start().
+     *
+     * @return CPU use in percent of one core.
+     */
+    double cpu() const;
+
+    /**
+     * Resident set size.
+     *
+     * @param peak Return peak instead of current size.
+     * @return size in kB, -1 if not available.
+     */
+    int rss(bool peak = false) const;
+
+private:
+    qint64 cpuTicks() const;
+
+    int pid_;
+    qint64 startTicks_;
+    QElapsedTimer timer_;
+};
+
+/**
+ * Runs load configurations one after another, or all at once, and
+ * prints delivered rate, end-to-end latency percentiles, arrival
+ * jitter and daemon CPU and memory use for each.
+ */
+class LoadGenerator : public QObject
+{
+    Q_OBJECT;
+public:
+    LoadGenerator(const QList<LoadConfiguration>& configurations, int duration, int pid, bool concurrent);
+
+Q_SIGNALS:
+    void finished();
+
+public Q_SLOTS:
+    void run();
+
+private Q_SLOTS:
+    void measured();
+
+private:
+    bool open(const LoadConfiguration& configuration);
+    void report();
+
+    QList<LoadConfiguration> configurations_;
+    int duration_;
+    bool concurrent_;
+    int next_;
+    ProcessUsage daemon_;
+    QList<LoadConfiguration> running_;
+    QList<QList<LoadSession*> > sessions_;
+};
+
+#endif
@@ -0,0 +1,24 @@
+TEMPLATE = app
+TARGET = sensorloadgenerator
+QT += dbus network
+
+include( ../../common-install.pri)
+
+INCLUDEPATH += ../../../qt-api \
+               ../../../core \
+               ../../../include \
+               ../../..
+
+SOURCES += loadgenerator.cpp
+HEADERS += loadgenerator.h
+
+QMAKE_LIBDIR_FLAGS += -L../../../qt-api  \
+                      -L../../../datatypes \
+                      -L../../../core
+
+equals(QT_MAJOR_VERSION, 4):{
+    QMAKE_LIBDIR_FLAGS += -lsensordatatypes -lsensorclient
+}
+equals(QT_MAJOR_VERSION, 5):{
+    QMAKE_LIBDIR_FLAGS += -lsensordatatypes-qt5 -lsensorclient-qt5
+}
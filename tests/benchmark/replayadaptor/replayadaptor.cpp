@@ -0,0 +1,195 @@
+/**
+   @file replayadaptor.cpp
+   @brief Adaptor replaying recorded adaptor samples
+
+   <p>
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include "replayadaptor.h"
+#include "config.h"
+#include "logging.h"
+#include "datatypes/orientationdata.h"
+#include "datatypes/timedunsigned.h"
+#include "datatypes/tapdata.h"
+#include "datatypes/touchdata.h"
+#include "datatypes/utils.h"
+#include <unistd.h>
+
+/** Size of replayed ring buffers. */
+static const unsigned BUFFER_SIZE = 1024;
+
+/** Samples committed between reader wakeups when replaying at full speed. */
+static const unsigned WAKE_BATCH = 32;
+
+/** Longest single sleep, keeps stopping responsive. */
+static const quint64 MAX_SLEEP = 100000;
+
+template <class TYPE>
+static ReplayStream* createStream(int sampleSize)
+{
+    if ((size_t)sampleSize != sizeof(TYPE))
+        return NULL;
+    return new TypedReplayStream<TYPE>(BUFFER_SIZE);
+}
+
+static ReplayStream* createStream(int type, int sampleSize)
+{
+    switch (type) {
+    case SampleRecorder::TimedXyzSample:
+        return createStream<TimedXyzData>(sampleSize);
+    case SampleRecorder::TimedUnsignedSample:
+        return createStream<TimedUnsigned>(sampleSize);
+    case SampleRecorder::CalibratedMagneticFieldSample:
+        return createStream<CalibratedMagneticFieldData>(sampleSize);
+    case SampleRecorder::CompassSample:
+        return createStream<CompassData>(sampleSize);
+    case SampleRecorder::ProximitySample:
+        return createStream<ProximityData>(sampleSize);
+    case SampleRecorder::TapSample:
+        return createStream<TapData>(sampleSize);
+    case SampleRecorder::TouchSample:
+        return createStream<TouchData>(sampleSize);
+    default:
+        return NULL;
+    }
+}
+
+ReplayAdaptor::ReplayAdaptor(const QString& id) :
+    DeviceAdaptor(id),
+    stream_(NULL),
+    streamId_(-1),
+    speed_(Config::configuration()->value<double>("replay/speed", 1.0))
+{
+    t = new ReplayAdaptorThread(this);
+
+    QString path = Config::configuration()->value<QString>("replay/file", "");
+    if (!recording_.open(path)) {
+        setValid(false);
+        return;
+    }
+
+    const QVector<SampleRecording::Stream>& streams = recording_.streams();
+    for (int i = 0; i < streams.size(); ++i) {
+        if (streams.at(i).name.startsWith(id + "/")) {
+            streamId_ = i;
+            break;
+        }
+    }
+    if (streamId_ < 0) {
+        sensordLogW() << "No stream for " << id << " in " << path;
+        setValid(false);
+        return;
+    }
+
+    const SampleRecording::Stream& stream = streams.at(streamId_);
+    stream_ = createStream(stream.type, stream.sampleSize);
+    if (!stream_) {
+        sensordLogW() << "Stream " << stream.name << " of type " << stream.type << " can not be replayed";
+        setValid(false);
+        return;
+    }
+
+    QString sensorName = stream.name.mid(id.size() + 1);
+    setAdaptedSensor(sensorName, "Replayed " + stream.name, stream_->buffer());
+    sensordLogD() << "Replaying " << stream.name << " from " << path << " at speed " << speed_;
+}
+
+ReplayAdaptor::~ReplayAdaptor()
+{
+    stopSensor();
+    delete t;
+    delete stream_;
+}
+
+bool ReplayAdaptor::startAdaptor()
+{
+    return isValid();
+}
+
+void ReplayAdaptor::stopAdaptor()
+{
+}
+
+bool ReplayAdaptor::startSensor()
+{
+    if (!stream_)
+        return false;
+    if (t->isRunning())
+        return true;
+    t->running = true;
+    t->start();
+    return true;
+}
+
+void ReplayAdaptor::stopSensor()
+{
+    t->running = false;
+    t->wait();
+}
+
+void ReplayAdaptor::init()
+{
+}
+
+void ReplayAdaptor::replay(volatile bool& running)
+{
+    SampleRecording::Record record;
+    quint64 start = Utils::getTimeStamp();
+    quint64 first = 0;
+    bool started = false;
+    unsigned pending = 0;
+
+    recording_.rewind();
+    while (running && recording_.next(record)) {
+        if (record.stream != streamId_)
+            continue;
+        if (!started) {
+            first = record.timestamp;
+            started = true;
+        }
+
+        if (speed_ > 0) {
+            quint64 due = start + (quint64)((record.timestamp - first) / speed_);
+            quint64 now = Utils::getTimeStamp();
+            if (due > now && pending) {
+                stream_->wakeUpReaders();
+                pending = 0;
+            }
+            while (running && due > now) {
+                usleep(qMin(due - now, MAX_SLEEP));
+                now = Utils::getTimeStamp();
+            }
+        }
+
+        stream_->push(record.data, (qint64)(start - first));
+        if (++pending >= WAKE_BATCH) {
+            stream_->wakeUpReaders();
+            pending = 0;
+        }
+    }
+    if (pending)
+        stream_->wakeUpReaders();
+}
+
+ReplayAdaptorThread::ReplayAdaptorThread(ReplayAdaptor *parent) : running(false), parent_(parent)
+{
+}
+
+void ReplayAdaptorThread::run()
+{
+    parent_->replay(running);
+}
@@ -0,0 +1,144 @@
+/**
+   @file replayadaptor.h
+   @brief Adaptor replaying recorded adaptor samples
+
+   <p>
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef REPLAYADAPTOR_H
+#define REPLAYADAPTOR_H
+
+#include "deviceadaptor.h"
+#include "deviceadaptorringbuffer.h"
+#include "samplerecorder.h"
+#include <QThread>
+#include <string.h>
+
+class ReplayAdaptor;
+
+class ReplayAdaptorThread : public QThread
+{
+    Q_OBJECT;
+public:
+    ReplayAdaptorThread(ReplayAdaptor *parent);
+    void run();
+    volatile bool running;
+
+private:
+    ReplayAdaptor *parent_;
+};
+
+/**
+ * Ring buffer of one replayed stream.
+ */
+class ReplayStream
+{
+public:
+    virtual ~ReplayStream() {}
+
+    /**
+     * Buffer exposed as adapted sensor.
+     *
+     * @return buffer.
+     */
+    virtual RingBufferBase* buffer() = 0;
+
+    /**
+     * Commit recorded sample to the buffer.
+     *
+     * @param sample Recorded sample.
+     * @param shift Offset added to the sample timestamp.
+     */
+    virtual void push(const void* sample, qint64 shift) = 0;
+
+    /**
+     * Wake up buffer readers.
+     */
+    virtual void wakeUpReaders() = 0;
+};
+
+template <class TYPE>
+class TypedReplayStream : public ReplayStream
+{
+public:
+    TypedReplayStream(unsigned size) : buffer_(size) {}
+
+    RingBufferBase* buffer() { return &buffer_; }
+
+    void push(const void* sample, qint64 shift)
+    {
+        TYPE* slot = buffer_.nextSlot();
+        memcpy(slot, sample, sizeof(TYPE));
+        slot->timestamp_ += shift;
+        buffer_.commit();
+    }
+
+    void wakeUpReaders() { buffer_.wakeUpReaders(); }
+
+private:
+    DeviceAdaptorRingBuffer<TYPE> buffer_;
+};
+
+/**
+ * @brief Adaptor feeding samples from a #SampleRecorder file.
+ *
+ * The adaptor replays the stream recorded for the adaptor of the same
+ * name, so it can stand in for any adaptor present in the recording.
+ * The recording is read from \c replay/file. \c replay/speed sets the
+ * pace: 1 is real time, larger values replay faster, and 0 replays
+ * as fast as the chain consumes samples. Sample timestamps keep their
+ * recorded spacing at any speed, shifted to the start of the replay,
+ * so chain output does not depend on the pace.
+ */
+class ReplayAdaptor : public DeviceAdaptor
+{
+    Q_OBJECT;
+public:
+    static DeviceAdaptor* factoryMethod(const QString& id)
+    {
+        return new ReplayAdaptor(id);
+    }
+
+    ~ReplayAdaptor();
+
+    bool startAdaptor();
+    void stopAdaptor();
+
+    bool startSensor();
+    void stopSensor();
+
+    void init();
+
+    /**
+     * Replay the recorded stream once.
+     *
+     * @param running Cleared to stop the replay.
+     */
+    void replay(volatile bool& running);
+
+protected:
+    ReplayAdaptor(const QString& id);
+
+private:
+    ReplayAdaptorThread* t;
+    SampleRecording recording_;
+    ReplayStream* stream_;
+    int streamId_;
+    double speed_;
+};
+
+#endif
@@ -0,0 +1,26 @@
+TEMPLATE     = lib
+CONFIG      += plugin
+
+TARGET       = replayadaptor
+
+include( ../../../common-config.pri )
+
+HEADERS += replayadaptor.h \
+           replayadaptorplugin.h
+
+SOURCES += replayadaptor.cpp \
+           replayadaptorplugin.cpp
+
+SENSORFW_INCLUDEPATHS = ../../../include \
+                        ../../../core \
+                        ../../../datatypes \
+                        ../../../filters \
+                        ../../..
+
+DEPENDPATH  += $$SENSORFW_INCLUDEPATHS
+INCLUDEPATH += $$SENSORFW_INCLUDEPATHS
+
+include(../../../common-install.pri)
+target.path = $$PLUGINPATH/testing
+
+INSTALLS += target
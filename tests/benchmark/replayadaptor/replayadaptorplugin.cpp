@@ -0,0 +1,50 @@
+/**
+   @file replayadaptorplugin.cpp
+   @brief Plugin for ReplayAdaptor
+
+   <p>
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include "replayadaptorplugin.h"
+#include "replayadaptor.h"
+#include "sensormanager.h"
+#include "config.h"
+#include "logging.h"
+#include <QSet>
+
+void ReplayAdaptorPlugin::Register(class Loader&)
+{
+    QString path = Config::configuration()->value<QString>("replay/file", "");
+    SampleRecording recording;
+    if (!recording.open(path))
+        return;
+
+    QSet<QString> adaptors;
+    foreach (const SampleRecording::Stream& stream, recording.streams()) {
+        QString adaptor = stream.name.section('/', 0, 0);
+        if (adaptor.isEmpty() || adaptors.contains(adaptor))
+            continue;
+        adaptors.insert(adaptor);
+
+        sensordLogD() << "registering replay adaptor " << adaptor;
+        SensorManager::instance().registerDeviceAdaptor<ReplayAdaptor>(adaptor);
+    }
+}
+
+#if QT_VERSION < QT_VERSION_CHECK(5, 0, 0)
+Q_EXPORT_PLUGIN2(replayadaptor, ReplayAdaptorPlugin)
+#endif
@@ -0,0 +1,42 @@
+/**
+   @file replayadaptorplugin.h
+   @brief Plugin for ReplayAdaptor
+
+   <p>
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef REPLAYADAPTORPLUGIN_H
+#define REPLAYADAPTORPLUGIN_H
+
+#include "plugin.h"
+
+/**
+ * Registers a #ReplayAdaptor under the name of every adaptor found in
+ * the recording. Map adaptor names to this plugin in the configuration,
+ * for example \c plugins/accelerometeradaptor = \c replayadaptor.
+ */
+class ReplayAdaptorPlugin : public Plugin
+{
+    Q_OBJECT
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+    Q_PLUGIN_METADATA(IID "com.nokia.SensorService.Plugin/1.0")
+#endif
+private:
+    void Register(class Loader& l);
+};
+
+#endif
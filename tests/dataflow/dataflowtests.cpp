@@ -28,6 +28,8 @@
 #include <QtDebug>
 #include <QTest>
 #include <QVariant>
+#include <QThread>
+#include <QElapsedTimer>
 
 #include <typeinfo>
 #include "sensormanager.h"
@@ -38,12 +40,129 @@
 #include "dataflowtests.h"
 #include "loader.h"
 #include "plugin.h"
+#include "ringbuffer.h"
+#include "source.h"
+#include "sink.h"
+#include "chainexecutor.h"
+#include "nodebase.h"
 #include <accelerometeradaptor/accelerometeradaptor.h>
 #include <accelerometerchain/accelerometerchain.h>
 #include <coordinatealignfilter/coordinatealignfilter.h>
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <unistd.h>
+
+/**
+ * RingBuffer with public write access.
+ */
+class OverrunBuffer : public RingBuffer<int>
+{
+public:
+    OverrunBuffer(unsigned size) : RingBuffer<int>(size) {}
+
+    using RingBuffer<int>::write;
+};
+
+/**
+ * Reader which only reads when asked to, simulating a stalled consumer.
+ */
+class OverrunReader : public RingBufferReader<int>
+{
+public:
+    void pushNewData() {}
+
+    using RingBufferReader<int>::read;
+};
+
+/**
+ * Node owning an overrun buffer and a reader connected to it.
+ */
+class OverrunNode : public NodeBase
+{
+public:
+    OverrunNode() : NodeBase("overrunnode"), buffer(16)
+    {
+        connected = connectToBuffer(&buffer, &reader);
+    }
+
+    OverrunBuffer buffer;
+    OverrunReader reader;
+    bool          connected;
+};
+
+/** Wakeups of readers and sinks after they were disconnected. */
+static int lateCalls = 0;
+
+/**
+ * Reader draining the buffer on every wakeup.
+ */
+class ChurnReader : public RingBufferReader<int>
+{
+public:
+    ChurnReader() : samples(0), unjoined(false) {}
+
+    void pushNewData()
+    {
+        if (unjoined)
+            __atomic_fetch_add(&lateCalls, 1, __ATOMIC_RELAXED);
+        int out[16];
+        unsigned n;
+        while ((n = read(16, out)))
+            samples += n;
+    }
+
+    long samples;
+    bool unjoined;
+};
+
+/**
+ * Consumer counting collected samples.
+ */
+class ChurnConsumer : public Consumer
+{
+public:
+    ChurnConsumer() : sink(this, &ChurnConsumer::collect), samples(0), unjoined(false) {}
+
+    void collect(unsigned n, const int* values)
+    {
+        Q_UNUSED(values);
+        if (unjoined)
+            __atomic_fetch_add(&lateCalls, 1, __ATOMIC_RELAXED);
+        samples += n;
+    }
+
+    Sink<ChurnConsumer, int> sink;
+    long                     samples;
+    bool                     unjoined;
+};
+
+/**
+ * Thread streaming samples into a source at full rate.
+ */
+class StreamThread : public QThread
+{
+public:
+    StreamThread(Source<int>& source) : rounds(0), source_(source), stop_(0) {}
+
+    void stop() { __atomic_store_n(&stop_, 1, __ATOMIC_RELEASE); }
+
+    long rounds;
+
+protected:
+    void run()
+    {
+        int values[8] = { 0, 1, 2, 3, 4, 5, 6, 7 };
+        while (!__atomic_load_n(&stop_, __ATOMIC_ACQUIRE)) {
+            source_.propagate(8, values);
+            ++rounds;
+        }
+    }
+
+private:
+    Source<int>& source_;
+    int          stop_;
+};
 
 void DataFlowTest::initTestCase()
 {
@@ -188,6 +307,182 @@ void DataFlowTest::testChainSharing()
     sm.releaseChain("accelerometerchain");
     // check that does not exist
 }
+
+void DataFlowTest::testReaderOverrun()
+{
+    OverrunNode node;
+    QVERIFY(node.connected);
+
+    int values[100];
+    for (int i = 0; i < 100; ++i)
+        values[i] = i;
+
+    // Fits into the buffer, nothing lost.
+    node.buffer.write(10, values);
+    int out[100];
+    QCOMPARE(node.reader.read(100, out), 10u);
+    QCOMPARE(out[9], 9);
+    QCOMPARE(node.reader.lostSamples(), (quint64)0);
+
+    // Reader falls behind, continues from the oldest valid sample.
+    node.buffer.write(100, values);
+    QCOMPARE(node.reader.read(100, out), 16u);
+    QCOMPARE(out[0], 84);
+    QCOMPARE(out[15], 99);
+    QCOMPARE(node.reader.lostSamples(), (quint64)84);
+
+    // Small writes which together overrun are accounted the same way.
+    for (int i = 0; i < 5; ++i)
+        node.buffer.write(10, values);
+    QCOMPARE(node.reader.read(100, out), 16u);
+    QCOMPARE(out[0], 4);
+    QCOMPARE(node.reader.lostSamples(), (quint64)(84 + 34));
+
+    QCOMPARE(node.lostSamples(), (quint64)(84 + 34));
+    QCOMPARE(node.property("lostSamples").toULongLong(), (qulonglong)(84 + 34));
+}
+void DataFlowTest::testSubscriptionChurn()
+{
+    OverrunBuffer buffer(64);
+    Source<int> source;
+    QVERIFY(source.join(buffer.sink("sink")));
+
+    ChurnReader steadyReader;
+    QVERIFY(buffer.join(&steadyReader));
+    ChurnConsumer steadyConsumer;
+    QVERIFY(source.join(&steadyConsumer.sink));
+
+    StreamThread stream(source);
+    stream.start();
+
+    // Sessions come and go while the adaptor thread streams. Readers
+    // and sinks are destroyed right after disconnecting.
+    int cycles = 0;
+    QElapsedTimer timer;
+    timer.start();
+    while (timer.elapsed() < 2000) {
+        ChurnReader* reader = new ChurnReader();
+        ChurnConsumer* consumer = new ChurnConsumer();
+        QVERIFY(buffer.join(reader));
+        QVERIFY(source.join(&consumer->sink));
+        if (cycles % 16 == 0)
+            QThread::yieldCurrentThread();
+        QVERIFY(source.unjoin(&consumer->sink));
+        consumer->unjoined = true;
+        QVERIFY(buffer.unjoin(reader));
+        reader->unjoined = true;
+        delete consumer;
+        delete reader;
+        ++cycles;
+    }
+
+    stream.stop();
+    stream.wait();
+
+    qDebug() << "Join/unjoin cycles:" << cycles << "streamed rounds:" << stream.rounds;
+    QCOMPARE(__atomic_load_n(&lateCalls, __ATOMIC_RELAXED), 0);
+    QVERIFY(cycles > 0);
+    QVERIFY(stream.rounds > 0);
+    QCOMPARE(steadyConsumer.samples, stream.rounds * 8);
+    QCOMPARE(steadyReader.samples + (long)steadyReader.lostSamples(), stream.rounds * 8);
+}
+
+/**
+ * Consumer which is slow and remembers the thread it was called from.
+ */
+class SlowConsumer : public Consumer
+{
+public:
+    SlowConsumer() : sink(this, &SlowConsumer::collect), samples(0), thread(NULL) {}
+
+    void collect(unsigned n, const int* values)
+    {
+        Q_UNUSED(values);
+        usleep(200);
+        thread = QThread::currentThread();
+        __atomic_fetch_add(&samples, (long)n, __ATOMIC_RELEASE);
+    }
+
+    Sink<SlowConsumer, int> sink;
+    long                    samples;
+    QThread*                thread;
+};
+
+void DataFlowTest::testWorkerExecution()
+{
+    const int BATCHES = 200;
+
+    OverrunBuffer buffer(64);
+    BufferReader<int> reader(16);
+    SlowConsumer consumer;
+    QVERIFY(reader.source("source")->join(&consumer.sink));
+
+    ChainExecutor executor("testchain");
+    QVERIFY(reader.setExecutor(&executor));
+    QVERIFY(buffer.join(&reader));
+
+    // Writer is not held up by the slow consumer.
+    int values[4] = { 0, 1, 2, 3 };
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < BATCHES; ++i)
+        buffer.write(4, values);
+    qint64 writeNs = timer.nsecsElapsed();
+
+    ChainExecutor::Metrics metrics;
+    timer.restart();
+    // Metrics are updated after the sinks have been called.
+    do {
+        usleep(5000);
+        metrics = executor.metrics();
+    } while ((long)(metrics.samples + metrics.dropped) < BATCHES * 4 && timer.elapsed() < 5000);
+
+    QVERIFY(buffer.unjoin(&reader));
+    QVERIFY(reader.setExecutor(NULL));
+
+    qDebug() << "Write ns/batch:" << writeNs / BATCHES << "batches:" << metrics.batches
+             << "avg ns:" << (metrics.batches ? metrics.totalNs / metrics.batches : 0)
+             << "max depth:" << metrics.maxDepth << "dropped:" << metrics.dropped;
+    QCOMPARE(consumer.samples + (long)metrics.dropped, (long)BATCHES * 4);
+    QCOMPARE((long)metrics.samples, consumer.samples);
+    QVERIFY(metrics.batches > 0);
+    QVERIFY(metrics.maxDepth > 0);
+    QCOMPARE(metrics.depth, 0u);
+    QVERIFY(consumer.thread != QThread::currentThread());
+}
+
+void DataFlowTest::testWorkerPause()
+{
+    OverrunBuffer buffer(64);
+    BufferReader<int> reader(16);
+    SlowConsumer consumer;
+    QVERIFY(reader.source("source")->join(&consumer.sink));
+
+    ChainExecutor executor("testchain");
+    QVERIFY(reader.setExecutor(&executor));
+    QVERIFY(buffer.join(&reader));
+
+    int values[4] = { 0, 1, 2, 3 };
+    {
+        // Input is queued, but not processed while paused.
+        ChainExecutor::Pause pause(QList<ChainExecutor*>() << &executor << &executor);
+        buffer.write(4, values);
+        buffer.write(4, values);
+        usleep(20000);
+        QCOMPARE(__atomic_load_n(&consumer.samples, __ATOMIC_ACQUIRE), 0L);
+        QCOMPARE(executor.metrics().depth, 8u);
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    while (__atomic_load_n(&consumer.samples, __ATOMIC_ACQUIRE) < 8 && timer.elapsed() < 5000)
+        usleep(5000);
+
+    QVERIFY(buffer.unjoin(&reader));
+    QVERIFY(reader.setExecutor(NULL));
+    QCOMPARE(__atomic_load_n(&consumer.samples, __ATOMIC_ACQUIRE), 8L);
+}
+
 QList<QString> DataFlowTest::getKeys(const SensorManager &that)
 {
     return that.getAdaptorTypes();
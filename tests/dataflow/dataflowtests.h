@@ -45,6 +45,10 @@ private slots:
 
     void testAdaptorSharing();
     void testChainSharing();
+    void testReaderOverrun();
+    void testSubscriptionChurn();
+    void testWorkerExecution();
+    void testWorkerPause();
 
     void cleanup() {};
     void cleanupTestCase();
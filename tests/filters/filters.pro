@@ -11,14 +11,16 @@ HEADERS += filtertests.h \
     ../../filters/orientationinterpreter/orientationinterpreter.h \
     ../../filters/coordinatealignfilter/coordinatealignfilter.h \
     ../../filters/declinationfilter/declinationfilter.h \
-    ../../filters/rotationfilter/rotationfilter.h 
+    ../../filters/rotationfilter/rotationfilter.h \
+    ../../filters/downsamplefilter/downsamplefilter.h
 
     
 SOURCES += filtertests.cpp \
     ../../filters/orientationinterpreter/orientationinterpreter.cpp \
     ../../filters/coordinatealignfilter/coordinatealignfilter.cpp \
     ../../filters/declinationfilter/declinationfilter.cpp \
-    ../../filters/rotationfilter/rotationfilter.cpp
+    ../../filters/rotationfilter/rotationfilter.cpp \
+    ../../filters/downsamplefilter/downsamplefilter.cpp
 
 INCLUDEPATH += ../../include \
     ../../ \
@@ -26,6 +28,7 @@ INCLUDEPATH += ../../include \
     ../../filters/coordinatealignfilter \
     ../../filters/declinationfilter \
     ../../filters/rotationfilter \
+    ../../filters/downsamplefilter \
     ../../core \
     ../../datatypes
     
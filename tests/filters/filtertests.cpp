@@ -38,6 +38,7 @@
 #include "orientationinterpreter.h"
 #include "declinationfilter.h"
 #include "rotationfilter.h"
+#include "downsamplefilter.h"
 #include "filtertests.h"
 #include "config.h"
 #include <QSettings>
@@ -47,6 +48,24 @@ void FilterApiTest::initTestCase()
     Config::loadConfig(CONFIG_FILE_PATH, CONFIG_DIR_PATH);
 }
 
+/**
+ * Filters get samples in batches of varying size. Every filter test is
+ * run with single samples and with batches, results must not differ.
+ */
+static void addBatchSizes()
+{
+    QTest::addColumn<int>("batch");
+
+    QTest::newRow("single") << 1;
+    QTest::newRow("batch of 3") << 3;
+    QTest::newRow("batch of 8") << 8;
+}
+
+void FilterApiTest::testCoordinateAlignFilter_data()
+{
+    addBatchSizes();
+}
+
 /**
  * This should be simple enough to be valid if one transformation matrix works.
  * Could add larger/smaller coefficients and another matrix if really pedant.
@@ -116,9 +135,9 @@ void FilterApiTest::testCoordinateAlignFilter()
     marshallingBin.start();
     filterBin.start();
 
-    // Start sends data once, so start from index 1.
-    for (int i = 0; i < numInputs; ++i) {
-        dummyAdaptor.pushNewData();
+    QFETCH(int, batch);
+    for (int i = 0; i < numInputs; i += batch) {
+        dummyAdaptor.pushBatch(batch);
     }
 
     filterBin.stop();
@@ -129,6 +148,11 @@ void FilterApiTest::testCoordinateAlignFilter()
     delete coordAlignFilter;
 }
 
+void FilterApiTest::testTopEdgeInterpretationFilter_data()
+{
+    addBatchSizes();
+}
+
 // TODO: Add some state changes to verify functionality of threshold setting.
 void FilterApiTest::testTopEdgeInterpretationFilter()
 {
@@ -180,9 +204,9 @@ void FilterApiTest::testTopEdgeInterpretationFilter()
     marshallingBin.start();
     filterBin.start();
 
-    // Start sends data once, so start from index 1.
-    for (int i = 0; i < numInputs; ++i) {
-        dummyAdaptor.pushNewData();
+    QFETCH(int, batch);
+    for (int i = 0; i < numInputs; i += batch) {
+        dummyAdaptor.pushBatch(batch);
     }
 
     filterBin.stop();
@@ -193,6 +217,11 @@ void FilterApiTest::testTopEdgeInterpretationFilter()
     delete topEdgeInterpreterFilter;
 }
 
+void FilterApiTest::testFaceInterpretationFilter_data()
+{
+    addBatchSizes();
+}
+
 void FilterApiTest::testFaceInterpretationFilter()
 {
     // Input data to feed to the filter
@@ -239,8 +268,9 @@ void FilterApiTest::testFaceInterpretationFilter()
     marshallingBin.start();
     filterBin.start();
 
-    for (int j=1; j < numInputs; j++){
-        dummyAdaptor.pushNewData();
+    QFETCH(int, batch);
+    for (int j=1; j < numInputs; j += batch){
+        dummyAdaptor.pushBatch(qMin(batch, numInputs - j));
     }
 
     filterBin.stop();
@@ -251,6 +281,11 @@ void FilterApiTest::testFaceInterpretationFilter()
     delete faceInterpreterFilter;
 }
 
+void FilterApiTest::testOrientationInterpretationFilter_data()
+{
+    addBatchSizes();
+}
+
 void FilterApiTest::testOrientationInterpretationFilter()
 {
     // Input data to feed to the filter
@@ -305,9 +340,9 @@ void FilterApiTest::testOrientationInterpretationFilter()
     marshallingBin.start();
     filterBin.start();
 
-    // Start sends data once, so start from index 1.
-    for (int i = 0; i < numInputs; ++i) {
-        dummyAdaptor.pushNewData();
+    QFETCH(int, batch);
+    for (int i = 0; i < numInputs; i += batch) {
+        dummyAdaptor.pushBatch(batch);
     }
 
     filterBin.stop();
@@ -318,6 +353,11 @@ void FilterApiTest::testOrientationInterpretationFilter()
     delete orientationInterpreterFilter;
 }
 
+void FilterApiTest::testDeclinationFilter_data()
+{
+    addBatchSizes();
+}
+
 void FilterApiTest::testDeclinationFilter()
 {
     // Input data to feed to the filter
@@ -384,9 +424,9 @@ void FilterApiTest::testDeclinationFilter()
     marshallingBin.start();
     filterBin.start();
 
-    // Start sends data once, so start from index 1.
-    for (int i = 0; i < numInputs; ++i) {
-        dummyAdaptor.pushNewData();
+    QFETCH(int, batch);
+    for (int i = 0; i < numInputs; i += batch) {
+        dummyAdaptor.pushBatch(batch);
     }
 
     filterBin.stop();
@@ -399,6 +439,11 @@ void FilterApiTest::testDeclinationFilter()
     confFile.setValue("declination",0);
 }
 
+void FilterApiTest::testRotationFilter_data()
+{
+    addBatchSizes();
+}
+
 void FilterApiTest::testRotationFilter()
 {
     TimedXyzData inputData[] = {
@@ -475,9 +520,9 @@ void FilterApiTest::testRotationFilter()
     marshallingBin.start();
     filterBin.start();
 
-    // Start sends data once, so start from index 1.
-    for (int i = 0; i < numInputs; ++i) {
-        dummyAdaptor.pushNewData();
+    QFETCH(int, batch);
+    for (int i = 0; i < numInputs; i += batch) {
+        dummyAdaptor.pushBatch(batch);
     }
 
     filterBin.stop();
@@ -488,4 +533,74 @@ void FilterApiTest::testRotationFilter()
     delete rotationFilter;
 }
 
+void FilterApiTest::testDownsampleFilter_data()
+{
+    addBatchSizes();
+}
+
+void FilterApiTest::testDownsampleFilter()
+{
+    TimedXyzData inputData[] = {
+        TimedXyzData(1000,   0,   0,   0),
+        TimedXyzData(2000,   2,   4,   6),
+        TimedXyzData(3000,  10,  10,  10),
+        TimedXyzData(4000,  20,  30,  40),
+        TimedXyzData(5000,  -1,  -2,  -3),
+        TimedXyzData(6000,  -3,  -4,  -5),
+        TimedXyzData(7000, 100, 200, 300),
+        TimedXyzData(8000, 300, 200, 100)
+    };
+
+    // Every two samples are averaged into one
+    TimedXyzData expectedResult[] = {
+        TimedXyzData(2000,   1,   2,   3),
+        TimedXyzData(4000,  15,  20,  25),
+        TimedXyzData(6000,  -2,  -3,  -4),
+        TimedXyzData(8000, 200, 200, 200)
+    };
+
+    int numInputs = (sizeof(inputData) / sizeof(TimedXyzData));
+    int numOutputs = (sizeof(expectedResult) / sizeof(TimedXyzData));
+
+    DummyAdaptor<TimedXyzData> dummyAdaptor;
+    DummyDataEmitter<TimedXyzData> dbusEmitter;
+
+    FilterBase* downsampleFilter = DownsampleFilter::factoryMethod();
+    ((DownsampleFilter*)downsampleFilter)->setProperty("bufferSize", 2);
+    ((DownsampleFilter*)downsampleFilter)->setProperty("timeout", 1000);
+    RingBuffer<TimedXyzData> outputBuffer(10);
+
+    Bin filterBin;
+    filterBin.add(&dummyAdaptor, "adapter");
+    filterBin.add(downsampleFilter, "downsamplefilter");
+    filterBin.add(&outputBuffer, "buffer");
+
+    filterBin.join("adapter", "source", "downsamplefilter", "sink");
+    filterBin.join("downsamplefilter", "source", "buffer", "sink");
+
+    Bin marshallingBin;
+    marshallingBin.add(&dbusEmitter, "testdataemitter");
+    outputBuffer.join(&dbusEmitter);
+
+    /* Setup data */
+    dummyAdaptor.setTestData(numInputs, inputData);
+    dbusEmitter.setExpectedData(numOutputs, expectedResult);
+
+    marshallingBin.start();
+    filterBin.start();
+
+    QFETCH(int, batch);
+    for (int i = 0; i < numInputs; i += batch) {
+        dummyAdaptor.pushBatch(batch);
+    }
+
+    filterBin.stop();
+    marshallingBin.stop();
+
+    QCOMPARE (dummyAdaptor.getDataCount(), numInputs);
+    QCOMPARE (dbusEmitter.numSamplesReceived(), numOutputs);
+
+    delete downsampleFilter;
+}
+
 QTEST_MAIN(FilterApiTest)
@@ -45,12 +45,20 @@ private slots:
     void initTestCase();
     void init() {}
 
+    void testCoordinateAlignFilter_data();
     void testCoordinateAlignFilter();
+    void testTopEdgeInterpretationFilter_data();
     void testTopEdgeInterpretationFilter();
+    void testFaceInterpretationFilter_data();
     void testFaceInterpretationFilter();
+    void testDeclinationFilter_data();
     void testDeclinationFilter();
+    void testOrientationInterpretationFilter_data();
     void testOrientationInterpretationFilter();
+    void testRotationFilter_data();
     void testRotationFilter();
+    void testDownsampleFilter_data();
+    void testDownsampleFilter();
 
     void cleanup() {}
     void cleanupTestCase() {}
@@ -59,7 +67,8 @@ private slots:
 /**
  * DummyAdaptor is a Pusher that can be used to push data into a filter for testing.
  * Input data is given as an array. Calling \c pushNewData() will propagate the next
- * value in the array into adaptor output.
+ * value in the array into adaptor output, \c pushBatch() propagates several values
+ * with a single call.
  *
  * @todo For some reason we can only feed in 10 samples.. Anything beyond that will
  *       get compared to wrong expected output..
@@ -90,6 +99,19 @@ public:
         ++counter_;
     }
 
+    void pushBatch(int count) {
+        count = qMin(count, datacount_ - index_);
+        if (count <= 0) {
+            QVERIFY2(false, "Test function error: out of input data.");
+            return;
+        }
+
+        source_.propagate(count, &(data_[index_]));
+
+        index_ += count;
+        counter_ += count;
+    }
+
     int getDataCount() { return counter_; }
 
 private: